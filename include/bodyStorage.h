@@ -0,0 +1,313 @@
+#pragma once
+
+#include "collider.h"
+#include "integrate.h"
+#include "renderCache.h"
+
+#include <algorithm>
+#include <cassert>
+#include <compare>
+#include <cstdint>
+#include <raylib.h>
+#include <span>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace phys
+{
+
+using std::vector;
+
+/**
+ * @brief Dense index of a body in a BodyStorage. Only valid until the next
+ *        body is removed, which may move another body into its place.
+ */
+using BodyID = uint32_t;
+
+/**
+ * @brief Stable reference to a body in a BodyStorage. Each slot's generation
+ *        is bumped when its body is removed, so handles to removed bodies
+ *        are detected instead of silently referring to whatever reuses it.
+ */
+struct BodyHandle
+{
+	static constexpr uint32_t INVALID_SLOT{UINT32_MAX};
+
+	uint32_t slot{INVALID_SLOT};
+	uint32_t generation{0};
+
+	auto operator<=>(const BodyHandle&) const = default;
+};
+
+/** @brief Two bodies, conventionally with the lower handle first. */
+using BodyPair = std::pair<BodyHandle, BodyHandle>;
+struct BodyPairHash
+{
+	auto operator()(const BodyPair& pair) const -> size_t;
+};
+
+/** @brief How the simulation treats a body. */
+enum class BodyType : uint8_t
+{
+	/**
+	 * @brief Never moves on its own, and never collides with other static
+	 *        bodies. Its world transform and bounds are baked when it is
+	 *        placed, so it costs nothing per step.
+	 */
+	STATIC,
+	/** @brief Moved by its velocity alone, unaffected by gravity. */
+	KINEMATIC,
+	/** @brief Fully simulated, needs a positive inverse mass. */
+	DYNAMIC,
+};
+
+/**
+ * @brief Bit flags stored per body.
+ * @var BODY_SENSOR Only reports overlaps. The narrowphase stops at the first
+ *      proof of overlap and makes no contact, so nothing pushes it apart.
+ */
+constexpr uint8_t BODY_SENSOR{1U << 0U};
+
+/** @brief The layer bodies start on. */
+constexpr uint32_t LAYER_DEFAULT{1U << 0U};
+constexpr uint32_t LAYER_ALL{UINT32_MAX};
+
+/**
+ * @brief Which layers a body is on, and which layers it collides with. Two
+ *        bodies are only paired if each one's mask has a layer of the other.
+ */
+struct CollisionFilter
+{
+	uint32_t layer{LAYER_DEFAULT};
+	uint32_t mask{LAYER_ALL};
+
+	auto Accepts(const CollisionFilter other) const -> bool
+	{
+		return (this->layer & other.mask) != 0
+			   && (other.layer & this->mask) != 0;
+	}
+};
+
+/**
+ * @brief A coarser collider that replaces an object's own collider once it
+ *        is at least minDistance away from the viewer.
+ */
+struct ColliderLOD
+{
+	float minDistance;
+	Collider collider;
+};
+
+/** @brief The RenderCache resources a body is drawn with. */
+struct BodyRender
+{
+	MeshID mesh;
+	MaterialID material;
+
+	auto operator==(const BodyRender&) const -> bool = default;
+};
+
+/**
+ * @brief Owns the data of every body as a structure of arrays.
+ *
+ * Data the simulation reads every step lives in a BodyState, with one dense
+ * array per component, so each physics pass is a linear sweep over only the
+ * fields it needs. Render resources and collider LODs are cold, and sit in
+ * arrays of their own indexed the same way.
+ *
+ * Live bodies are always packed at the front of every array, kinematic and
+ * dynamic ones first and static ones after them, so each step only sweeps
+ * the bodies that can move. Removing one moves the last body of its range
+ * into its place, and a table of slots maps each BodyHandle to wherever its
+ * body currently is, so both are O(1).
+ *
+ * Static bodies are kept out of the sweep and prune altogether. Instead
+ * they sit in a bounding volume tree that is built once and never refit,
+ * and only rebuilt after a static body is added, moved or removed.
+ *
+ * @note Bodies are accessed one at a time through PhysObject handles.
+ */
+class BodyStorage
+{
+	public:
+	/**
+	 * @brief Adds a static body drawn with the default material. Use
+	 *        SetType() to make it move.
+	 * @param mesh A reference to a mesh in the RenderCache, which the body
+	 *        takes over, or NO_MESH for a body that is never drawn.
+	 * @returns A handle that stays valid until the body is removed.
+	 */
+	auto Add(const Vector3 pos, const MeshID mesh, const Collider& col)
+		-> BodyHandle;
+	/**
+	 * @brief Removes a body and releases its mesh. Materials are shared, so
+	 *        its material is left loaded.
+	 * @returns false if the handle was already stale.
+	 */
+	auto Remove(const BodyHandle handle) -> bool;
+	/** @returns true if handle refers to a body that has not been removed. */
+	auto IsValid(const BodyHandle handle) const -> bool
+	{
+		return handle.slot < this->slots.size()
+			   && this->slots[handle.slot].generation == handle.generation;
+	}
+	/**
+	 * @brief Changes a body's type, which moves it to the other end of the
+	 *        arrays when it starts or stops being static. Making a body
+	 *        dynamic gives it an inverse mass of 1 if it had none.
+	 */
+	void SetType(const BodyHandle handle, const BodyType type);
+	auto GetType(const BodyHandle handle) const -> BodyType;
+	/** @returns The number of kinematic and dynamic bodies. */
+	auto MovingCount() const -> uint32_t { return this->movingCount; }
+	/** @brief Allocates room for count bodies up front. */
+	void Reserve(const uint32_t count);
+	auto Size() const -> uint32_t { return this->state.Size(); }
+	/** @returns The handle of every live body, in storage order. */
+	auto GetHandles() const -> std::span<const BodyHandle>
+	{
+		return this->handles;
+	}
+
+	/**
+	 * @brief Steps every kinematic and dynamic body forward and refreshes
+	 *        their world space bounds. Static bodies are not touched.
+	 */
+	void Integrate(const float deltaTime, const Vector3 gravity);
+	/**
+	 * @brief Velocities are scaled by exp(-damping * deltaTime) every step.
+	 */
+	void SetDamping(const float linear, const float angular)
+	{
+		this->linearDamping = linear;
+		this->angularDamping = angular;
+	}
+	/** @brief Defaults to the fastest kernel the CPU supports. */
+	void SetIntegrateKernel(const IntegrateKernel newKernel)
+	{
+		this->kernel = newKernel;
+	}
+	/**
+	 * @brief Stops the broadphase pairing two bodies, whatever their
+	 *        filters say. Dropped automatically when either is removed.
+	 */
+	void SetPairIgnored(BodyHandle handle1, BodyHandle handle2,
+						const bool ignored);
+	auto IsPairIgnored(const BodyHandle handle1,
+					   const BodyHandle handle2) const -> bool
+	{
+		return !this->ignoredPairs.empty()
+			   && this->ignoredPairs.contains(std::minmax(handle1, handle2));
+	}
+	/**
+	 * @brief Broadphase over the bounds from the last Integrate(). Sorts the
+	 *        moving bodies along x and sweeps for overlapping intervals, then
+	 *        looks each of them up in the static tree. Two static bodies are
+	 *        never paired. Pairs whose CollisionFilters reject each other are
+	 *        dropped before their bounds are even compared, followed by
+	 *        ignored pairs.
+	 * @param out Receives pairs of overlapping bodies, lower handle first.
+	 */
+	void GetOverlappingPairs(vector<BodyPair>& out) const;
+	/** @brief Records the bounds from the last Integrate() as DEBUG_AABBS. */
+	void DebugDrawBounds() const;
+	/**
+	 * @brief Draws every body with a mesh. Bodies sharing a mesh and an
+	 *        instanced material are drawn together in a single call.
+	 */
+	void Draw() const;
+	/** @returns The number of draw calls the last Draw() made. */
+	auto GetDrawCalls() const -> uint32_t { return this->drawCalls; }
+
+	friend class PhysObject;
+	friend class ContactSolver;
+
+	private:
+	/** @brief Index of a free slot, or of the body in a used one. */
+	struct BodySlot
+	{
+		uint32_t index;
+		uint32_t generation;
+	};
+
+	auto GetIndex(const BodyHandle handle) const -> BodyID
+	{
+		assert(this->IsValid(handle));
+		return this->slots[handle.slot].index;
+	}
+	auto GetTransformM(const BodyID id) const -> const Matrix&;
+	auto GetInverseTransformM(const BodyID id) const -> const Matrix&;
+	auto ActiveCollider(const BodyID id) const -> const Collider&
+	{
+		const uint32_t lod{this->activeLODs[id]};
+		return lod == 0 ? this->colliders[id]
+						: this->colliderLODs[id][lod - 1].collider;
+	}
+	/** @brief Caches the body space bounds of the active collider. */
+	void UpdateLocalBounds(const BodyID id);
+	void InvalidateMatrices(const BodyID id)
+	{
+		this->state.matrixFlags[id] = WORLD_DIRTY | INVERSE_DIRTY;
+		if (id >= this->movingCount)
+		{
+			this->BakeStatic(id);
+		}
+	}
+	/**
+	 * @brief Builds a static body's matrices and bounds now, as nothing
+	 *        will refresh them later, and schedules a static tree rebuild.
+	 */
+	void BakeStatic(const BodyID id);
+	/** @brief Exchanges two bodies in every array, keeping their slots. */
+	void SwapBodies(const BodyID a, const BodyID b);
+	/** @brief Rebuilds the static tree if a static body has changed. */
+	void UpdateStaticTree() const;
+
+	// Hot data, touched by every simulation step
+	BodyState state;
+	vector<Collider> colliders;
+	/** @brief 0 for a body's own collider, otherwise colliderLODs + 1. */
+	vector<uint32_t> activeLODs;
+	/** @brief BODY_SENSOR and friends. */
+	vector<uint8_t> flags;
+	vector<CollisionFilter> filters;
+	/** @brief Built from the pose lazily, when the flags say it is stale. */
+	mutable vector<Matrix> worlds;
+	mutable vector<Matrix> inverseWorlds;
+
+	/** @brief Bodies before this index are kinematic or dynamic. */
+	uint32_t movingCount{0};
+
+	// Handle bookkeeping
+	/** @brief The handle of the body at each index. */
+	vector<BodyHandle> handles;
+	vector<BodySlot> slots;
+	/** @brief Head of the free slots, linked through BodySlot::index. */
+	uint32_t freeSlot{BodyHandle::INVALID_SLOT};
+	/** @brief Pairs never reported by the broadphase, lower handle first. */
+	std::unordered_set<BodyPair, BodyPairHash> ignoredPairs;
+
+	/**
+	 * @brief Tree over the bounds of the static bodies. Leaves hold slots,
+	 *        which unlike indices survive bodies being moved around.
+	 */
+	mutable vector<BoundsNode> staticTree;
+	mutable bool staticTreeDirty{false};
+
+	// Cold data
+	/** @brief Each body's LODs, sorted by increasing distance. */
+	vector<vector<ColliderLOD>> colliderLODs;
+	vector<BodyRender> renders;
+	/** @brief Draw() scratch, kept to avoid reallocating every frame. */
+	mutable vector<BodyID> drawOrder;
+	/** @brief Transforms of one instanced draw call, back to back. */
+	mutable vector<Matrix> instanceTransforms;
+	mutable uint32_t drawCalls{0};
+
+	float linearDamping{0.0f};
+	float angularDamping{0.0f};
+	IntegrateKernel kernel{GetBestKernel()};
+};
+
+} //namespace phys
@@ -2,10 +2,16 @@
 
 #include "halfEdge.h"
 
+#include <array>
 #include <concepts>
 #include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <optional>
 #include <raylib.h>
 #include <raymath.h>
+#include <span>
+#include <utility>
 #include <variant>
 #include <vector>
 #ifndef NDEBUG
@@ -22,8 +28,21 @@ using std::ostream;
 
 class HullCollider;
 class CompoundCollider;
+class SphereCollider;
+class CapsuleCollider;
+class BoxCollider;
+class TriangleMeshCollider;
+class HeightfieldCollider;
+class ColliderCache;
+class HullRegistry;
+struct HullView;
+struct MeshView;
+struct HeightfieldView;
 
-using Collider = std::variant<HullCollider, CompoundCollider>;
+using Collider
+	= std::variant<HullCollider, CompoundCollider, SphereCollider,
+				   CapsuleCollider, BoxCollider, TriangleMeshCollider,
+				   HeightfieldCollider>;
 using Vector3Tuple = std::tuple<Vector3, Vector3, Vector3>;
 
 struct HitObj;
@@ -54,6 +73,43 @@ struct EdgeHit
 	Vector3 direction2{};
 	Vector3 normal{};
 };
+/**
+ * @brief Result of a closed form test between two primitives. The normal
+ *        points from the first collider towards the second.
+ */
+struct ContactHit
+{
+	static constexpr uint32_t MAX_POINTS{4};
+
+	Vector3 normal{};
+	float penetration{};
+	/** @brief The deepest point of contact. */
+	Vector3 point{};
+	/**
+	 * @brief The contact manifold for face contacts, the first pointCount
+	 *        are used. Empty when point is the only contact.
+	 */
+	std::array<Vector3, MAX_POINTS> points{};
+	uint32_t pointCount{0};
+};
+
+/** @brief Node of the bounding volume tree over a compound's children. */
+struct BoundsNode
+{
+	BoundingBox bounds;
+	/**
+	 * @brief Index of the left child node, with the right one after it. For
+	 *        leaves, the index of the child collider instead.
+	 */
+	uint32_t first;
+	bool isLeaf;
+};
+/**
+ * @brief Fills the node at rootID with the subtree over the boxes in ids,
+ *        appending the nodes below it to tree. Leaves store the id.
+ */
+void BuildBoundsTree(std::span<uint32_t> ids, const vector<BoundingBox>& boxes,
+					 const uint32_t rootID, vector<BoundsNode>& tree);
 
 auto GetClosestPoints(const EdgeHit hit) -> std::pair<Vector3, Vector3>;
 
@@ -63,13 +119,15 @@ auto GetClosestPoints(const EdgeHit hit) -> std::pair<Vector3, Vector3>;
  */
 template <typename T>
 concept isCollider
-	= requires(const T col, const Matrix mat, vector<Collider>& arr,
-			   const Vector3 vec, vector<Vector3> nors, Color color) {
+	= requires(const T col, const Matrix mat, std::pmr::vector<Collider>& arr,
+			   const Vector3 vec, std::pmr::vector<Vector3>& nors,
+			   Color color) {
 		  { col.GetOrigin() } -> std::same_as<Vector3>;
 		  { col.GetTransformed(mat, arr) } -> std::same_as<void>;
 		  { col.GetNormals(nors) } -> std::same_as<void>;
 		  // { col.GetProjection(vec) } -> std::same_as<Range>;
 		  { col.GetSupportPoint(vec) } -> std::same_as<Vector3>;
+		  { col.GetBounds() } -> std::same_as<BoundingBox>;
 		  { col.DebugDraw(mat, color) } -> std::same_as<void>;
 	  };
 
@@ -83,8 +141,33 @@ class CompoundCollider //: public Collider
 	CompoundCollider(const vector<Collider>& cols);
 
 	auto GetOrigin() const -> Vector3 { return this->origin; }
-	void GetTransformed(const Matrix trans, vector<Collider>& out) const;
-	void GetNormals(vector<Vector3>& out) const;
+	void GetTransformed(const Matrix trans,
+						std::pmr::vector<Collider>& out) const;
+	void GetNormals(std::pmr::vector<Vector3>& out) const;
+	/** @returns The axis aligned box enclosing every child collider. */
+	auto GetBounds() const -> BoundingBox { return this->bounds; }
+	auto GetColliders() const -> const vector<Collider>&
+	{
+		return this->colliders;
+	}
+	/**
+	 * @brief Finds the children whose bounds overlap box.
+	 * @param out Receives indices into GetColliders(). Its allocator also
+	 *        backs the traversal's scratch memory.
+	 */
+	void GetOverlaps(const BoundingBox& box,
+					 std::pmr::vector<uint32_t>& out) const;
+	/**
+	 * @brief Descends both compounds' trees at the same time to find the
+	 *        pairs of children whose bounds overlap.
+	 * @param trans Transform from other's space into this compound's space.
+	 * @param out Receives pairs of indices into this compound's and other's
+	 *        GetColliders(). Its allocator also backs the traversal's
+	 *        scratch memory.
+	 */
+	void GetOverlaps(
+		const CompoundCollider& other, const Matrix& trans,
+		std::pmr::vector<std::pair<uint32_t, uint32_t>>& out) const;
 
 	static auto GetSupportPoint(const Vector3 axis) -> Vector3; // override;
 
@@ -96,64 +179,577 @@ class CompoundCollider //: public Collider
 	void DebugDraw(const Matrix& transform,
 				   const Color& col) const; // override;
 
+	friend class ColliderCache;
+	friend class HullRegistry;
+
 	private:
 	vector<Collider> colliders;
+	/** @brief Built once on construction, the root is the first node. */
+	vector<BoundsNode> tree;
 	Vector3 origin{0.0f, 0.0f, 0.0f};
+	BoundingBox bounds{};
 };
 static_assert(isCollider<CompoundCollider>);
 
-/** @brief Convex Hull collider */
+/**
+ * @brief The cooked half-edge structure of a convex hull. Never changed once
+ *        built, so any number of HullColliders can share one.
+ *
+ * @note The half-edge records point into the arrays beside them, so geometry
+ *       is pinned where it was built and only ever handled by pointer.
+ */
+struct HullGeometry
+{
+	vector<HE::HEdge> edges;
+	vector<HE::HVertex> vertices;
+	vector<HE::HFace> faces;
+	vector<Vector3> edgeDirs;
+	Vector3 origin{0.0f, 0.0f, 0.0f};
+	BoundingBox bounds{};
+
+	HullGeometry() = default;
+	/** @brief Deep copy, with the half-edge links pointed at the copy. */
+	HullGeometry(const HullGeometry& copy);
+	HullGeometry(HullGeometry&&) = delete;
+	~HullGeometry() = default;
+
+	auto operator=(const HullGeometry&) -> HullGeometry& = delete;
+	auto operator=(HullGeometry&&) -> HullGeometry& = delete;
+
+	void UpdateBounds();
+};
+
+/**
+ * @brief Convex Hull collider
+ *
+ * The hull's geometry is immutable and reference counted, so copying a
+ * collider only shares it. Bodies intern their hulls through the
+ * HullRegistry as they are added, so identical shapes built separately end
+ * up sharing too, and memory grows with unique shapes rather than instances.
+ */
 class HullCollider
 {
 	public:
 	HullCollider(const vector<HE::HVertex>& verts,
 				 const vector<HE::FaceInit>& faces,
 				 const Vector3 origin = Vector3Zero());
-	HullCollider(const HullCollider& copy);
-	HullCollider(HullCollider&&) = delete;
+	/**
+	 * @brief Copies a cooked hull straight out of a ColliderCache, skipping
+	 *        the half-edge twin search.
+	 */
+	explicit HullCollider(const HullView& view);
+	HullCollider(const HullCollider&) = default;
+	HullCollider(HullCollider&&) = default;
 	~HullCollider() = default;
 
 	auto operator=(const HullCollider&) -> HullCollider& = default;
-	auto operator=(HullCollider&&) -> HullCollider& = delete;
+	auto operator=(HullCollider&&) -> HullCollider& = default;
 
-	auto GetOrigin() const -> Vector3 { return this->origin; }
-	void GetTransformed(const Matrix trans, vector<Collider>& out) const;
-	void GetNormals(vector<Vector3>& out) const;
+	auto GetOrigin() const -> Vector3 { return this->geometry->origin; }
+	void GetTransformed(const Matrix trans,
+						std::pmr::vector<Collider>& out) const;
+	void GetNormals(std::pmr::vector<Vector3>& out) const;
 	auto GetProjection(const Vector3 nor) const -> Range;
-
-	/** @brief Apply a transformation matrix to the Collider. */
-	auto operator*(const Matrix& mat) -> HullCollider;
+	auto GetBounds() const -> BoundingBox { return this->geometry->bounds; }
 
 	auto GetSupportPoint(const Vector3 axis) const -> Vector3;
 	auto GetSupportPoints(const Vector3 axis, const Vector3 dir) const
 		-> std::pair<Vector3, Vector3>;
 	auto GetFace(const uint32_t i) const -> const HE::HFace&
 	{
-		return faces[i];
+		return this->geometry->faces[i];
+	}
+	auto FaceCount() const -> uint64_t
+	{
+		return this->geometry->faces.size();
+	}
+	auto GetEdgeDirs() const -> const vector<Vector3>&
+	{
+		return this->geometry->edgeDirs;
+	}
+	/** @returns The shared geometry, identical hulls return the same one. */
+	auto GetGeometry() const -> const std::shared_ptr<const HullGeometry>&
+	{
+		return this->geometry;
 	}
-	auto FaceCount() const -> uint64_t { return this->faces.size(); }
 
-	friend auto GetEdgeCrosses(const HullCollider& col1,
-							   const HullCollider& col2)
-		-> vector<Vector3Tuple>;
+	/**
+	 * @param out Receives each pair of edge directions that are not
+	 *        parallel, followed by their normalised cross product.
+	 */
+	friend void GetEdgeCrosses(const HullCollider& col1,
+							   const HullCollider& col2,
+							   std::pmr::vector<Vector3Tuple>& out);
 
 	void DebugDraw(const Matrix& transform, const Color& col) const;
 	void DebugDrawEdge(const uint64_t index) const;
 
-	friend auto CheckFaceNors(Collider colA, Collider colB) -> FaceHit;
-	friend auto CheckEdgeNors(Collider colA, Collider colB) -> EdgeHit;
+	friend auto CheckFaceNors(const HullCollider& hull1,
+							  const HullCollider& hull2) -> FaceHit;
+	friend auto CheckEdgeNors(const HullCollider& hull1,
+							  const HullCollider& hull2) -> EdgeHit;
+	friend class ColliderCache;
+	friend class HullRegistry;
 
 	private:
-	vector<HE::HEdge> edges;
-	vector<HE::HVertex> vertices;
-	vector<HE::HFace> faces;
-	vector<Vector3> edgeDirs;
-	Vector3 origin{0.0f, 0.0f, 0.0f};
+	/** @brief Wraps geometry as is, without interning it. */
+	explicit HullCollider(std::shared_ptr<const HullGeometry> geometry) :
+		geometry(std::move(geometry))
+	{ }
+
+	std::shared_ptr<const HullGeometry> geometry;
 };
 static_assert(isCollider<HullCollider>);
 
+/** @brief Sphere collider with a closed form support function. */
+class SphereCollider
+{
+	public:
+	SphereCollider(const Vector3 centre, const float radius);
+
+	auto GetOrigin() const -> Vector3 { return this->centre; }
+	auto GetRadius() const -> float { return this->radius; }
+	/**
+	 * @note Non-uniform scales can't be represented, the largest axis scale
+	 *       is applied to the radius instead.
+	 */
+	void GetTransformed(const Matrix trans,
+						std::pmr::vector<Collider>& out) const;
+	/** @brief Spheres have no face normals to add. */
+	static void GetNormals(std::pmr::vector<Vector3>& /*out*/) { }
+	auto GetSupportPoint(const Vector3 axis) const -> Vector3;
+	auto GetBounds() const -> BoundingBox;
+
+	void DebugDraw(const Matrix& transform, const Color& col) const;
+
+	private:
+	Vector3 centre;
+	float radius;
+};
+static_assert(isCollider<SphereCollider>);
+
+/**
+ * @brief Capsule collider, the set of points within radius of the segment
+ *        from start to end.
+ */
+class CapsuleCollider
+{
+	public:
+	CapsuleCollider(const Vector3 start, const Vector3 end, const float radius);
+
+	auto GetOrigin() const -> Vector3
+	{
+		return (this->start + this->end) * 0.5f;
+	}
+	auto GetStart() const -> Vector3 { return this->start; }
+	auto GetEnd() const -> Vector3 { return this->end; }
+	auto GetRadius() const -> float { return this->radius; }
+	/**
+	 * @note Non-uniform scales can't be represented, the largest axis scale
+	 *       is applied to the radius instead.
+	 */
+	void GetTransformed(const Matrix trans,
+						std::pmr::vector<Collider>& out) const;
+	/** @brief Capsules have no face normals to add. */
+	static void GetNormals(std::pmr::vector<Vector3>& /*out*/) { }
+	auto GetSupportPoint(const Vector3 axis) const -> Vector3;
+	auto GetBounds() const -> BoundingBox;
+
+	void DebugDraw(const Matrix& transform, const Color& col) const;
+
+	private:
+	Vector3 start;
+	Vector3 end;
+	float radius;
+};
+static_assert(isCollider<CapsuleCollider>);
+
+/**
+ * @brief Oriented box collider. Unlike a box shaped HullCollider it needs no
+ *        half-edge data, and box pairs are tested with at most 15 axes.
+ */
+class BoxCollider
+{
+	public:
+	/**
+	 * @param axes The box's local x, y and z axes, which must be orthonormal.
+	 * @param halfExtents Half the box's size along each of axes.
+	 */
+	BoxCollider(const Vector3 centre, const std::array<Vector3, 3>& axes,
+				const Vector3 halfExtents);
+
+	auto GetOrigin() const -> Vector3 { return this->centre; }
+	auto GetAxes() const -> const std::array<Vector3, 3>& { return this->axes; }
+	auto GetHalfExtents() const -> Vector3 { return this->halfExtents; }
+	void GetTransformed(const Matrix trans,
+						std::pmr::vector<Collider>& out) const;
+	void GetNormals(std::pmr::vector<Vector3>& out) const;
+	auto GetSupportPoint(const Vector3 axis) const -> Vector3;
+	auto GetBounds() const -> BoundingBox;
+
+	void DebugDraw(const Matrix& transform, const Color& col) const;
+
+	private:
+	Vector3 centre;
+	std::array<Vector3, 3> axes;
+	Vector3 halfExtents;
+};
+static_assert(isCollider<BoxCollider>);
+
+/**
+ * @brief Set in MeshTriangle::activeFeatures for each edge that is convex,
+ *        edge i running from verts[i] to the next vertex.
+ */
+constexpr uint8_t MESH_EDGE_0{1U << 0U};
+constexpr uint8_t MESH_EDGE_1{1U << 1U};
+constexpr uint8_t MESH_EDGE_2{1U << 2U};
+/** @brief Set for each vertex touching a convex edge of any triangle. */
+constexpr uint8_t MESH_VERTEX_0{1U << 3U};
+constexpr uint8_t MESH_VERTEX_1{1U << 4U};
+constexpr uint8_t MESH_VERTEX_2{1U << 5U};
+
+/** @brief One triangle of a TriangleMeshCollider, in the collider's space. */
+struct MeshTriangle
+{
+	std::array<Vector3, 3> verts;
+	/** @brief Unit normal of the front face, wound counter-clockwise. */
+	Vector3 normal;
+	/**
+	 * @brief MESH_EDGE_* and MESH_VERTEX_* bits. An edge is active if it is
+	 *        on the mesh's boundary or folds away from the front face. Flat
+	 *        and concave edges shared with a neighbour are internal, as are
+	 *        vertices only they touch, and never push anything off the
+	 *        surface.
+	 */
+	uint8_t activeFeatures;
+
+	auto GetOrigin() const -> Vector3
+	{
+		return (this->verts[0] + this->verts[1] + this->verts[2]) / 3.0f;
+	}
+	void GetNormals(std::pmr::vector<Vector3>& out) const
+	{
+		out.push_back(this->normal);
+	}
+	auto GetSupportPoint(const Vector3 axis) const -> Vector3;
+};
+
+/** @brief Vertex indices of a triangle, stored the same way when cooked. */
+struct TriangleIndices
+{
+	std::array<uint32_t, 3> verts;
+	/** @brief See MeshTriangle::activeFeatures. */
+	uint32_t activeFeatures;
+};
+
+/**
+ * @brief Node of a triangle mesh's bounding volume tree. The bounds are
+ *        quantised to 16 bits per axis across the whole mesh's bounds,
+ *        rounded outwards, so a node fits in 16 bytes.
+ */
+struct QuantisedNode
+{
+	static constexpr uint32_t COUNT_BITS{3};
+	static constexpr uint32_t COUNT_MASK{(1U << COUNT_BITS) - 1};
+
+	std::array<uint16_t, 3> min;
+	std::array<uint16_t, 3> max;
+	/**
+	 * @brief The low COUNT_BITS are a leaf's triangle count, 0 for inner
+	 *        nodes. The rest are the leaf's first triangle, or the index of
+	 *        an inner node's right child, its left child being the next node.
+	 */
+	uint32_t data;
+
+	auto IsLeaf() const -> bool { return (this->data & COUNT_MASK) != 0; }
+	auto Count() const -> uint32_t { return this->data & COUNT_MASK; }
+	auto Index() const -> uint32_t { return this->data >> COUNT_BITS; }
+};
+static_assert(sizeof(QuantisedNode) == 16);
+
+/**
+ * @brief The cooked triangles of a TriangleMeshCollider. Never changed once
+ *        built, so any number of colliders can share one.
+ */
+struct TriangleMeshGeometry
+{
+	/** @brief Triangles per leaf, which must fit in COUNT_BITS. */
+	static constexpr uint32_t MAX_LEAF_TRIANGLES{4};
+
+	vector<Vector3> vertices;
+	/** @brief Ordered so the triangles of every leaf are contiguous. */
+	vector<TriangleIndices> triangles;
+	/** @brief Depth first, the root is the first node. */
+	vector<QuantisedNode> nodes;
+	BoundingBox bounds{};
+
+	/** @returns box in node space, rounded outwards and clamped. */
+	auto Quantise(const BoundingBox& box) const -> QuantisedNode;
+	auto Dequantise(const QuantisedNode& node) const -> BoundingBox;
+	/** @brief Sorts the triangles into leaves and builds nodes over them. */
+	void BuildTree();
+	/**
+	 * @brief Works out which edges are convex, finding each triangle's
+	 *        neighbours through their shared vertex indices, and which
+	 *        vertices touch them.
+	 */
+	void FindActiveFeatures();
+};
+
+/**
+ * @brief Concave collider made of an indexed triangle soup, meant for static
+ *        level geometry.
+ *
+ * Queries descend a quantised tree, so they cost about the logarithm of the
+ * triangle count. The triangles are shared like hull geometry, and the
+ * collider only carries a transform of its own, so transforming one is O(1)
+ * and the triangles are only moved as queries reach them.
+ *
+ * @note Only convex shapes are tested against meshes, two meshes never
+ *       collide. Triangles are two sided, but edges are only judged convex
+ *       or not from the front.
+ */
+class TriangleMeshCollider
+{
+	public:
+	/**
+	 * @param vertices Positions shared between triangles.
+	 * @param indices Three indices into vertices per triangle. Triangles
+	 *        only find their neighbours through shared indices, so weld
+	 *        duplicated vertices first.
+	 */
+	TriangleMeshCollider(std::span<const Vector3> vertices,
+						 std::span<const uint32_t> indices);
+	/** @brief Copies a cooked mesh out of a ColliderCache, tree and all. */
+	explicit TriangleMeshCollider(const MeshView& view);
+
+	auto GetOrigin() const -> Vector3;
+	void GetTransformed(const Matrix trans,
+						std::pmr::vector<Collider>& out) const;
+	/** @brief Triangles are tested one by one, each with its own normal. */
+	static void GetNormals(std::pmr::vector<Vector3>& /*out*/) { }
+	/** @brief Support point of the mesh's convex hull, O(vertices). */
+	auto GetSupportPoint(const Vector3 axis) const -> Vector3;
+	auto GetBounds() const -> BoundingBox;
+	auto TriangleCount() const -> uint32_t
+	{
+		return static_cast<uint32_t>(this->geometry->triangles.size());
+	}
+	auto GetTriangle(const uint32_t i) const -> MeshTriangle;
+	/**
+	 * @brief Finds the triangles whose bounds overlap box, given in the
+	 *        collider's space.
+	 * @param out Receives triangle indices. Its allocator also backs the
+	 *        traversal's scratch memory.
+	 */
+	void GetOverlaps(const BoundingBox& box,
+					 std::pmr::vector<uint32_t>& out) const;
+	/**
+	 * @returns The distance along the ray to the first front face it hits.
+	 *          Back faces are not hit, like the inside of a hull.
+	 */
+	auto Raycast(const Ray ray) const -> std::optional<float>;
+	auto GetGeometry() const
+		-> const std::shared_ptr<const TriangleMeshGeometry>&
+	{
+		return this->geometry;
+	}
+	auto GetTransform() const -> const Matrix& { return this->transform; }
+
+	void DebugDraw(const Matrix& transform, const Color& col) const;
+
+	private:
+	std::shared_ptr<const TriangleMeshGeometry> geometry;
+	/** @brief From the geometry's space into the collider's. */
+	Matrix transform{MatrixIdentity()};
+	/** @brief Inverted whenever transform is set, so queries need not. */
+	Matrix inverseTransform{MatrixIdentity()};
+};
+static_assert(isCollider<TriangleMeshCollider>);
+
+/** @brief The range of heights under one tile of a heightfield. */
+struct HeightRange
+{
+	uint16_t min;
+	uint16_t max;
+};
+
+/** @brief Where one level of a heightfield's tile hierarchy is stored. */
+struct HeightTileLevel
+{
+	uint32_t offset;
+	uint32_t width;
+	uint32_t depth;
+};
+
+/**
+ * @brief The samples of a HeightfieldCollider, shared like the triangles of
+ *        a mesh.
+ */
+struct HeightfieldGeometry
+{
+	/** @brief Tiles of the finest level are this many cells across, log 2. */
+	static constexpr uint32_t TILE_SHIFT{2};
+
+	/** @brief Samples along x. */
+	uint32_t width{0};
+	/** @brief Samples along z. */
+	uint32_t depth{0};
+	/** @brief Distance between samples along x and z. */
+	Vector2 cellSize{1.0f, 1.0f};
+	/** @brief Height of sample 0, and how much each step above it adds. */
+	float heightOffset{0.0f};
+	float heightScale{1.0f};
+	/** @brief Row by row, x varying fastest. */
+	vector<uint16_t> samples;
+	/**
+	 * @brief Height ranges of every level of tiles, finest first. Each tile
+	 *        covers two by two tiles of the level below it, and the last
+	 *        level is a single tile over the whole heightfield.
+	 */
+	vector<HeightRange> tiles;
+	vector<HeightTileLevel> levels;
+
+	auto CellsX() const -> uint32_t { return this->width - 1; }
+	auto CellsZ() const -> uint32_t { return this->depth - 1; }
+	auto GetSample(const uint32_t x, const uint32_t z) const -> uint16_t
+	{
+		return this->samples[(z * this->width) + x];
+	}
+	/** @returns The position of sample (x, z) in the heightfield's space. */
+	auto GetPoint(const uint32_t x, const uint32_t z) const -> Vector3
+	{
+		return {static_cast<float>(x) * this->cellSize.x,
+				this->heightOffset
+					+ (static_cast<float>(this->GetSample(x, z))
+					   * this->heightScale),
+				static_cast<float>(z) * this->cellSize.y};
+	}
+	auto GetTile(const uint32_t level, const uint32_t x, const uint32_t z) const
+		-> const HeightRange&
+	{
+		const HeightTileLevel& info{this->levels[level]};
+		return this->tiles[info.offset + (z * info.width) + x];
+	}
+	auto GetBounds() const -> BoundingBox;
+	/** @brief Works out the size and place of each level of tiles. */
+	void FindLevels();
+	/** @brief Fills in the tiles from the samples, once the levels exist. */
+	void BuildTiles();
+};
+
+/**
+ * @brief Terrain collider over a regular grid of 16 bit heights, with its
+ *        corner at the origin and rows running along z.
+ *
+ * Each cell is split into two triangles along the diagonal from (x + 1, z)
+ * to (x, z + 1), the same way as GenMeshHeightmap(). Triangles are made as
+ * queries reach them, and queries only reach the cells under them, skipping
+ * whole tiles whose height range they miss. A sample takes 2 bytes against
+ * the dozens a triangle mesh needs per vertex, so large terrain stays cheap.
+ *
+ * Triangle i is half i % 2 of cell i / 2, and cells are numbered row by row.
+ *
+ * @note Like meshes, heightfields only collide with convex shapes, and are
+ *       only hit by rays from above.
+ */
+class HeightfieldCollider
+{
+	public:
+	/**
+	 * @param heights width * depth heights, row by row with x varying
+	 *        fastest, quantised to 16 bits across their range.
+	 * @param cellSize Distance between samples along x and z.
+	 * @note A grid under 2 samples a side, or with the wrong number of
+	 *       heights, is replaced by one flat cell at height 0.
+	 */
+	HeightfieldCollider(std::span<const float> heights, const uint32_t width,
+						const uint32_t depth, const Vector2 cellSize);
+	/** @brief Copies a cooked heightfield out of a ColliderCache. */
+	explicit HeightfieldCollider(const HeightfieldView& view);
+
+	auto GetOrigin() const -> Vector3;
+	void GetTransformed(const Matrix trans,
+						std::pmr::vector<Collider>& out) const;
+	/** @brief Triangles are tested one by one, each with its own normal. */
+	static void GetNormals(std::pmr::vector<Vector3>& /*out*/) { }
+	/** @brief Support point of the heightfield's bounds, not its surface. */
+	auto GetSupportPoint(const Vector3 axis) const -> Vector3;
+	auto GetBounds() const -> BoundingBox;
+	auto TriangleCount() const -> uint32_t
+	{
+		return this->geometry->CellsX() * this->geometry->CellsZ() * 2;
+	}
+	/**
+	 * @brief Makes triangle i, judging its edges and vertices from the cells
+	 *        around it.
+	 */
+	auto GetTriangle(const uint32_t i) const -> MeshTriangle;
+	/** @brief Finds the triangles in cells under box, as for meshes. */
+	void GetOverlaps(const BoundingBox& box,
+					 std::pmr::vector<uint32_t>& out) const;
+	/** @returns The distance along the ray to the first triangle it hits. */
+	auto Raycast(const Ray ray) const -> std::optional<float>;
+	auto GetGeometry() const
+		-> const std::shared_ptr<const HeightfieldGeometry>&
+	{
+		return this->geometry;
+	}
+	auto GetTransform() const -> const Matrix& { return this->transform; }
+
+	void DebugDraw(const Matrix& transform, const Color& col) const;
+
+	private:
+	std::shared_ptr<const HeightfieldGeometry> geometry;
+	/** @brief From the geometry's space into the collider's. */
+	Matrix transform{MatrixIdentity()};
+	/** @brief Inverted whenever transform is set, so queries need not. */
+	Matrix inverseTransform{MatrixIdentity()};
+};
+static_assert(isCollider<HeightfieldCollider>);
+
 /** @brief Creates a rectangular convex hull collider centered on (0, 0, 0). */
 auto CreateBoxCollider(Matrix transform) -> Collider;
+/**
+ * @brief Creates an oriented box collider from the unit cube centred on
+ *        (0, 0, 0), the same way as CreateBoxCollider().
+ */
+auto CreateOBBCollider(Matrix transform) -> Collider;
+/**
+ * @brief Creates a TriangleMeshCollider from a raylib mesh, indexed or not.
+ *        Vertices at the same position are welded so triangles find their
+ *        neighbours.
+ */
+auto CreateMeshCollider(const Mesh& mesh) -> Collider;
+/**
+ * @brief Creates a HeightfieldCollider matching GenMeshHeightmap() for the
+ *        same image and size, so the two line up. Images under 2 pixels a
+ *        side make no cells, and get a thin box over the same ground.
+ */
+auto CreateHeightfieldCollider(const Image& heightmap, const Vector3 size)
+	-> Collider;
+/** @returns The smallest box enclosing both a and b. */
+auto MergeBounds(const BoundingBox& a, const BoundingBox& b) -> BoundingBox;
+/** @returns The axis aligned box enclosing box after it is transformed. */
+auto TransformBounds(const BoundingBox& box, const Matrix& trans)
+	-> BoundingBox;
+
+/**
+ * @returns The leaves the midphase works on, which are a compound's children
+ *          or any other collider by itself.
+ */
+auto GetLeaves(const Collider& col) -> std::span<const Collider>;
+/**
+ * @brief Midphase between two colliders. Finds the pairs of leaves whose
+ *        bounds overlap, using the trees of any compounds to skip the rest.
+ * @param trans Transform from colB's space into colA's space.
+ * @param inverse The inverse of trans, which callers usually have cached.
+ * @param out Receives pairs of indices into GetLeaves(colA) and
+ *        GetLeaves(colB).
+ */
+void GetLeafOverlaps(const Collider& colA, const Collider& colB,
+					 const Matrix& trans, const Matrix& inverse,
+					 std::pmr::vector<std::pair<uint32_t, uint32_t>>& out);
 
 #ifndef NDEBUG
 auto operator<<(ostream& ostr, HitObj hit) -> ostream&;
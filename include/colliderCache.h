@@ -0,0 +1,171 @@
+#pragma once
+
+#include "collider.h"
+#include "mappedFile.h"
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <raylib.h>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+namespace phys
+{
+
+/** @brief Identifies a cooked collider file. Spells "PHCC" in memory. */
+constexpr uint32_t COOKED_MAGIC{0x43434850};
+/** @brief Reads back as a different value on a foreign-endian machine. */
+constexpr uint32_t COOKED_ENDIAN_TAG{0x01020304};
+/** @brief Bump whenever the layout of any Cooked* record changes. */
+constexpr uint32_t COOKED_VERSION{5};
+
+struct CookedVertex
+{
+	float x;
+	float y;
+	float z;
+	uint32_t edgeID;
+};
+struct CookedEdge
+{
+	uint32_t vertID;
+	uint32_t twinID;
+	uint32_t nextID;
+	uint32_t faceID;
+};
+struct CookedFace
+{
+	Vector3 normal;
+	uint32_t edgeID;
+};
+static_assert(std::is_trivially_copyable_v<CookedVertex>
+			  && std::is_trivially_copyable_v<CookedEdge>
+			  && std::is_trivially_copyable_v<CookedFace>);
+
+/**
+ * @brief Zero-copy view of a cooked hull. The spans point directly into the
+ *        mapped file and are only valid while the owning ColliderCache lives.
+ */
+struct HullView
+{
+	std::span<const CookedVertex> vertices;
+	std::span<const CookedEdge> edges;
+	std::span<const CookedFace> faces;
+	std::span<const Vector3> edgeDirs;
+	Vector3 origin;
+	BoundingBox bounds;
+};
+
+/**
+ * @brief Zero-copy view of a cooked triangle mesh, tree included. Valid for
+ *        as long as the owning ColliderCache, like HullView.
+ */
+struct MeshView
+{
+	std::span<const Vector3> vertices;
+	std::span<const TriangleIndices> triangles;
+	std::span<const QuantisedNode> nodes;
+	BoundingBox bounds;
+	Matrix transform;
+};
+/**
+ * @brief Zero-copy view of a cooked heightfield, along with its tiles. Valid
+ *        for as long as the owning ColliderCache.
+ */
+struct HeightfieldView
+{
+	uint32_t width;
+	uint32_t depth;
+	Vector2 cellSize;
+	float heightOffset;
+	float heightScale;
+	std::span<const uint16_t> samples;
+	std::span<const HeightRange> tiles;
+	Matrix transform;
+};
+static_assert(std::is_trivially_copyable_v<TriangleIndices>
+			  && std::is_trivially_copyable_v<QuantisedNode>
+			  && std::is_trivially_copyable_v<HeightRange>);
+
+/**
+ * @brief Read-only, memory mapped file of cooked colliders.
+ *
+ * Hulls are stored with their half-edge connectivity already resolved, and
+ * triangle meshes and heightfields with their trees already built, so loading
+ * one is a page-in and a linear copy rather than a rebuild. Files
+ * written by a different version or on a machine of different endianness are
+ * rejected by IsValid() and should be re-cooked.
+ */
+class ColliderCache
+{
+	public:
+	/** @param path The cache file to map. */
+	explicit ColliderCache(const char* path);
+
+	/** @returns true if the file was mapped and passed every bounds check. */
+	auto IsValid() const -> bool { return this->valid; }
+	/** @returns The number of top level colliders in the file. */
+	auto ColliderCount() const -> uint32_t;
+	/** @returns The key the file was saved with, 0 if it is not valid. */
+	auto GetSourceKey() const -> uint64_t;
+	/**
+	 * @returns A view of collider i if it is a hull, std::nullopt for every
+	 *          other type.
+	 */
+	auto GetHull(uint32_t i) const -> std::optional<HullView>;
+	/** @brief Materializes collider i, along with any children it has. */
+	auto GetCollider(uint32_t i) const -> Collider;
+
+	/**
+	 * @brief Writes cols to path in the cooked format.
+	 * @param sourceKey Identifies what cols were cooked from, see
+	 *        GetCookKey().
+	 * @returns false if the file could not be written.
+	 */
+	static auto Save(const char* path, std::span<const Collider> cols,
+					 const uint64_t sourceKey = 0) -> bool;
+
+	private:
+	struct Header;
+	struct Entry;
+	struct Writer;
+
+	static auto Cook(const Collider& col, Writer& out) -> uint32_t;
+
+	auto GetHeader() const -> const Header&;
+	auto GetEntry(uint32_t id) const -> const Entry&;
+	auto GetHullView(const Entry& entry) const -> HullView;
+	auto GetMeshView(const Entry& entry) const -> MeshView;
+	auto GetHeightfieldView(const Entry& entry) const -> HeightfieldView;
+	auto ValidateMesh(const Entry& entry) const -> bool;
+	auto ValidateHeightfield(const Entry& entry) const -> bool;
+	auto Validate() const -> bool;
+	auto Build(uint32_t id) const -> Collider;
+	template <typename T>
+	auto InBounds(uint64_t offset, uint64_t count) const -> bool;
+	template <typename T>
+	auto GetArray(uint64_t offset, uint64_t count) const -> std::span<const T>;
+
+	MappedFile file;
+	bool valid{false};
+};
+
+/**
+ * @returns A hash of the mesh's vertices and indices together with cookID,
+ *          which should name the cook function and any settings that change
+ *          its result.
+ */
+auto GetCookKey(const Mesh& mesh, std::string_view cookID) -> uint64_t;
+/**
+ * @brief Loads a single collider from the cache at path, cooking it and
+ *        writing the cache first if the file is missing, stale, or was
+ *        cooked from a different source.
+ * @param sourceKey Saved alongside the collider and compared on load,
+ *        usually from GetCookKey().
+ */
+auto LoadCachedCollider(const char* path, const uint64_t sourceKey,
+						const std::function<Collider()>& cook) -> Collider;
+
+} //namespace phys
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "collider.h"
+#include "primitiveTests.h"
+
+#include <concepts>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <raylib.h>
+
+namespace phys
+{
+
+/** @brief Half-edge SAT between two hulls. */
+auto CheckHullHull(const HullCollider& hullA, const HullCollider& hullB)
+	-> std::optional<ContactHit>;
+
+/**
+ * @brief Narrow phase test for an ordered pair of shapes, picked at compile
+ *        time. Each pair only needs a specialisation in one order, as the
+ *        mirrored pair is routed to it with the contact normal flipped.
+ */
+template <isCollider ColA, isCollider ColB>
+struct PairTest
+{ };
+
+/** @brief True if PairTest is specialised for ColA and ColB in that order. */
+template <typename ColA, typename ColB>
+concept hasPairTest = requires(const ColA& colA, const ColB& colB) {
+	{
+		PairTest<ColA, ColB>::Check(colA, colB)
+	} -> std::same_as<std::optional<ContactHit>>;
+};
+
+template <>
+struct PairTest<HullCollider, HullCollider>
+{
+	static constexpr auto Check{&CheckHullHull};
+};
+template <>
+struct PairTest<HullCollider, BoxCollider>
+{
+	static constexpr auto Check{&CheckHullBox};
+};
+template <>
+struct PairTest<SphereCollider, HullCollider>
+{
+	static constexpr auto Check{&CheckSphereHull};
+};
+template <>
+struct PairTest<SphereCollider, SphereCollider>
+{
+	static constexpr auto Check{&CheckSphereSphere};
+};
+template <>
+struct PairTest<SphereCollider, CapsuleCollider>
+{
+	static constexpr auto Check{&CheckSphereCapsule};
+};
+template <>
+struct PairTest<SphereCollider, BoxCollider>
+{
+	static constexpr auto Check{&CheckSphereBox};
+};
+template <>
+struct PairTest<CapsuleCollider, HullCollider>
+{
+	static constexpr auto Check{&CheckCapsuleHull};
+};
+template <>
+struct PairTest<CapsuleCollider, CapsuleCollider>
+{
+	static constexpr auto Check{&CheckCapsuleCapsule};
+};
+template <>
+struct PairTest<CapsuleCollider, BoxCollider>
+{
+	static constexpr auto Check{&CheckCapsuleBox};
+};
+template <>
+struct PairTest<BoxCollider, BoxCollider>
+{
+	static constexpr auto Check{&CheckBoxBox};
+};
+
+/** @brief Picks the CheckTriangle*() test for a shape by overload. */
+inline auto CheckTriangle(const MeshTriangle& tri, const SphereCollider& col)
+	-> std::optional<ContactHit>
+{
+	return CheckTriangleSphere(tri, col);
+}
+inline auto CheckTriangle(const MeshTriangle& tri, const CapsuleCollider& col)
+	-> std::optional<ContactHit>
+{
+	return CheckTriangleCapsule(tri, col);
+}
+inline auto CheckTriangle(const MeshTriangle& tri, const BoxCollider& col)
+	-> std::optional<ContactHit>
+{
+	return CheckTriangleBox(tri, col);
+}
+inline auto CheckTriangle(const MeshTriangle& tri, const HullCollider& col)
+	-> std::optional<ContactHit>
+{
+	return CheckTriangleHull(tri, col);
+}
+
+/**
+ * @brief True for concave shapes made of triangles, which are tested one
+ *        triangle at a time.
+ */
+template <typename Col>
+concept hasTriangles = requires(const Col& col, const BoundingBox& box,
+								std::pmr::vector<uint32_t>& out) {
+	col.GetOverlaps(box, out);
+	{ col.GetTriangle(uint32_t{}) } -> std::same_as<MeshTriangle>;
+};
+
+/** @brief True if CheckTriangle() has an overload for Col. */
+template <typename Col>
+concept hasTriangleTest = requires(const MeshTriangle& tri, const Col& col) {
+	{ CheckTriangle(tri, col) } -> std::same_as<std::optional<ContactHit>>;
+};
+
+/**
+ * @brief Visits both colliders at once and runs the PairTest for their
+ *        shapes. Compounds are tested child by child, and meshes and
+ *        heightfields triangle by triangle under the other shape's bounds,
+ *        keeping the deepest contact. Two of those never collide. A new
+ *        shape type fails to compile here until every pair it forms has a
+ *        PairTest.
+ * @returns A contact whose normal points from colA to colB, or std::nullopt
+ *          if the pair is separated.
+ */
+auto CheckPairCollision(const Collider& colA, const Collider& colB)
+	-> std::optional<ContactHit>;
+/**
+ * @brief Overlap only test for sensors, which stops at the first proof
+ *        either way. Hulls first try their own face normals as separating
+ *        axes, then every pair falls back to a boolean GJK. Compounds
+ *        overlap if any of their children do, and meshes and heightfields
+ *        if any triangle touches.
+ */
+auto CheckPairOverlap(const Collider& colA, const Collider& colB) -> bool;
+
+} //namespace phys
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "bodyStorage.h"
+#include "physObject.h"
+
+#include <array>
+#include <cstdint>
+#include <raylib.h>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace phys
+{
+
+enum class ContactEventType : uint8_t
+{
+	/** @brief The pair touches this step but did not last step. */
+	BEGIN,
+	/** @brief The pair touched last step and still does. */
+	PERSIST,
+	/** @brief The pair touched last step but no longer does. */
+	END,
+};
+
+/**
+ * @brief A change in contact between two bodies. Contact data is in world
+ *        space, and left zeroed for END events and sensors. END events
+ *        carry the sensor flag of the pair's last contact.
+ *
+ * @note body1 and body2 may have been removed by the time an END event is
+ *       read, so check them with BodyStorage::IsValid() before use.
+ */
+struct ContactEvent
+{
+	ContactEventType type;
+	uint8_t pointCount;
+	/** @brief Either body is a sensor, so there is no contact data. */
+	bool sensor;
+	/** @brief The lower handle of the pair. */
+	BodyHandle body1;
+	BodyHandle body2;
+	/** @brief Points from body1 towards body2. */
+	Vector3 normal;
+	float depth;
+	std::array<Vector3, HitObj::MAX_POINTS> points;
+};
+
+/**
+ * @brief Remembers which pairs of bodies touched last step, and turns this
+ *        step's collisions into begin, persist and end events.
+ *
+ * Pairs live in a dense array, with the ones that touched last step packed
+ * at the front. Each pair touched again is swapped towards the start of
+ * that range, so once the step is over the pairs left between the touched
+ * ones and this step's new pairs are exactly the ones that ended. Apart
+ * from one hash lookup per contact, a step costs O(begins + ends) rather
+ * than a rescan of every pair.
+ */
+class ContactTracker
+{
+	public:
+	/** @brief Clears the last step's events. */
+	void BeginStep();
+	/**
+	 * @brief Records that the pair touches this step. Each pair must only
+	 *        be added once per step.
+	 */
+	void AddContact(const HitObj& hit);
+	/** @brief Emits END events for the pairs that were not added. */
+	void EndStep();
+	/** @returns This step's events, valid until the next BeginStep(). */
+	auto GetEvents() const -> std::span<const ContactEvent>
+	{
+		return this->events;
+	}
+	/** @returns The number of pairs touching as of the last EndStep(). */
+	auto GetPairCount() const -> uint32_t
+	{
+		return static_cast<uint32_t>(this->pairs.size());
+	}
+
+	private:
+	struct TrackedPair
+	{
+		BodyPair bodies;
+		/** @brief As of the last contact, so END events can report it. */
+		bool sensor;
+	};
+
+	void MovePair(const uint32_t from, const uint32_t to);
+
+	/** @brief Touching pairs, ordered as described above. */
+	std::vector<TrackedPair> pairs;
+	/** @brief Where each pair is in pairs. */
+	std::unordered_map<BodyPair, uint32_t, BodyPairHash> indices;
+	/** @brief How many pairs touched last step. */
+	uint32_t lastCount{0};
+	/** @brief How many of those have been added again this step. */
+	uint32_t persistCount{0};
+	std::vector<ContactEvent> events;
+};
+
+} //namespace phys
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <raylib.h>
+#include <vector>
+
+// Debug drawing is recorded in debug builds unless turned off explicitly.
+// Without it, every recording call below is an empty inline function.
+#if !defined(PHYS_DEBUG_DRAW) && !defined(NDEBUG)
+#define PHYS_DEBUG_DRAW 1
+#endif
+
+namespace phys
+{
+
+/** @brief Bit flags for filtering what debug geometry is recorded. */
+using DebugCategory = uint8_t;
+constexpr DebugCategory DEBUG_CONTACTS{1U << 0U};
+constexpr DebugCategory DEBUG_NORMALS{1U << 1U};
+constexpr DebugCategory DEBUG_HULLS{1U << 2U};
+constexpr DebugCategory DEBUG_AABBS{1U << 3U};
+constexpr DebugCategory DEBUG_ALL{DEBUG_CONTACTS | DEBUG_NORMALS | DEBUG_HULLS
+								  | DEBUG_AABBS};
+
+/**
+ * @brief One thread's recorded debug geometry, waiting to be drawn.
+ *
+ * Physics code never draws anything itself. It records lines and points
+ * here, and the render thread draws every thread's buffer in one batch with
+ * SubmitDebugDraw(). A thread that exits before then takes what it recorded
+ * with it.
+ */
+class DebugDrawBuffer
+{
+	public:
+	/** @brief Registers the buffer so SubmitDebugDraw() finds it. */
+	DebugDrawBuffer();
+	DebugDrawBuffer(const DebugDrawBuffer&) = delete;
+	DebugDrawBuffer(DebugDrawBuffer&&) = delete;
+
+	~DebugDrawBuffer();
+
+	auto operator=(const DebugDrawBuffer&) -> DebugDrawBuffer& = delete;
+	auto operator=(DebugDrawBuffer&&) -> DebugDrawBuffer& = delete;
+
+	void AddLine(const Vector3 start, const Vector3 end, const Color colour)
+	{
+		this->lines.push_back({.start = start, .end = end, .colour = colour});
+	}
+	void AddPoint(const Vector3 pos, const float size, const Color colour)
+	{
+		this->points.push_back({.pos = pos, .size = size, .colour = colour});
+	}
+	/** @brief Draws everything recorded so far as lines, then clears it. */
+	void Submit();
+
+	private:
+	struct Line
+	{
+		Vector3 start;
+		Vector3 end;
+		Color colour;
+	};
+	/** @brief Drawn as a cross of three lines, size across each. */
+	struct Point
+	{
+		Vector3 pos;
+		float size;
+		Color colour;
+	};
+
+	std::vector<Line> lines;
+	std::vector<Point> points;
+};
+
+/**
+ * @brief Draws and clears the debug geometry every thread has recorded.
+ *        Must be called from the render thread, inside a 3D mode, while no
+ *        physics is running.
+ */
+void SubmitDebugDraw();
+
+#ifdef PHYS_DEBUG_DRAW
+
+namespace detail
+{
+/** @brief Just contacts to start with, the debug panel turns on the rest. */
+inline std::atomic<DebugCategory> debugCategories{DEBUG_CONTACTS};
+/** @brief Cleared while a DebugDrawPause is alive on the thread. */
+inline thread_local bool debugThreadEnabled{true};
+/** @returns The calling thread's buffer. */
+auto GetDebugDrawBuffer() -> DebugDrawBuffer&;
+} //namespace detail
+
+/** @brief Chooses which categories are recorded from now on. */
+inline void SetDebugDrawCategories(const DebugCategory categories)
+{
+	detail::debugCategories.store(categories, std::memory_order_relaxed);
+}
+inline auto GetDebugDrawCategories() -> DebugCategory
+{
+	return detail::debugCategories.load(std::memory_order_relaxed);
+}
+/**
+ * @returns true if anything in category is being recorded, so callers can
+ *          skip working out geometry that would be thrown away.
+ */
+inline auto IsDebugDrawEnabled(const DebugCategory category) -> bool
+{
+	return detail::debugThreadEnabled
+		   && (GetDebugDrawCategories() & category) != 0;
+}
+/**
+ * @brief Stops the calling thread recording anything while it lives, for
+ *        work nothing will ever draw, like stepping headless worlds.
+ */
+class DebugDrawPause
+{
+	public:
+	DebugDrawPause() : wasEnabled(detail::debugThreadEnabled)
+	{
+		detail::debugThreadEnabled = false;
+	}
+	DebugDrawPause(const DebugDrawPause&) = delete;
+	DebugDrawPause(DebugDrawPause&&) = delete;
+
+	~DebugDrawPause() { detail::debugThreadEnabled = this->wasEnabled; }
+
+	auto operator=(const DebugDrawPause&) -> DebugDrawPause& = delete;
+	auto operator=(DebugDrawPause&&) -> DebugDrawPause& = delete;
+
+	private:
+	bool wasEnabled;
+};
+inline void DebugLine(const DebugCategory category, const Vector3 start,
+					  const Vector3 end, const Color colour)
+{
+	if (IsDebugDrawEnabled(category))
+	{
+		detail::GetDebugDrawBuffer().AddLine(start, end, colour);
+	}
+}
+inline void DebugPoint(const DebugCategory category, const Vector3 pos,
+					   const float size, const Color colour)
+{
+	if (IsDebugDrawEnabled(category))
+	{
+		detail::GetDebugDrawBuffer().AddPoint(pos, size, colour);
+	}
+}
+/** @brief Records a box's 12 edges. */
+void DebugBox(const DebugCategory category, const BoundingBox& box,
+			  const Color colour);
+/** @brief Records a sphere as three rings around its axes. */
+void DebugSphere(const DebugCategory category, const Vector3 centre,
+				 const float radius, const Color colour);
+
+#else
+
+inline void SetDebugDrawCategories(const DebugCategory /*categories*/) { }
+inline auto GetDebugDrawCategories() -> DebugCategory
+{
+	return 0;
+}
+inline auto IsDebugDrawEnabled(const DebugCategory /*category*/) -> bool
+{
+	return false;
+}
+class DebugDrawPause
+{ };
+inline void DebugLine(const DebugCategory /*category*/,
+					  const Vector3 /*start*/, const Vector3 /*end*/,
+					  const Color /*colour*/)
+{ }
+inline void DebugPoint(const DebugCategory /*category*/,
+					   const Vector3 /*pos*/, const float /*size*/,
+					   const Color /*colour*/)
+{ }
+inline void DebugBox(const DebugCategory /*category*/,
+					 const BoundingBox& /*box*/, const Color /*colour*/)
+{ }
+inline void DebugSphere(const DebugCategory /*category*/,
+						const Vector3 /*centre*/, const float /*radius*/,
+						const Color /*colour*/)
+{ }
+
+#endif // PHYS_DEBUG_DRAW
+
+} //namespace phys
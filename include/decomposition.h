@@ -0,0 +1,48 @@
+#pragma once
+
+#include "collider.h"
+
+#include <cstdint>
+#include <raylib.h>
+
+namespace phys
+{
+
+/** @brief Tuning parameters for approximate convex decomposition. */
+struct DecompositionSettings
+{
+	/** @brief Upper bound on the number of hulls produced. */
+	uint32_t maxHulls{8};
+	/** @brief Upper bound on the vertices of each hull. 0 means unlimited. */
+	uint32_t maxVertsPerHull{32};
+	/** @brief Approximate number of voxels the mesh is sampled into. */
+	uint32_t resolution{100000};
+	/**
+	 * @brief Parts whose hull exceeds their own volume by less than this
+	 *        fraction of the whole mesh's volume are not split any further.
+	 */
+	float maxConcavity{0.002f};
+	/** @brief Number of candidate split planes tried along each axis. */
+	uint32_t planeSamples{16};
+	/** @brief Worker threads used while cooking. 0 uses every core. */
+	uint32_t threads{0};
+};
+
+/**
+ * @brief Approximates a closed, possibly concave mesh with a set of convex
+ *        hulls.
+ *
+ * The mesh is voxelized and recursively split along axis aligned planes,
+ * always splitting the part that fills its convex hull the worst, until
+ * either every part is close enough to convex or maxHulls is reached. Each
+ * part's hull is then taken from the mesh clipped to that part, so flat faces
+ * stay exact.
+ *
+ * @returns A CompoundCollider of the hulls, or a single HullCollider when the
+ *          mesh is already close enough to convex.
+ */
+auto CreateDecomposedCollider(const Mesh& mesh,
+							  const DecompositionSettings& settings = {})
+	-> Collider;
+
+} //namespace phys
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <ostream>
+#include <stop_token>
+#include <thread>
+
+// Records below this level are compiled out. Debug builds keep DEBUG and
+// up, release builds INFO and up. Define it as 0 to also keep TRACE.
+#ifndef PHYS_LOG_LEVEL
+#ifdef NDEBUG
+#define PHYS_LOG_LEVEL 2
+#else
+#define PHYS_LOG_LEVEL 1
+#endif
+#endif
+
+namespace phys
+{
+
+enum class LogLevel : uint8_t
+{
+	TRACE,
+	DEBUG,
+	INFO,
+	WARNING,
+	ERROR,
+};
+constexpr LogLevel MIN_LOG_LEVEL{static_cast<LogLevel>(PHYS_LOG_LEVEL)};
+
+/**
+ * @brief One logged event. Records are fixed size and hold no owned memory,
+ *        so writing one is a copy into the log's ring buffer.
+ */
+struct LogRecord
+{
+	static constexpr uint32_t MAX_VALUES{4};
+
+	/** @brief Nanoseconds since the log was created. */
+	int64_t time;
+	/** @brief Small index of the thread that logged it, in order of use. */
+	uint32_t thread;
+	LogLevel level;
+	uint8_t valueCount;
+	/** @brief Must outlive the log, in practice a string literal. */
+	const char* message;
+	std::array<float, MAX_VALUES> values;
+};
+
+/**
+ * @brief Asynchronous log that writes records on a background thread.
+ *
+ * Writers push records into a bounded lock-free ring buffer, which costs a
+ * compare and swap and a copy, and never blocks or allocates. A drain
+ * thread formats whatever has arrived every few milliseconds and writes it
+ * out. If writers outpace it and the ring fills, new records are dropped
+ * and counted instead of making the writer wait.
+ *
+ * Web builds have no threads, so there Push() writes each record out itself
+ * before it returns.
+ */
+class EventLog
+{
+	public:
+	/** @brief Must be a power of two. */
+	static constexpr uint32_t CAPACITY{4096};
+	static constexpr std::chrono::milliseconds DRAIN_INTERVAL{5};
+
+	/**
+	 * @param path File to write to, or nullptr to write to the console with
+	 *        each level in its own colour.
+	 */
+	explicit EventLog(const char* path = nullptr);
+	EventLog(const EventLog&) = delete;
+	EventLog(EventLog&&) = delete;
+
+	/** @brief Writes out anything still queued before stopping. */
+	~EventLog() = default;
+
+	auto operator=(const EventLog&) -> EventLog& = delete;
+	auto operator=(EventLog&&) -> EventLog& = delete;
+
+	/**
+	 * @brief Safe to call from any number of threads at once.
+	 * @returns false if the ring was full and the record was dropped.
+	 */
+	auto Push(const LogRecord& record) -> bool;
+	/** @brief Blocks until every record pushed so far has been written. */
+	void Flush();
+	/** @returns The number of records dropped because the ring was full. */
+	auto GetDropped() const -> uint64_t
+	{
+		return this->dropped.load(std::memory_order_relaxed);
+	}
+	/** @returns Nanoseconds since the log was created. */
+	auto Now() const -> int64_t
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				   std::chrono::steady_clock::now() - this->start)
+			.count();
+	}
+
+	private:
+	/** @brief sequence says whose turn it is to use the slot next. */
+	struct Slot
+	{
+		std::atomic<uint64_t> sequence;
+		LogRecord record;
+	};
+
+	/** @brief Only ever called from the drain thread, or Push() on the web. */
+	auto Pop(LogRecord& out) -> bool;
+	void Drain(const std::stop_token stop);
+	/** @brief Writes every queued record, and the count of any dropped. */
+	void WritePending();
+	void Write(const LogRecord& record);
+
+	std::unique_ptr<Slot[]> slots;
+	/** @brief Next position a writer will claim. */
+	alignas(64) std::atomic<uint64_t> head{0};
+	/** @brief Next position the drain thread will read. */
+	alignas(64) std::atomic<uint64_t> tail{0};
+	std::atomic<uint64_t> dropped{0};
+	/** @brief How many drops have already been reported in the output. */
+	uint64_t reportedDropped{0};
+
+	std::chrono::steady_clock::time_point start;
+	std::ofstream file;
+	std::ostream* out;
+	bool useColour;
+#if !defined(PLATFORM_WEB)
+	/** @brief Last, so it is stopped and joined before the rest is freed. */
+	std::jthread drainer;
+#endif // !defined(PLATFORM_WEB)
+};
+
+/** @returns The log every Log() call writes to, on the console. */
+auto GetEventLog() -> EventLog&;
+/** @returns The calling thread's LogRecord::thread. */
+auto GetLogThreadID() -> uint32_t;
+
+/**
+ * @brief Logs message with up to LogRecord::MAX_VALUES numbers after it.
+ *        Compiles to nothing when LEVEL is below PHYS_LOG_LEVEL.
+ * @param message Must outlive the log, in practice a string literal.
+ */
+template <LogLevel LEVEL, typename... Values>
+void Log(const char* message, const Values... values)
+{
+	static_assert(sizeof...(Values) <= LogRecord::MAX_VALUES);
+	if constexpr (LEVEL >= MIN_LOG_LEVEL)
+	{
+		EventLog& log{GetEventLog()};
+		log.Push({.time = log.Now(),
+				  .thread = GetLogThreadID(),
+				  .level = LEVEL,
+				  .valueCount = sizeof...(Values),
+				  .message = message,
+				  .values = {static_cast<float>(values)...}});
+	}
+}
+
+} //namespace phys
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace phys
+{
+
+/** @brief What a FrameArena handed out over one step. */
+struct ArenaStats
+{
+	uint32_t allocations{0};
+	/** @brief Bytes handed out, including alignment padding. */
+	size_t bytes{0};
+	/** @brief Blocks taken from the heap because the arena ran out. */
+	uint32_t blockAllocations{0};
+};
+
+/**
+ * @brief Monotonic scratch memory for a single simulation step.
+ *
+ * Allocating bumps a pointer through the current block, and deallocating
+ * does nothing. Everything is released at once by Reset(). A step that
+ * outgrows the arena chains on another block, and the next Reset() merges the
+ * blocks into one big enough for the whole step, so once the arena has seen
+ * a busy step it stops touching the heap.
+ *
+ * @note Nothing allocated from an arena may outlive the step it was made in.
+ */
+class FrameArena : public std::pmr::memory_resource
+{
+	public:
+	static constexpr size_t DEFAULT_SIZE{size_t{64} * 1024};
+
+	explicit FrameArena(const size_t initialSize = DEFAULT_SIZE);
+	FrameArena(const FrameArena&) = delete;
+	FrameArena(FrameArena&&) = delete;
+
+	~FrameArena() override = default;
+
+	auto operator=(const FrameArena&) -> FrameArena& = delete;
+	auto operator=(FrameArena&&) -> FrameArena& = delete;
+
+	/** @brief Releases everything allocated since the last Reset(). */
+	void Reset();
+	/** @returns What has been allocated since the last Reset(). */
+	auto GetStats() const -> const ArenaStats& { return this->stats; }
+	/** @returns What was allocated in the step before the last Reset(). */
+	auto GetLastStats() const -> const ArenaStats& { return this->lastStats; }
+
+	private:
+	struct Block
+	{
+		std::unique_ptr<std::byte[]> data;
+		size_t size;
+	};
+
+	auto do_allocate(const size_t bytes, const size_t alignment)
+		-> void* override;
+	void do_deallocate(void* /*ptr*/, const size_t /*bytes*/,
+					   const size_t /*alignment*/) override
+	{ }
+	auto do_is_equal(const std::pmr::memory_resource& other) const noexcept
+		-> bool override
+	{
+		return this == &other;
+	}
+
+	void AddBlock(const size_t size);
+
+	std::vector<Block> blocks;
+	/** @brief Bytes used at the start of the last block. */
+	size_t used{0};
+	ArenaStats stats;
+	ArenaStats lastStats;
+};
+
+/**
+ * @returns The calling thread's arena. The collision hot path takes its
+ *          scratch memory from here, so whoever drives a step on a thread
+ *          resets that thread's arena once the step is done with it.
+ */
+auto GetFrameArena() -> FrameArena&;
+
+} //namespace phys
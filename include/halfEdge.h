@@ -29,7 +29,7 @@ struct HVertex
 	float y{0.0f};
 	float z{0.0f};
 
-	uint8_t edgeID{0};
+	uint32_t edgeID{0};
 	std::vector<HE::HEdge>* edgeArr{nullptr};
 
 	auto Edge() const -> HEdge*;
@@ -61,10 +61,10 @@ struct HVertex
 
 struct HEdge
 {
-	uint8_t vertID{0};
-	uint8_t twinID{0};
-	uint8_t nextID{0};
-	uint8_t faceID{0};
+	uint32_t vertID{0};
+	uint32_t twinID{0};
+	uint32_t nextID{0};
+	uint32_t faceID{0};
 
 	auto Vertex() const -> HVertex*;
 	auto Twin() const -> HEdge*;
@@ -129,7 +129,7 @@ struct HFace
 
 	HFace(const Vector3 nor) : normal(nor) { };
 	Vector3 normal;
-	uint8_t edgeID{0};
+	uint32_t edgeID{0};
 
 	auto Edge() const -> HEdge*;
 	auto Center() const -> Vector3;
@@ -149,7 +149,7 @@ struct HFace
 struct FaceInit
 {
 	Vector3 normal;
-	std::vector<uint8_t> indices;
+	std::vector<uint32_t> indices;
 };
 
 #ifndef NDEBUG
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "collider.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace phys
+{
+
+/**
+ * @brief Interns hull geometry so every HullCollider of the same shape shares
+ *        one copy of it.
+ *
+ * Entries are only weak references. The registry never keeps geometry alive
+ * by itself, it only lets a new hull find a live copy of an identical one.
+ * Geometry is freed as soon as the last collider using it is gone.
+ *
+ * @note Only long lived colliders are worth interning. Scratch hulls, like
+ *       the transformed copies the narrowphase makes, skip the registry.
+ */
+class HullRegistry
+{
+	public:
+	/**
+	 * @brief Points every hull in col, including a compound's children, at
+	 *        the live copy of its geometry, registering any that are new.
+	 */
+	void Intern(Collider& col);
+	/** @returns The number of unique hulls that are still in use. */
+	auto GetLiveCount() -> uint32_t;
+
+	private:
+	/**
+	 * @returns An existing live copy of the same hull if there is one,
+	 *          otherwise geometry itself, which is registered for later hulls.
+	 */
+	auto InternGeometry(std::shared_ptr<const HullGeometry> geometry)
+		-> std::shared_ptr<const HullGeometry>;
+	/** @brief Drops the entries of hulls that have been freed. */
+	void Prune();
+
+	std::mutex mutex;
+	/** @brief Keyed by a hash of each hull's contents. */
+	std::unordered_multimap<uint64_t, std::weak_ptr<const HullGeometry>> hulls;
+	/** @brief Prune() runs once the map grows this large. */
+	uint64_t pruneSize{64};
+};
+
+/** @returns The registry every HullCollider is interned through. */
+auto GetHullRegistry() -> HullRegistry&;
+
+} //namespace phys
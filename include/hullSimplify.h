@@ -0,0 +1,43 @@
+#pragma once
+
+#include "collider.h"
+
+#include <cstdint>
+#include <limits>
+
+namespace phys
+{
+
+/** @brief Targets for convex hull simplification. */
+struct SimplifySettings
+{
+	/** @brief Vertex count to reduce the hull to. 0 means unlimited. */
+	uint32_t maxVertices{16};
+	/** @brief Face count to reduce the hull to. 0 means unlimited. */
+	uint32_t maxFaces{0};
+	/**
+	 * @brief Faces are never removed if doing so would move the surface out
+	 *        by more than this distance, even if the targets are not met yet.
+	 */
+	float maxError{std::numeric_limits<float>::infinity()};
+};
+
+/**
+ * @brief Reduces the vertex and face count of a convex hull, which makes
+ *        edge checks in CheckEdgeNors cheaper.
+ *
+ * Faces are removed one at a time by dropping their plane from the hull,
+ * always picking the face whose removal adds the least volume. As the hull is
+ * the intersection of its face planes, dropping a plane can only grow it, so
+ * the simplified hull always contains the original one.
+ *
+ * @note Faces whose removal would leave the hull unbounded, such as any face
+ *       of a tetrahedron, are never removed, so the targets may not be met.
+ */
+auto SimplifyHull(const HullCollider& hull, const SimplifySettings& settings)
+	-> Collider;
+/** @brief Simplifies every hull in a collider, including compound children. */
+auto SimplifyCollider(const Collider& col, const SimplifySettings& settings)
+	-> Collider;
+
+} //namespace phys
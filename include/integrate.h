@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cstdint>
+#include <raylib.h>
+#include <vector>
+
+namespace phys
+{
+
+using std::vector;
+
+/** @brief Vector3s stored as one array per component. */
+struct Vector3Array
+{
+	vector<float> x;
+	vector<float> y;
+	vector<float> z;
+
+	auto Get(const uint32_t i) const -> Vector3 { return {x[i], y[i], z[i]}; }
+	void Set(const uint32_t i, const Vector3 vec)
+	{
+		x[i] = vec.x;
+		y[i] = vec.y;
+		z[i] = vec.z;
+	}
+	void PushBack(const Vector3 vec)
+	{
+		x.push_back(vec.x);
+		y.push_back(vec.y);
+		z.push_back(vec.z);
+	}
+	void Swap(const uint32_t i, const uint32_t j)
+	{
+		const Vector3 vec{this->Get(i)};
+		this->Set(i, this->Get(j));
+		this->Set(j, vec);
+	}
+	/** @brief Moves the last element into i and shrinks by one. */
+	void SwapRemove(const uint32_t i)
+	{
+		this->Set(i, this->Get(static_cast<uint32_t>(x.size() - 1)));
+		x.pop_back();
+		y.pop_back();
+		z.pop_back();
+	}
+	void Reserve(const uint32_t count)
+	{
+		x.reserve(count);
+		y.reserve(count);
+		z.reserve(count);
+	}
+};
+/** @brief Quaternions stored as one array per component. */
+struct QuaternionArray
+{
+	vector<float> x;
+	vector<float> y;
+	vector<float> z;
+	vector<float> w;
+
+	auto Get(const uint32_t i) const -> Quaternion
+	{
+		return {x[i], y[i], z[i], w[i]};
+	}
+	void Set(const uint32_t i, const Quaternion quat)
+	{
+		x[i] = quat.x;
+		y[i] = quat.y;
+		z[i] = quat.z;
+		w[i] = quat.w;
+	}
+	void PushBack(const Quaternion quat)
+	{
+		x.push_back(quat.x);
+		y.push_back(quat.y);
+		z.push_back(quat.z);
+		w.push_back(quat.w);
+	}
+	void Swap(const uint32_t i, const uint32_t j)
+	{
+		const Quaternion quat{this->Get(i)};
+		this->Set(i, this->Get(j));
+		this->Set(j, quat);
+	}
+	/** @brief Moves the last element into i and shrinks by one. */
+	void SwapRemove(const uint32_t i)
+	{
+		this->Set(i, this->Get(static_cast<uint32_t>(x.size() - 1)));
+		x.pop_back();
+		y.pop_back();
+		z.pop_back();
+		w.pop_back();
+	}
+	void Reserve(const uint32_t count)
+	{
+		x.reserve(count);
+		y.reserve(count);
+		z.reserve(count);
+		w.reserve(count);
+	}
+};
+
+/** @brief Set in BodyState::matrixFlags when a cached matrix is stale. */
+constexpr uint8_t WORLD_DIRTY{1U << 0U};
+constexpr uint8_t INVERSE_DIRTY{1U << 1U};
+
+/**
+ * @brief The per body data integration reads and writes, one array per
+ *        component so several bodies can be loaded into SIMD lanes at once.
+ */
+struct BodyState
+{
+	Vector3Array positions;
+	QuaternionArray rotations;
+	Vector3Array scales;
+	Vector3Array velocities;
+	/** @brief World space, in radians per second. */
+	Vector3Array angularVelocities;
+	/** @brief 0 for kinematic and static bodies. */
+	vector<float> inverseMasses;
+	/** @brief Centre of the active collider's bounds in body space. */
+	Vector3Array localCentres;
+	/** @brief Half size of the active collider's bounds in body space. */
+	Vector3Array localExtents;
+	/**
+	 * @brief World space bounds, refreshed by every integration step for
+	 *        the bodies it moves.
+	 */
+	Vector3Array boundsMin;
+	Vector3Array boundsMax;
+	/** @brief WORLD_DIRTY and INVERSE_DIRTY bits per body. */
+	mutable vector<uint8_t> matrixFlags;
+
+	auto Size() const -> uint32_t
+	{
+		return static_cast<uint32_t>(this->inverseMasses.size());
+	}
+	auto GetBounds(const uint32_t i) const -> BoundingBox
+	{
+		return {.min = this->boundsMin.Get(i), .max = this->boundsMax.Get(i)};
+	}
+	/** @brief Exchanges bodies i and j in every array. */
+	void Swap(const uint32_t i, const uint32_t j);
+	/** @brief Moves the last body into i and shrinks every array by one. */
+	void SwapRemove(const uint32_t i);
+	void Reserve(const uint32_t count);
+};
+
+struct IntegrateParams
+{
+	float deltaTime;
+	Vector3 gravity;
+	/** @brief Factors velocities are scaled by this step. */
+	float linearDamping{1.0f};
+	float angularDamping{1.0f};
+};
+
+enum class IntegrateKernel : uint8_t
+{
+	SCALAR,
+	/** @brief 4 bodies per step with SSE2, only on x86. */
+	SSE2,
+};
+
+/** @returns The widest kernel both the build and the CPU support. */
+auto GetBestKernel() -> IntegrateKernel;
+/**
+ * @brief Moves and rotates the first count bodies by their velocities,
+ *        renormalises their rotations and recomputes their world space
+ *        bounds. Gravity and damping are only applied to bodies with a
+ *        positive inverse mass, so kinematic ones keep their velocities.
+ */
+void IntegrateBodies(const IntegrateKernel kernel, BodyState& state,
+					 const IntegrateParams& params, const uint32_t count);
+/**
+ * @brief Runs the scalar kernel and GetBestKernel() over the same generated
+ *        bodies.
+ * @returns true if both give the same results, within rounding.
+ */
+auto CheckIntegrateKernels() -> bool;
+
+} //namespace phys
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+namespace phys
+{
+
+using std::vector;
+
+/**
+ * @brief A pool of worker threads that run batches of jobs, stealing from
+ *        each other when they run dry.
+ *
+ * Run() deals the jobs out round robin in the order given, so each worker
+ * owns a contiguous queue holding every n-th job. A worker takes jobs from
+ * the front of its own queue, and once that is empty steals from the back
+ * of the others', which leaves the first jobs of every queue to their owner
+ * and hands thieves the last, and usually smallest, ones. Each queue is a
+ * [begin, end) range packed into one atomic, so taking a job from either
+ * end is a single compare and swap.
+ *
+ * Workers sleep between batches and the calling thread always joins in, so
+ * a batch of one job never leaves it.
+ *
+ * @note Jobs must not call Run() themselves.
+ */
+class JobSystem
+{
+	public:
+	/**
+	 * @param threads How many threads to run jobs on, counting the calling
+	 *        one. 0 uses one per hardware thread. Web builds always use
+	 *        just the calling one.
+	 */
+	explicit JobSystem(const uint32_t threads = 0);
+	JobSystem(const JobSystem&) = delete;
+	JobSystem(JobSystem&&) = delete;
+
+	/** @brief Wakes the workers with a stop request and joins them. */
+	~JobSystem() = default;
+
+	auto operator=(const JobSystem&) -> JobSystem& = delete;
+	auto operator=(JobSystem&&) -> JobSystem& = delete;
+
+	/** @returns How many threads jobs run on, counting the calling one. */
+	auto GetThreadCount() const -> uint32_t
+	{
+		return static_cast<uint32_t>(this->queues.size());
+	}
+	/**
+	 * @brief Runs func(job) for every job and waits for all of them. Jobs
+	 *        start roughly in the order given, so put the longest first.
+	 *        Worker threads reset their FrameArena once they are done.
+	 */
+	void Run(std::span<const uint32_t> jobs,
+			 const std::function<void(uint32_t)>& func);
+	/** @brief Runs func(i) for every i in [0, count). */
+	void ParallelFor(const uint32_t count,
+					 const std::function<void(uint32_t)>& func);
+
+	private:
+	/** @brief A worker's share of the batch, padded to its own cache line. */
+	struct alignas(64) Queue
+	{
+		/** @brief The queue's first job in the low half, its end above. */
+		std::atomic<uint64_t> range{0};
+	};
+
+	void WorkerLoop(const std::stop_token& stop, const uint32_t worker);
+	/** @brief Runs jobs until every queue is empty. */
+	void Work(const uint32_t worker);
+	/** @returns The job at the front of the queue, if any are left. */
+	auto PopFront(Queue& queue) -> std::optional<uint32_t>;
+	/** @returns The job at the back of the queue, if any are left. */
+	auto PopBack(Queue& queue) -> std::optional<uint32_t>;
+
+	vector<Queue> queues;
+	/** @brief This batch's jobs, each worker's queue back to back. */
+	vector<uint32_t> dealt;
+	/** @brief ParallelFor() scratch, kept to avoid reallocating. */
+	vector<uint32_t> sequence;
+	const std::function<void(uint32_t)>* func{nullptr};
+
+	std::mutex mutex;
+	std::condition_variable_any wake;
+	std::condition_variable done;
+	/** @brief Bumped by every batch, to wake the workers. */
+	uint64_t generation{0};
+	/** @brief Workers still running the current batch. */
+	uint32_t busyWorkers{0};
+	/** @brief Declared last, so they are joined before the rest goes. */
+	vector<std::jthread> workers;
+};
+
+} //namespace phys
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__) && (defined(__x86_64__) || defined(__i386__))
+#define PHYS_HAS_SSE2
+#elif defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PHYS_HAS_SSE2
+#endif // SSE2 detection
+#ifdef PHYS_HAS_SSE2
+#include <emmintrin.h>
+#endif // PHYS_HAS_SSE2
+
+namespace phys
+{
+
+/**
+ * @brief One element at a time. Also the reference the SIMD kernels are
+ *        checked against, and what handles the elements left over after them.
+ */
+struct ScalarLanes
+{
+	using Float = float;
+	using Mask = bool;
+	static constexpr uint32_t WIDTH{1};
+
+	static auto Load(const float* src) -> Float { return *src; }
+	static void Store(float* dst, const Float val) { *dst = val; }
+	static auto Splat(const float val) -> Float { return val; }
+	static auto Abs(const Float val) -> Float { return std::fabs(val); }
+	static auto Sqrt(const Float val) -> Float { return std::sqrt(val); }
+	static auto Min(const Float a, const Float b) -> Float
+	{
+		return std::min(a, b);
+	}
+	static auto Max(const Float a, const Float b) -> Float
+	{
+		return std::max(a, b);
+	}
+	static auto IsPositive(const Float val) -> Mask { return val > 0.0f; }
+	static auto Select(const Mask mask, const Float a, const Float b) -> Float
+	{
+		return mask ? a : b;
+	}
+};
+
+#ifdef PHYS_HAS_SSE2
+/** @brief Four floats with the arithmetic operators the kernels use. */
+struct Float4
+{
+	__m128 val;
+
+	friend auto operator+(const Float4 a, const Float4 b) -> Float4
+	{
+		return {_mm_add_ps(a.val, b.val)};
+	}
+	friend auto operator-(const Float4 a, const Float4 b) -> Float4
+	{
+		return {_mm_sub_ps(a.val, b.val)};
+	}
+	friend auto operator*(const Float4 a, const Float4 b) -> Float4
+	{
+		return {_mm_mul_ps(a.val, b.val)};
+	}
+	friend auto operator/(const Float4 a, const Float4 b) -> Float4
+	{
+		return {_mm_div_ps(a.val, b.val)};
+	}
+};
+/** @brief Four elements at a time. */
+struct SSE2Lanes
+{
+	using Float = Float4;
+	using Mask = Float4;
+	static constexpr uint32_t WIDTH{4};
+
+	static auto Load(const float* src) -> Float { return {_mm_loadu_ps(src)}; }
+	static void Store(float* dst, const Float val)
+	{
+		_mm_storeu_ps(dst, val.val);
+	}
+	static auto Splat(const float val) -> Float { return {_mm_set1_ps(val)}; }
+	static auto Abs(const Float val) -> Float
+	{
+		return {_mm_andnot_ps(_mm_set1_ps(-0.0f), val.val)};
+	}
+	static auto Sqrt(const Float val) -> Float
+	{
+		return {_mm_sqrt_ps(val.val)};
+	}
+	// Operands swapped to match std::min and std::max, even for NaNs
+	static auto Min(const Float a, const Float b) -> Float
+	{
+		return {_mm_min_ps(b.val, a.val)};
+	}
+	static auto Max(const Float a, const Float b) -> Float
+	{
+		return {_mm_max_ps(b.val, a.val)};
+	}
+	static auto IsPositive(const Float val) -> Mask
+	{
+		return {_mm_cmpgt_ps(val.val, _mm_setzero_ps())};
+	}
+	static auto Select(const Mask mask, const Float a, const Float b) -> Float
+	{
+		return {_mm_or_ps(_mm_and_ps(mask.val, a.val),
+						  _mm_andnot_ps(mask.val, b.val))};
+	}
+};
+#endif // PHYS_HAS_SSE2
+
+} //namespace phys
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+
+namespace phys
+{
+
+/**
+ * @brief Read-only memory mapping of an entire file. The mapping is released
+ *        when the object is destroyed.
+ */
+class MappedFile
+{
+	public:
+	MappedFile() = default;
+	/** @param path The file to map. On failure IsOpen() returns false. */
+	explicit MappedFile(const char* path);
+	MappedFile(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+
+	~MappedFile();
+
+	auto operator=(const MappedFile&) -> MappedFile& = delete;
+	auto operator=(MappedFile&& other) noexcept -> MappedFile&;
+
+	auto IsOpen() const -> bool { return this->data != nullptr; }
+	auto Bytes() const -> std::span<const std::byte>
+	{
+		return {this->data, this->size};
+	}
+
+	private:
+	void Close();
+
+	const std::byte* data{nullptr};
+	std::size_t size{0};
+#ifdef _WIN32
+	// HANDLEs, kept opaque so windows.h stays out of this header
+	void* file{nullptr};
+	void* mapping{nullptr};
+#endif // _WIN32
+};
+
+} //namespace phys
@@ -1,7 +1,13 @@
 #pragma once
 
+#include "bodyStorage.h"
 #include "collider.h"
+#include "hullSimplify.h"
+#include "renderCache.h"
 
+#include <array>
+#include <cstdint>
+#include <memory_resource>
 #include <optional>
 #include <raylib.h>
 #include <raymath.h>
@@ -11,39 +17,54 @@ namespace phys
 {
 
 /**
- * @brief Object that interacts with the physics simulation systems. Has a
- *        collider for collision detection and resolution, and a mesh and
- *        material for rendering.
+ * @brief Handle to a body that interacts with the physics simulation systems.
+ *        The body has a collider for collision detection and resolution, and
+ *        a mesh and material for rendering, all of which live in a
+ *        BodyStorage.
  *
- * @note Physics and other logic happens in the Update() method, while
- *       rendering happens in the Draw() method.
+ * @note Handles are cheap to copy, and stay valid as bodies are added and
+ *       removed, until their own body is removed.
+ *       Physics runs over the whole storage at once, while rendering a
+ *       single body happens in the Draw() method.
  */
 class PhysObject
 {
 	public:
 	/**
+	 * @param bodies The storage to add the new body to.
 	 * @param pos The initial position of the object in 3D space.
-	 * @param mesh The mesh to render when Draw() is called.
+	 * @param mesh A reference to a mesh in the RenderCache, which the body
+	 *        takes over.
 	 * @param col The Collider to use for physics calculations.
 	 */
-	PhysObject(const Vector3 pos, const Mesh mesh, const Collider& col);
+	PhysObject(BodyStorage& bodies, const Vector3 pos, const MeshID mesh,
+			   const Collider& col);
 	/**
+	 * @param bodies The storage to add the new body to.
 	 * @param pos The initial position of the object in 3D space.
-	 * @param mesh The mesh to render when Draw() is called.
+	 * @param mesh A reference to a mesh in the RenderCache, which the body
+	 *        takes over.
 	 * @param col The Collider to use for physics calculations.
-	 * @param shader A shader to apply when rendering the mesh.
+	 * @param material The RenderCache material to draw the mesh with.
 	 */
-	PhysObject(const Vector3 pos, const Mesh mesh, const Collider& col,
-			   const Shader& shader);
+	PhysObject(BodyStorage& bodies, const Vector3 pos, const MeshID mesh,
+			   const Collider& col, const MaterialID material);
 	/**
+	 * @param bodies The storage to add the new body to.
 	 * @param pos The initial position of the object in 3D space.
-	 * @param mesh The mesh to render when Draw() is called.
+	 * @param mesh A reference to a mesh in the RenderCache, which the body
+	 *        takes over.
 	 * @param col The Collider to use for physics calculations.
 	 * @param fragShader Path to the shader file to load.
 	 * @param vertShader Path to the shader file to load.
 	 */
-	PhysObject(const Vector3 pos, const Mesh mesh, const Collider& col,
-			   const char* vertShader, const char* fragShader);
+	PhysObject(BodyStorage& bodies, const Vector3 pos, const MeshID mesh,
+			   const Collider& col, const char* vertShader,
+			   const char* fragShader);
+	/** @brief Refers to a body already in bodies. */
+	PhysObject(BodyStorage& bodies, const BodyHandle handle) :
+		bodies(&bodies), handle(handle)
+	{ }
 	PhysObject(const PhysObject&) = default;
 	PhysObject(PhysObject&&) = default;
 
@@ -52,106 +73,199 @@ class PhysObject
 	auto operator=(const PhysObject&) -> PhysObject& = default;
 	auto operator=(PhysObject&&) -> PhysObject& = default;
 
-	void Update();
 	void Draw() const;
 
+	auto GetHandle() const -> BodyHandle { return this->handle; }
+	/** @returns false once the body has been removed from its storage. */
+	auto IsValid() const -> bool { return this->bodies->IsValid(this->handle); }
+	/**
+	 * @brief Objects start out static. Moving a static object rebuilds the
+	 *        broadphase's static tree, so should be rare.
+	 */
+	void SetBodyType(const BodyType type)
+	{
+		this->bodies->SetType(this->handle, type);
+	}
+	auto GetBodyType() const -> BodyType
+	{
+		return this->bodies->GetType(this->handle);
+	}
+	/** @brief Sensors report overlaps, but never get contacts. */
+	void SetSensor(const bool sensor)
+	{
+		uint8_t& flags{this->bodies->flags[this->Index()]};
+		flags = sensor ? flags | BODY_SENSOR
+					   : flags & static_cast<uint8_t>(~BODY_SENSOR);
+	}
+	auto IsSensor() const -> bool
+	{
+		return (this->bodies->flags[this->Index()] & BODY_SENSOR) != 0;
+	}
+	/**
+	 * @brief Sets the layers the body is on and the layers it collides
+	 *        with, checked by the broadphase before anything else.
+	 */
+	void SetCollisionFilter(const CollisionFilter filter)
+	{
+		this->bodies->filters[this->Index()] = filter;
+	}
+	auto GetCollisionFilter() const -> CollisionFilter
+	{
+		return this->bodies->filters[this->Index()];
+	}
 	/**
 	 * @returns The composite of the position, rotation, and scale
-	 *          transformation matrices.
+	 *          transformations. Cached until the transform next changes.
+	 */
+	auto GetTransformM() const -> const Matrix&
+	{
+		return this->bodies->GetTransformM(this->Index());
+	}
+	/**
+	 * @returns The inverse of GetTransformM(), worked out in closed form and
+	 *          cached the same way.
 	 */
-	auto GetTransformM() const -> Matrix
+	auto GetInverseTransformM() const -> const Matrix&
 	{
-		return this->scale * this->rotation * this->position;
+		return this->bodies->GetInverseTransformM(this->Index());
 	}
 	/** @returns The objects current position in world space. */
 	auto GetPosition() const -> Vector3
 	{
-		return {position.m12, position.m13, position.m14};
+		return this->bodies->state.positions.Get(this->Index());
 	}
 	/** @returns The object's current rotation in world space. */
 	auto GetRotation() const -> Quaternion
 	{
-		Quaternion rot;
-		Vector3 translation;
-		Vector3 matScale;
-		MatrixDecompose(this->rotation, &translation, &rot, &matScale);
-		return rot;
+		return this->bodies->state.rotations.Get(this->Index());
 	}
 	auto GetScale() const -> Vector3
 	{
-		Quaternion rot;
-		Vector3 translation;
-		Vector3 matScale;
-		MatrixDecompose(this->scale, &translation, &rot, &matScale);
-		return matScale;
+		return this->bodies->state.scales.Get(this->Index());
+	}
+	auto GetVelocity() const -> Vector3
+	{
+		return this->bodies->state.velocities.Get(this->Index());
+	}
+	/** @returns The world space angular velocity in radians per second. */
+	auto GetAngularVelocity() const -> Vector3
+	{
+		return this->bodies->state.angularVelocities.Get(this->Index());
+	}
+	/** @returns The world space bounds from the last Integrate(). */
+	auto GetBounds() const -> BoundingBox
+	{
+		return this->bodies->state.GetBounds(this->Index());
 	}
 
 	/** @brief Sets the object's position in world space. */
 	void SetPosition(const Vector3& newPos)
 	{
-		position.m12 = newPos.x;
-		position.m13 = newPos.y;
-		position.m14 = newPos.z;
+		this->bodies->state.positions.Set(this->Index(), newPos);
+		this->bodies->InvalidateMatrices(this->Index());
 	}
 	/**
 	 * @brief Sets the object's rotation in world space using a rotation
 	 *        Matrix.
 	 */
-	void SetRotation(const Matrix& newRot) { this->rotation = newRot; }
+	void SetRotation(const Matrix& newRot)
+	{
+		this->SetRotation(QuaternionFromMatrix(newRot));
+	}
 	/** @brief Sets the object's rotation in world space. */
 	void SetRotation(const Quaternion& newRot)
 	{
-		this->rotation = QuaternionToMatrix(newRot);
+		this->bodies->state.rotations.Set(this->Index(), newRot);
+		this->bodies->InvalidateMatrices(this->Index());
 	}
 	void SetScale(const float newScale)
 	{
-		this->scale = MatrixScale(newScale, newScale, newScale);
+		this->SetScale(Vector3{newScale, newScale, newScale});
 	}
 	void SetScale(const Vector3 newScale)
 	{
-		this->scale = MatrixScale(newScale.x, newScale.y, newScale.z);
+		this->bodies->state.scales.Set(this->Index(), newScale);
+		this->bodies->InvalidateMatrices(this->Index());
+	}
+	void SetVelocity(const Vector3 newVel)
+	{
+		this->bodies->state.velocities.Set(this->Index(), newVel);
+	}
+	/** @brief Sets the world space angular velocity in radians per second. */
+	void SetAngularVelocity(const Vector3 newAngVel)
+	{
+		this->bodies->state.angularVelocities.Set(this->Index(), newAngVel);
+	}
+	/**
+	 * @brief 0 makes a moving object kinematic and anything above makes it
+	 *        dynamic. Static objects keep it until they are made to move.
+	 */
+	void SetInverseMass(const float newInvMass)
+	{
+		this->bodies->state.inverseMasses[this->Index()] = newInvMass;
 	}
 
 	/** @brief Rotates the object in world space. */
 	void Rotate(const Quaternion& rot)
 	{
-		rotation = rotation * QuaternionToMatrix(rot);
+		this->SetRotation(
+			QuaternionNormalize(QuaternionMultiply(rot, this->GetRotation())));
 	}
 
-	/** @returns A pointer to the object's physics Collider. */
-	auto GetCollider() const -> Collider { return this->collider; }
-	void GetColliderT(vector<Collider>& out) const
+	/** @returns The object's physics Collider at the current LOD. */
+	auto GetCollider() const -> const Collider&
+	{
+		return this->ActiveCollider();
+	}
+	void GetColliderT(std::pmr::vector<Collider>& out) const
 	{
 		// collider.GetTransformed(this->GetTransformM(), out);
 		std::visit([this, &out](isCollider auto& col) -> void
 				   { col.GetTransformed(this->GetTransformM(), out); },
-				   this->collider);
+				   this->ActiveCollider());
 	}
-	void GetColliderT(Matrix trans, vector<Collider>& out) const
+	void GetColliderT(Matrix trans, std::pmr::vector<Collider>& out) const
 	{
 		// collider->GetTransformed(trans, out);
 		std::visit([&out, trans](isCollider auto& col) -> void
-				   { col.GetTransformed(trans, out); }, this->collider);
+				   { col.GetTransformed(trans, out); },
+				   this->ActiveCollider());
+	}
+
+	/**
+	 * @brief Adds a collision LOD, used once the object is at least
+	 *        minDistance away from the position given to SelectColliderLOD().
+	 * @note LODs are optional, an object without any always uses the
+	 *       collider it was created with.
+	 */
+	void AddColliderLOD(const float minDistance, const Collider& col);
+	/**
+	 * @brief Adds a collision LOD made by simplifying the object's own
+	 *        collider, which keeps it enclosing the full detail shape.
+	 */
+	void AddColliderLOD(const float minDistance,
+						const SimplifySettings& settings);
+	/** @brief Switches to the coarsest LOD the viewer is far enough for. */
+	void SelectColliderLOD(const Vector3 viewer);
+	/** @returns The collider used for physics at the current LOD. */
+	auto ActiveCollider() const -> const Collider&
+	{
+		return this->bodies->ActiveCollider(this->Index());
 	}
-	/** @brief Sets the shader to use when drawing the object. */
-	void SetShader(const Shader& newShader)
+	/** @brief Sets the RenderCache material to draw the object with. */
+	void SetMaterial(const MaterialID newMaterial)
 	{
-		this->shader = newShader;
-		this->material.shader = this->shader;
+		this->bodies->renders[this->Index()].material = newMaterial;
 	}
 
-	friend void DisplayObjectInfo(PhysObject& obj);
-
 	private:
-	Mesh mesh;
-	Collider collider;
-	Material material;
-	Shader shader{};
-
-	Vector3 velocity{};
-	Matrix position;
-	Matrix rotation;
-	Matrix scale;
+	auto Index() const -> BodyID
+	{
+		return this->bodies->GetIndex(this->handle);
+	}
+
+	BodyStorage* bodies;
+	BodyHandle handle;
 };
 
 // NOTE: This struct needs to be reworked
@@ -159,23 +273,41 @@ class PhysObject
 struct HitObj
 {
 	public:
+	static constexpr uint32_t MAX_POINTS{ContactHit::MAX_POINTS};
+
+	/** @brief World space point of the deepest contact. */
 	Vector3 HitPos{};
-	const PhysObject* ThisCol{nullptr};
-	const PhysObject* OtherCol{nullptr};
+	PhysObject ThisCol;
+	PhysObject OtherCol;
+	/** @brief World space, pointing from ThisCol towards OtherCol. */
+	Vector3 Normal{};
+	float Penetration{};
+	/** @brief World space contact points, the first PointCount are used. */
+	std::array<Vector3, MAX_POINTS> Points{};
+	uint32_t PointCount{0};
+	/** @brief Either body is a sensor, so only the handles are filled in. */
+	bool IsSensor{false};
 };
 struct RaycastHit
 {
 	float hitDist{};
 	Vector3 hitPos{};
-	PhysObject* hitObj{nullptr};
+	PhysObject hitObj;
 };
 
 auto CheckCollision(const PhysObject& obj1, const PhysObject& obj2)
 	-> std::optional<HitObj>;
-void CheckFaceCollision(const Collider& colA, const Collider& colB,
-						const FaceHit faces1, const FaceHit faces2);
-auto CheckRaycast(const Ray ray, PhysObject& obj) -> std::optional<RaycastHit>;
+/**
+ * @returns The incident face clipped against the reference face, allocated
+ *          from the frame arena.
+ */
+auto CheckFaceCollision(const HullCollider& hull1, const HullCollider& hull2,
+						const FaceHit faces1, const FaceHit faces2)
+	-> std::pmr::vector<Vector3>;
+auto CheckRaycast(const Ray ray, const PhysObject& obj)
+	-> std::optional<RaycastHit>;
 
-auto CreateBoxObject(const Vector3 pos, const Vector3 dims) -> PhysObject;
+auto CreateBoxObject(BodyStorage& bodies, const Vector3 pos,
+					 const Vector3 dims) -> PhysObject;
 
 } //namespace phys
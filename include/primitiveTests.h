@@ -0,0 +1,95 @@
+#pragma once
+
+#include "collider.h"
+
+#include <array>
+#include <optional>
+#include <raylib.h>
+
+namespace phys
+{
+
+/**
+ * @brief Closed form collision tests between primitive colliders. Every test
+ *        returns std::nullopt if the pair is separated, and a ContactHit
+ *        whose normal points from the first argument to the second
+ *        otherwise.
+ */
+auto CheckSphereSphere(const SphereCollider& colA, const SphereCollider& colB)
+	-> std::optional<ContactHit>;
+auto CheckSphereCapsule(const SphereCollider& colA,
+						const CapsuleCollider& colB)
+	-> std::optional<ContactHit>;
+auto CheckSphereBox(const SphereCollider& colA, const BoxCollider& colB)
+	-> std::optional<ContactHit>;
+auto CheckSphereHull(const SphereCollider& colA, const HullCollider& colB)
+	-> std::optional<ContactHit>;
+auto CheckCapsuleCapsule(const CapsuleCollider& colA,
+						 const CapsuleCollider& colB)
+	-> std::optional<ContactHit>;
+auto CheckCapsuleBox(const CapsuleCollider& colA, const BoxCollider& colB)
+	-> std::optional<ContactHit>;
+auto CheckCapsuleHull(const CapsuleCollider& colA, const HullCollider& colB)
+	-> std::optional<ContactHit>;
+/**
+ * @brief Boolean GJK, on the same simplex solver as the distance queries
+ *        behind the rounded shape tests. Stops as soon as the origin is
+ *        enclosed or a support point fails to reach past it, and never
+ *        finds a normal, depth or contact points.
+ * @returns true if the shapes overlap.
+ * @note Instantiated for every pair of hull, sphere, capsule and box.
+ */
+template <typename ShapeA, typename ShapeB>
+auto CheckGJKOverlap(const ShapeA& colA, const ShapeB& colB) -> bool;
+/**
+ * @brief Separating axis test over the hull's face normals, the box's axes
+ *        and the crosses of the two's edge directions.
+ */
+auto CheckHullBox(const HullCollider& colA, const BoxCollider& colB)
+	-> std::optional<ContactHit>;
+/** @brief Separating axis test over the 15 candidate axes of two boxes. */
+auto CheckBoxBox(const BoxCollider& colA, const BoxCollider& colB)
+	-> std::optional<ContactHit>;
+
+/**
+ * @brief Tests one triangle of a TriangleMeshCollider against a convex shape.
+ *        A contact that would push the shape across an internal edge of the
+ *        mesh is turned to the triangle's face normal instead, so shapes
+ *        slide over flat seams and into concave corners without catching.
+ */
+auto CheckTriangleSphere(const MeshTriangle& tri, const SphereCollider& col)
+	-> std::optional<ContactHit>;
+auto CheckTriangleCapsule(const MeshTriangle& tri, const CapsuleCollider& col)
+	-> std::optional<ContactHit>;
+auto CheckTriangleBox(const MeshTriangle& tri, const BoxCollider& col)
+	-> std::optional<ContactHit>;
+auto CheckTriangleHull(const MeshTriangle& tri, const HullCollider& col)
+	-> std::optional<ContactHit>;
+
+/**
+ * @returns The distance along the ray to the first hit, if there is one. As
+ *          with hulls, rays starting inside the collider do not hit it.
+ */
+auto RaycastPrimitive(const Ray ray, const Collider& col)
+	-> std::optional<float>;
+/**
+ * @returns ray moved by trans, keeping the direction's length so distances
+ *          along it are the same in either space.
+ */
+auto GetLocalRay(const Ray ray, const Matrix& trans) -> Ray;
+/** @returns The reciprocal of each component, huge in place of zero. */
+auto GetInverseDir(const Vector3 dir) -> Vector3;
+/**
+ * @brief Slab test of a ray against a box, given the reciprocal of its
+ *        direction.
+ * @returns The distance at which the ray enters box, or starts if it is
+ *          already inside, if it does so within maxDist.
+ */
+auto RaycastBounds(const Vector3 origin, const Vector3 invDir,
+				   const BoundingBox& box, const float maxDist)
+	-> std::optional<float>;
+/** @returns The distance along the ray to the front of tri, if it hits. */
+auto RaycastTriangle(const Ray ray, const std::array<Vector3, 3>& tri)
+	-> std::optional<float>;
+
+} //namespace phys
@@ -1,8 +1,11 @@
 #pragma once
 
+#include "jobSystem.h"
 #include "physObject.h"
+#include "world.h"
 
 #include <imgui.h>
+#include <optional>
 #include <raylib.h>
 #include <vector>
 
@@ -22,17 +25,18 @@ class Program
 	void ProcessInput();
 
 	float deltaTime;
-	float gravity{1.0f};
-	vector<PhysObject> objects;
+	World world;
+	JobSystem jobs;
 	Camera cam;
 
-	PhysObject* selectedObj{nullptr};
+	std::optional<PhysObject> selectedObj;
 
 	ImGuiIO* imguiIO;
 
 	// NOTE: Remove when creating physics objects from meshes is properly
 	//       implemented.
 	void DebugAddStairObj(Vector3 pos);
+	void DebugAddTerrainObj(Vector3 pos);
 };
 void DrawGrid(const float lineLength, const int count);
 
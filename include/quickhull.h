@@ -0,0 +1,60 @@
+#pragma once
+
+#include "collider.h"
+#include "halfEdge.h"
+
+#include <cstdint>
+#include <raylib.h>
+#include <raymath.h>
+#include <span>
+#include <vector>
+
+namespace phys
+{
+
+using std::vector;
+
+/** @brief Tuning parameters for convex hull generation. */
+struct HullSettings
+{
+	/** @brief Input vertices closer than this are welded into one. */
+	float weldDistance{0.0001f};
+	/**
+	 * @brief Distance a point must lie above a face to be considered outside
+	 *        of it. A value of 0 derives a tolerance from the input extents.
+	 */
+	float epsilon{0.0f};
+	/** @brief Faces whose normals differ by less than this are merged. */
+	float mergeAngle{0.5f * DEG2RAD};
+	/**
+	 * @brief Stops adding points once the hull has this many vertices, taking
+	 *        the furthest remaining point first. The result may no longer
+	 *        contain every input point. 0 means unlimited.
+	 */
+	uint32_t maxVertices{0};
+};
+
+/**
+ * @brief Computes the convex hull of a point cloud using quickhull.
+ *
+ * @param points The input points. Duplicates are welded before hull
+ *        construction.
+ * @param vertsOut Receives the hull's vertices.
+ * @param facesOut Receives the hull's faces, with coplanar triangles merged
+ *        into polygons and wound to match the HullCollider constructor.
+ * @returns false if the input is degenerate (flat, collinear or a single
+ *          point), in which case the outputs are left empty.
+ */
+auto ComputeConvexHull(std::span<const Vector3> points,
+					   vector<HE::HVertex>& vertsOut,
+					   vector<HE::FaceInit>& facesOut,
+					   const HullSettings& settings = {}) -> bool;
+
+/**
+ * @brief Creates a convex hull collider enclosing every vertex of a mesh.
+ * @note Degenerate meshes fall back to a box around their bounds.
+ */
+auto CreateHullCollider(const Mesh& mesh, const HullSettings& settings = {})
+	-> Collider;
+
+} //namespace phys
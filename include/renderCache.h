@@ -0,0 +1,128 @@
+#pragma once
+
+#include <compare>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <raylib.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace phys
+{
+
+/** @brief Index of a mesh in the RenderCache. */
+using MeshID = uint32_t;
+/**
+ * @brief Stands in for a mesh on bodies that are never drawn, which lets
+ *        them be made without a window or the RenderCache.
+ */
+constexpr MeshID NO_MESH{UINT32_MAX};
+/** @brief Index of a material in the RenderCache. */
+using MaterialID = uint32_t;
+
+/** @brief Shapes the RenderCache can generate meshes for. */
+enum class MeshShape : uint8_t
+{
+	CUBE,
+};
+
+/**
+ * @brief Owns the GPU resources bodies are drawn with, so bodies of the same
+ *        shape share one uploaded mesh and one material.
+ *
+ * Meshes are reference counted, and unloaded when the last body using them
+ * is removed. Materials are never unloaded, since their shaders are cheap to
+ * keep and likely to be used again.
+ *
+ * A material whose shader has an instanceTransform attribute is drawn
+ * instanced, with every body sharing its mesh in a single draw call.
+ *
+ * @note Only the render thread may use the cache, and only once the window
+ *       is open. It leaves everything loaded on exit, when the GL context is
+ *       already gone.
+ */
+class RenderCache
+{
+	public:
+	/**
+	 * @brief Generates and uploads a mesh the first time a shape and size is
+	 *        asked for, and shares it after that.
+	 * @returns A new reference to the mesh, released by ReleaseMesh().
+	 */
+	auto AcquireMesh(const MeshShape shape, const Vector3 dims) -> MeshID;
+	/**
+	 * @brief Takes ownership of a mesh nothing else shares, uploading it if
+	 *        it has not been already.
+	 * @returns The only reference to the mesh, released by ReleaseMesh().
+	 */
+	auto AddMesh(Mesh mesh) -> MeshID;
+	/** @brief Unloads the mesh once its last reference is released. */
+	void ReleaseMesh(const MeshID id);
+	auto GetMesh(const MeshID id) const -> const Mesh&
+	{
+		return this->meshes[id].mesh;
+	}
+	/** @returns The number of meshes that are still in use. */
+	auto GetMeshCount() const -> uint32_t
+	{
+		return static_cast<uint32_t>(this->meshes.size()
+									 - this->freeMeshes.size());
+	}
+
+	/** @returns The material bodies are drawn with unless told otherwise. */
+	auto GetDefaultMaterial() -> MaterialID;
+	/**
+	 * @brief Loads the shader the first time a pair of files is asked for,
+	 *        and shares its material after that.
+	 */
+	auto LoadMaterial(const char* vertShader, const char* fragShader)
+		-> MaterialID;
+	/** @returns The material drawing with an already loaded shader. */
+	auto AddMaterial(const Shader& shader) -> MaterialID;
+	auto GetMaterial(const MaterialID id) const -> const Material&
+	{
+		return this->materials[id];
+	}
+	/** @returns true if the material's shader draws instanced meshes. */
+	auto IsInstanced(const MaterialID id) const -> bool
+	{
+		return this->materials[id].shader.locs[SHADER_LOC_VERTEX_INSTANCE_TX]
+			   != -1;
+	}
+
+	private:
+	struct MeshKey
+	{
+		MeshShape shape;
+		float x;
+		float y;
+		float z;
+
+		auto operator<=>(const MeshKey&) const = default;
+	};
+	struct MeshEntry
+	{
+		Mesh mesh;
+		uint32_t refs;
+		/** @brief Empty for meshes that were added rather than generated. */
+		std::optional<MeshKey> key;
+	};
+
+	auto NewMeshEntry() -> MeshID;
+	auto NewMaterial(const Shader& shader) -> MaterialID;
+
+	std::vector<MeshEntry> meshes;
+	std::vector<MeshID> freeMeshes;
+	std::map<MeshKey, MeshID> meshKeys;
+
+	std::vector<Material> materials;
+	std::map<std::pair<std::string, std::string>, MaterialID> shaderFiles;
+	std::optional<MaterialID> defaultMaterial;
+};
+
+/** @returns The cache every body's render resources come from. */
+auto GetRenderCache() -> RenderCache&;
+
+} //namespace phys
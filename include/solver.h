@@ -0,0 +1,140 @@
+#pragma once
+
+#include "bodyStorage.h"
+#include "integrate.h"
+#include "jobSystem.h"
+#include "physObject.h"
+
+#include <array>
+#include <cstdint>
+#include <raylib.h>
+#include <span>
+#include <vector>
+
+namespace phys
+{
+
+using std::vector;
+
+/** @brief A group of dynamic bodies connected through their contacts. */
+struct Island
+{
+	/** @brief The island's contacts in ContactSolver::contacts order. */
+	uint32_t contactOffset;
+	uint32_t contactCount;
+	/** @brief The island's bodies in ascending BodyID order. */
+	uint32_t bodyOffset;
+	uint32_t bodyCount;
+};
+
+/**
+ * @brief Pushes touching bodies apart with sequential impulses.
+ *
+ * Each step the contacts are split into islands, the groups of dynamic
+ * bodies that touch each other directly or through other dynamic bodies.
+ * Static and kinematic bodies are never pushed, so they join no island and
+ * an entire floor of separate piles splits into one island per pile. No two
+ * islands share a body that gets written to, so they are solved in parallel
+ * on a JobSystem, largest first so the big ones do not end up last. Each
+ * island copies its bodies into its thread's FrameArena, solves there and
+ * writes the velocities back.
+ *
+ * Within an island the contact points are greedily coloured so that no two
+ * points of a colour share a body. A colour can then be solved SIMD lanes at
+ * a time, and colours are solved in turn, so every point still sees the
+ * impulses of the colours before it. That does nothing for a single huge
+ * pile, so islands with enough contacts are solved one after another, each
+ * sharing every colour out over all of the threads.
+ *
+ * Colours and their order only depend on the order contacts were added and
+ * bodies are stored in, and points of a colour never affect each other, so
+ * an island's result is the same however many threads there are.
+ *
+ * @note Bodies are treated as solid boxes filling their bounds, with the
+ *       centre of mass at their origin.
+ */
+class ContactSolver
+{
+	public:
+	/** @brief Drops the last step's contacts. */
+	void BeginStep() { this->contacts.clear(); }
+	/** @brief Records a contact to solve. Sensor hits are ignored. */
+	void AddContact(const HitObj& hit);
+	/**
+	 * @brief Changes the velocities of the dynamic bodies so the contacts
+	 *        added this step stop closing, and the penetrating ones part.
+	 * @param jobs Solves the islands in parallel, or nullptr to solve them
+	 *        all on the calling thread. Either gives the same result.
+	 */
+	void Solve(BodyStorage& bodies, const float deltaTime, JobSystem* jobs);
+
+	void SetIterations(const uint32_t count) { this->iterations = count; }
+	/** @brief The Coulomb friction coefficient of every contact. */
+	void SetFriction(const float coefficient)
+	{
+		this->friction = coefficient;
+	}
+	/** @brief Defaults to the fastest kernel the CPU supports. */
+	void SetKernel(const IntegrateKernel newKernel)
+	{
+		this->kernel = newKernel;
+	}
+	/** @returns The islands of the last Solve(), largest first. */
+	auto GetIslands() const -> std::span<const Island>
+	{
+		return this->islands;
+	}
+
+	private:
+	struct Contact
+	{
+		/** @brief Pushed along -normal. */
+		BodyHandle handle1;
+		/** @brief Pushed along normal. */
+		BodyHandle handle2;
+		/** @brief Looked up from the handles by BuildIslands(). */
+		BodyID body1;
+		BodyID body2;
+		/** @brief Index into islands, or NO_ISLAND. */
+		uint32_t island;
+		Vector3 normal;
+		float depth;
+		std::array<Vector3, HitObj::MAX_POINTS> points;
+		uint32_t pointCount;
+	};
+
+	/** @brief Groups the contacts and their bodies into islands. */
+	void BuildIslands(const BodyStorage& bodies);
+	/** @brief Union-find root of a dynamic body, halving paths on the way. */
+	auto FindRoot(BodyID id) -> BodyID;
+	/**
+	 * @brief Colours the island's contact points so no two of a colour share
+	 *        a body, then solves each colour SIMD lanes at a time.
+	 * @param jobs Spreads each colour over its threads, or nullptr to solve
+	 *        the island on the calling thread alone.
+	 */
+	void SolveIsland(BodyState& state, const Island& island,
+					 const float deltaTime, JobSystem* jobs) const;
+
+	static constexpr uint32_t NO_ISLAND{UINT32_MAX};
+
+	vector<Contact> contacts;
+
+	// Island scratch, kept to avoid reallocating every step
+	/** @brief Union-find parent of each moving body. */
+	vector<BodyID> parents;
+	/** @brief The island of each union-find root, or NO_ISLAND. */
+	vector<uint32_t> rootIslands;
+	/** @brief The index of each dynamic body within its island. */
+	vector<uint32_t> localIndices;
+	vector<Island> islands;
+	/** @brief Indices into contacts, grouped by island. */
+	vector<uint32_t> islandContacts;
+	vector<BodyID> islandBodies;
+
+	uint32_t iterations{8};
+	float friction{0.5f};
+	IntegrateKernel kernel{GetBestKernel()};
+};
+
+} //namespace phys
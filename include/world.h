@@ -0,0 +1,97 @@
+#pragma once
+
+#include "bodyStorage.h"
+#include "collider.h"
+#include "contactEvents.h"
+#include "jobSystem.h"
+#include "physObject.h"
+#include "solver.h"
+
+#include <cstdint>
+#include <raylib.h>
+#include <span>
+#include <vector>
+
+namespace phys
+{
+
+using std::vector;
+
+/**
+ * @brief A self contained simulation of bodies, their contacts and the
+ *        solver pushing them apart, with no window, camera or renderer.
+ *
+ * Worlds share nothing they write to, so any number of them can be stepped
+ * at once on different threads. Hull geometry is interned in the
+ * HullRegistry as bodies are added, so worlds built from the same assets
+ * all point at one read only copy of each hull instead of their own.
+ */
+class World
+{
+	public:
+	/**
+	 * @brief Adds a body that is never drawn, so it needs no RenderCache.
+	 *        It starts out static.
+	 */
+	auto AddBody(const Vector3 pos, const Collider& col) -> PhysObject
+	{
+		return {this->bodies, pos, NO_MESH, col};
+	}
+	auto GetBodies() -> BodyStorage& { return this->bodies; }
+	auto GetBodies() const -> const BodyStorage& { return this->bodies; }
+	/** @returns What touched in the last Step(). */
+	auto GetContacts() const -> const ContactTracker&
+	{
+		return this->contacts;
+	}
+	auto GetSolver() -> ContactSolver& { return this->solver; }
+	void SetGravity(const Vector3 newGravity) { this->gravity = newGravity; }
+
+	/**
+	 * @brief Moves the bodies, then finds their contacts and solves them.
+	 *        Scratch memory comes from the calling thread's FrameArena, and
+	 *        debug geometry goes to its buffer unless a DebugDrawPause is
+	 *        alive, as it is in BatchStep().
+	 * @param jobs Threads to solve islands on, or nullptr to do everything
+	 *        on the calling thread. Either gives the same result.
+	 */
+	void Step(const float deltaTime, JobSystem* jobs = nullptr);
+
+	private:
+	BodyStorage bodies;
+	ContactTracker contacts;
+	ContactSolver solver;
+	Vector3 gravity{0.0f, -9.8f, 0.0f};
+	/** @brief Step() scratch, kept to avoid reallocating every step. */
+	vector<BodyPair> pairs;
+};
+
+/** @brief What a BatchStep() got through. */
+struct BatchStats
+{
+	uint32_t worldCount{0};
+	/** @brief Kinematic and dynamic bodies stepped, over every world. */
+	uint64_t bodySteps{0};
+	double seconds{0.0};
+
+	auto GetBodyStepsPerSecond() const -> double
+	{
+		return this->seconds > 0.0
+				   ? static_cast<double>(this->bodySteps) / this->seconds
+				   : 0.0;
+	}
+};
+
+/**
+ * @brief Steps every world once, spread over the threads of jobs. Each world
+ *        is stepped whole by one thread, the ones with the most moving
+ *        bodies first, so a world's result does not depend on the others or
+ *        on how many threads there are.
+ * @note Each thread's FrameArena is reset after every world it steps, the
+ *       calling thread's included, so nothing allocated from it before the
+ *       call may be used after it. No debug geometry is recorded.
+ */
+auto BatchStep(std::span<World> worlds, const float deltaTime,
+			   JobSystem& jobs) -> BatchStats;
+
+} //namespace phys
@@ -0,0 +1,30 @@
+#version 330
+
+in vec3 vertexPosition;
+in vec2 vertexTexCoord;
+in vec3 vertexNormal;
+in vec4 vertexColor;
+in mat4 instanceTransform;
+
+uniform mat4 mvp;
+
+out vec3 fragPosition;
+out vec2 fragTexCoord;
+out vec4 fragColor;
+out vec3 fragNormal;
+
+void main()
+{
+    // Cofactors of the model matrix, the inverse transpose up to a scale
+    mat3 model = mat3(instanceTransform);
+    mat3 matNormal = mat3(cross(model[1], model[2]),
+                          cross(model[2], model[0]),
+                          cross(model[0], model[1]));
+
+    fragPosition = vec3(instanceTransform * vec4(vertexPosition, 1.0f));
+    fragTexCoord = vertexTexCoord;
+    fragColor = vertexColor;
+    fragNormal = normalize(matNormal * vertexNormal);
+
+    gl_Position = mvp * instanceTransform * vec4(vertexPosition, 1.0f);
+}
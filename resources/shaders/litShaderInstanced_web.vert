@@ -0,0 +1,28 @@
+#version 100
+
+attribute vec3 vertexPosition;
+attribute vec2 vertexTexCoord;
+attribute vec3 vertexNormal;
+attribute mat4 instanceTransform;
+
+uniform mat4 mvp;
+
+varying vec3 fragPosition;
+varying vec2 fragTexCoord;
+varying vec3 fragNormal;
+
+void main()
+{
+    // Cofactors of the model matrix, the inverse transpose up to a scale
+    mat3 model = mat3(instanceTransform[0].xyz, instanceTransform[1].xyz,
+                      instanceTransform[2].xyz);
+    mat3 matNormal = mat3(cross(model[1], model[2]),
+                          cross(model[2], model[0]),
+                          cross(model[0], model[1]));
+
+    fragPosition = vec3(instanceTransform * vec4(vertexPosition, 1.0));
+    fragTexCoord = vertexTexCoord;
+    fragNormal = normalize(matNormal * vertexNormal);
+
+    gl_Position = mvp * instanceTransform * vec4(vertexPosition, 1.0);
+}
@@ -0,0 +1,466 @@
+#include "bodyStorage.h"
+#include "collider.h"
+#include "debugDraw.h"
+#include "hullRegistry.h"
+#include "integrate.h"
+#include "renderCache.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <raylib.h>
+#include <raymath.h>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace phys
+{
+
+auto BodyPairHash::operator()(const BodyPair& pair) const -> size_t
+{
+	auto pack = [](const BodyHandle handle) -> uint64_t
+	{
+		return (static_cast<uint64_t>(handle.generation) << 32U)
+			   | handle.slot;
+	};
+	// Mix the halves so pairs sharing a body do not collide
+	uint64_t hash{pack(pair.first) * 0x9e3779b97f4a7c15};
+	hash ^= std::rotl(pack(pair.second), 31) * 0xbf58476d1ce4e5b9;
+	return hash ^ (hash >> 29U);
+}
+
+auto BodyStorage::Add(const Vector3 pos, const MeshID mesh, const Collider& col)
+	-> BodyHandle
+{
+	const BodyID id{this->Size()};
+	BodyHandle handle;
+	if (this->freeSlot != BodyHandle::INVALID_SLOT)
+	{
+		handle.slot = this->freeSlot;
+		this->freeSlot = this->slots[handle.slot].index;
+	}
+	else
+	{
+		handle.slot = static_cast<uint32_t>(this->slots.size());
+		this->slots.push_back({.index = 0, .generation = 0});
+	}
+	handle.generation = this->slots[handle.slot].generation;
+	this->slots[handle.slot].index = id;
+	this->handles.push_back(handle);
+
+	this->state.positions.PushBack(pos);
+	this->state.rotations.PushBack(QuaternionIdentity());
+	this->state.scales.PushBack({1.0f, 1.0f, 1.0f});
+	this->state.velocities.PushBack(Vector3Zero());
+	this->state.angularVelocities.PushBack(Vector3Zero());
+	this->state.inverseMasses.push_back(0.0f);
+	this->state.localCentres.PushBack(Vector3Zero());
+	this->state.localExtents.PushBack(Vector3Zero());
+	this->state.boundsMin.PushBack(pos);
+	this->state.boundsMax.PushBack(pos);
+	this->state.matrixFlags.push_back(WORLD_DIRTY | INVERSE_DIRTY);
+	this->colliders.push_back(col);
+	GetHullRegistry().Intern(this->colliders.back());
+	this->activeLODs.push_back(0);
+	this->flags.push_back(0);
+	this->filters.emplace_back();
+	this->worlds.emplace_back();
+	this->inverseWorlds.emplace_back();
+	this->colliderLODs.emplace_back();
+	// Headless bodies never reach the cache, as it needs a window
+	this->renders.push_back(
+		{.mesh = mesh,
+		 .material = mesh == NO_MESH ? MaterialID{0}
+									 : GetRenderCache().GetDefaultMaterial()});
+
+	this->UpdateLocalBounds(id);
+	return handle;
+}
+auto BodyStorage::Remove(const BodyHandle handle) -> bool
+{
+	if (!this->IsValid(handle))
+		return false;
+	BodyID id{this->slots[handle.slot].index};
+	if (this->renders[id].mesh != NO_MESH)
+	{
+		GetRenderCache().ReleaseMesh(this->renders[id].mesh);
+	}
+	if (id < this->movingCount)
+	{
+		// Swap it to the end of the moving range, which then becomes the
+		// start of the static range
+		this->movingCount--;
+		this->SwapBodies(id, this->movingCount);
+		id = this->movingCount;
+	}
+	else
+	{
+		this->staticTreeDirty = true;
+	}
+	const BodyID last{this->Size() - 1};
+
+	// Move the last body into the hole, then point its slot at its new index
+	auto swapRemove = [id](auto& arr) -> void
+	{
+		arr[id] = std::move(arr.back());
+		arr.pop_back();
+	};
+	this->state.SwapRemove(id);
+	swapRemove(this->colliders);
+	swapRemove(this->activeLODs);
+	swapRemove(this->flags);
+	swapRemove(this->filters);
+	swapRemove(this->worlds);
+	swapRemove(this->inverseWorlds);
+	swapRemove(this->colliderLODs);
+	swapRemove(this->renders);
+	swapRemove(this->handles);
+	if (id != last)
+	{
+		this->slots[this->handles[id].slot].index = id;
+	}
+
+	if (!this->ignoredPairs.empty())
+	{
+		auto involves = [handle](const BodyPair& pair) -> bool
+		{
+			return pair.first == handle || pair.second == handle;
+		};
+		std::erase_if(this->ignoredPairs, involves);
+	}
+
+	BodySlot& slot{this->slots[handle.slot]};
+	slot.generation++;
+	slot.index = this->freeSlot;
+	this->freeSlot = handle.slot;
+	return true;
+}
+void BodyStorage::SetType(const BodyHandle handle, const BodyType type)
+{
+	BodyID id{this->GetIndex(handle)};
+	const bool wasStatic{id >= this->movingCount};
+	if (type == BodyType::STATIC)
+	{
+		this->state.velocities.Set(id, Vector3Zero());
+		this->state.angularVelocities.Set(id, Vector3Zero());
+		this->state.inverseMasses[id] = 0.0f;
+		if (!wasStatic)
+		{
+			this->movingCount--;
+			this->SwapBodies(id, this->movingCount);
+			this->BakeStatic(this->movingCount);
+		}
+		return;
+	}
+	if (wasStatic)
+	{
+		this->SwapBodies(id, this->movingCount);
+		id = this->movingCount;
+		this->movingCount++;
+		this->staticTreeDirty = true;
+	}
+	float& inverseMass{this->state.inverseMasses[id]};
+	if (type == BodyType::KINEMATIC)
+	{
+		inverseMass = 0.0f;
+	}
+	else if (inverseMass <= 0.0f)
+	{
+		inverseMass = 1.0f;
+	}
+}
+auto BodyStorage::GetType(const BodyHandle handle) const -> BodyType
+{
+	const BodyID id{this->GetIndex(handle)};
+	if (id >= this->movingCount)
+		return BodyType::STATIC;
+	return this->state.inverseMasses[id] > 0.0f ? BodyType::DYNAMIC
+												: BodyType::KINEMATIC;
+}
+void BodyStorage::Reserve(const uint32_t count)
+{
+	this->state.Reserve(count);
+	this->colliders.reserve(count);
+	this->activeLODs.reserve(count);
+	this->flags.reserve(count);
+	this->filters.reserve(count);
+	this->worlds.reserve(count);
+	this->inverseWorlds.reserve(count);
+	this->colliderLODs.reserve(count);
+	this->renders.reserve(count);
+	this->handles.reserve(count);
+	this->slots.reserve(count);
+}
+
+void BodyStorage::Integrate(const float deltaTime, const Vector3 gravity)
+{
+	const IntegrateParams params{
+		.deltaTime = deltaTime,
+		.gravity = gravity,
+		.linearDamping = std::exp(-this->linearDamping * deltaTime),
+		.angularDamping = std::exp(-this->angularDamping * deltaTime)};
+	IntegrateBodies(this->kernel, this->state, params, this->movingCount);
+}
+void BodyStorage::SetPairIgnored(BodyHandle handle1, BodyHandle handle2,
+								 const bool ignored)
+{
+	assert(this->IsValid(handle1) && this->IsValid(handle2));
+	if (handle2 < handle1)
+	{
+		std::swap(handle1, handle2);
+	}
+	if (ignored)
+	{
+		this->ignoredPairs.emplace(handle1, handle2);
+	}
+	else
+	{
+		this->ignoredPairs.erase({handle1, handle2});
+	}
+}
+void BodyStorage::GetOverlappingPairs(vector<BodyPair>& out) const
+{
+	auto addPair = [this, &out](const BodyID a, const BodyID b) -> void
+	{
+		const BodyPair pair{std::minmax(this->handles[a], this->handles[b])};
+		if (!this->IsPairIgnored(pair.first, pair.second))
+		{
+			out.push_back(pair);
+		}
+	};
+
+	// Moving bodies against each other
+	vector<BodyID> order(this->movingCount);
+	std::iota(order.begin(), order.end(), 0U);
+	std::ranges::sort(order, {},
+					  [this](const BodyID id) -> float
+					  { return this->state.boundsMin.x[id]; });
+	for (uint32_t i{0}; i < order.size(); i++)
+	{
+		const BoundingBox boundsA{this->state.GetBounds(order[i])};
+		const CollisionFilter filterA{this->filters[order[i]]};
+		// Everything after the first body starting past this one's end on x
+		// is sorted even further away
+		for (uint32_t j{i + 1}; j < order.size(); j++)
+		{
+			if (this->state.boundsMin.x[order[j]] > boundsA.max.x)
+				break;
+			if (!filterA.Accepts(this->filters[order[j]]))
+				continue;
+			if (CheckCollisionBoxes(boundsA, this->state.GetBounds(order[j])))
+			{
+				addPair(order[i], order[j]);
+			}
+		}
+	}
+
+	// Moving bodies against the static tree
+	this->UpdateStaticTree();
+	if (this->staticTree.empty())
+		return;
+	vector<uint32_t> stack;
+	for (BodyID id{0}; id < this->movingCount; id++)
+	{
+		const BoundingBox bounds{this->state.GetBounds(id)};
+		const CollisionFilter filter{this->filters[id]};
+		stack.assign(1, 0);
+		while (!stack.empty())
+		{
+			const BoundsNode& node{this->staticTree[stack.back()]};
+			stack.pop_back();
+			if (node.isLeaf)
+			{
+				const BodyID other{this->slots[node.first].index};
+				if (filter.Accepts(this->filters[other])
+					&& CheckCollisionBoxes(bounds, node.bounds))
+				{
+					addPair(id, other);
+				}
+				continue;
+			}
+			if (!CheckCollisionBoxes(bounds, node.bounds))
+				continue;
+			stack.push_back(node.first);
+			stack.push_back(node.first + 1);
+		}
+	}
+}
+void BodyStorage::DebugDrawBounds() const
+{
+	if (!IsDebugDrawEnabled(DEBUG_AABBS))
+		return;
+	for (BodyID id{0}; id < this->Size(); id++)
+	{
+		DebugBox(DEBUG_AABBS, this->state.GetBounds(id), {255, 255, 0, 255});
+	}
+}
+void BodyStorage::Draw() const
+{
+	const RenderCache& cache{GetRenderCache()};
+	// Group the bodies drawn with the same mesh and material together
+	auto& order{this->drawOrder};
+	order.resize(this->Size());
+	std::iota(order.begin(), order.end(), 0U);
+	std::ranges::sort(order, {},
+					  [this](const BodyID id) -> std::pair<uint32_t, uint32_t>
+					  {
+						  return {this->renders[id].material,
+								  this->renders[id].mesh};
+					  });
+
+	this->drawCalls = 0;
+	for (uint32_t first{0}; first < order.size();)
+	{
+		const BodyRender render{this->renders[order[first]]};
+		uint32_t last{first + 1};
+		while (last < order.size() && this->renders[order[last]] == render)
+		{
+			last++;
+		}
+		if (render.mesh == NO_MESH)
+		{
+			first = last;
+			continue;
+		}
+		const Mesh& mesh{cache.GetMesh(render.mesh)};
+		const Material& material{cache.GetMaterial(render.material)};
+		if (cache.IsInstanced(render.material))
+		{
+			this->instanceTransforms.clear();
+			for (uint32_t i{first}; i < last; i++)
+			{
+				this->instanceTransforms.push_back(
+					this->GetTransformM(order[i]));
+			}
+			DrawMeshInstanced(mesh, material, this->instanceTransforms.data(),
+							  static_cast<int>(last - first));
+			this->drawCalls++;
+		}
+		else
+		{
+			for (uint32_t i{first}; i < last; i++)
+			{
+				DrawMesh(mesh, material, this->GetTransformM(order[i]));
+				this->drawCalls++;
+			}
+		}
+		first = last;
+	}
+}
+
+auto BodyStorage::GetTransformM(const BodyID id) const -> const Matrix&
+{
+	if ((this->state.matrixFlags[id] & WORLD_DIRTY) != 0)
+	{
+		const Vector3 scale{this->state.scales.Get(id)};
+		const Vector3 pos{this->state.positions.Get(id)};
+		this->worlds[id] = MatrixScale(scale.x, scale.y, scale.z)
+						   * QuaternionToMatrix(this->state.rotations.Get(id))
+						   * MatrixTranslate(pos.x, pos.y, pos.z);
+		this->state.matrixFlags[id] &= static_cast<uint8_t>(~WORLD_DIRTY);
+	}
+	return this->worlds[id];
+}
+auto BodyStorage::GetInverseTransformM(const BodyID id) const -> const Matrix&
+{
+	if ((this->state.matrixFlags[id] & INVERSE_DIRTY) != 0)
+	{
+		// Undo the translation, then the rotation by its conjugate, then the
+		// scale, which only scales the rows of the transposed rotation
+		const Vector3 scale{this->state.scales.Get(id)};
+		const Quaternion rot{this->state.rotations.Get(id)};
+		Matrix inverse{QuaternionToMatrix(QuaternionInvert(rot))};
+		inverse.m0 /= scale.x;
+		inverse.m4 /= scale.x;
+		inverse.m8 /= scale.x;
+		inverse.m1 /= scale.y;
+		inverse.m5 /= scale.y;
+		inverse.m9 /= scale.y;
+		inverse.m2 /= scale.z;
+		inverse.m6 /= scale.z;
+		inverse.m10 /= scale.z;
+		const Vector3 pos{this->state.positions.Get(id)};
+		const Vector3 offset{Vector3Transform(Vector3Negate(pos), inverse)};
+		inverse.m12 = offset.x;
+		inverse.m13 = offset.y;
+		inverse.m14 = offset.z;
+		this->inverseWorlds[id] = inverse;
+		this->state.matrixFlags[id] &= static_cast<uint8_t>(~INVERSE_DIRTY);
+	}
+	return this->inverseWorlds[id];
+}
+void BodyStorage::UpdateLocalBounds(const BodyID id)
+{
+	auto getBounds = [](const isCollider auto& col) -> BoundingBox
+	{ return col.GetBounds(); };
+	const BoundingBox bounds{std::visit(getBounds, this->ActiveCollider(id))};
+	this->state.localCentres.Set(id, (bounds.min + bounds.max) * 0.5f);
+	this->state.localExtents.Set(id, (bounds.max - bounds.min) * 0.5f);
+	if (id >= this->movingCount)
+	{
+		this->BakeStatic(id);
+	}
+}
+void BodyStorage::BakeStatic(const BodyID id)
+{
+	const Vector3 centre{this->state.localCentres.Get(id)};
+	const Vector3 extents{this->state.localExtents.Get(id)};
+	const BoundingBox bounds{TransformBounds(
+		{.min = centre - extents, .max = centre + extents},
+		this->GetTransformM(id))};
+	this->GetInverseTransformM(id);
+	this->state.boundsMin.Set(id, bounds.min);
+	this->state.boundsMax.Set(id, bounds.max);
+	this->staticTreeDirty = true;
+}
+void BodyStorage::SwapBodies(const BodyID a, const BodyID b)
+{
+	if (a == b)
+		return;
+	this->state.Swap(a, b);
+	std::swap(this->colliders[a], this->colliders[b]);
+	std::swap(this->activeLODs[a], this->activeLODs[b]);
+	std::swap(this->flags[a], this->flags[b]);
+	std::swap(this->filters[a], this->filters[b]);
+	std::swap(this->worlds[a], this->worlds[b]);
+	std::swap(this->inverseWorlds[a], this->inverseWorlds[b]);
+	std::swap(this->colliderLODs[a], this->colliderLODs[b]);
+	std::swap(this->renders[a], this->renders[b]);
+	std::swap(this->handles[a], this->handles[b]);
+	this->slots[this->handles[a].slot].index = a;
+	this->slots[this->handles[b].slot].index = b;
+}
+void BodyStorage::UpdateStaticTree() const
+{
+	if (!this->staticTreeDirty)
+		return;
+	this->staticTreeDirty = false;
+	this->staticTree.clear();
+	const uint32_t count{this->Size() - this->movingCount};
+	if (count == 0)
+		return;
+	vector<BoundingBox> boxes;
+	boxes.reserve(count);
+	for (BodyID id{this->movingCount}; id < this->Size(); id++)
+	{
+		boxes.push_back(this->state.GetBounds(id));
+	}
+	vector<uint32_t> ids(count);
+	std::iota(ids.begin(), ids.end(), 0U);
+	this->staticTree.reserve((count * 2) - 1);
+	this->staticTree.resize(1);
+	BuildBoundsTree(ids, boxes, 0, this->staticTree);
+	for (BoundsNode& node : this->staticTree)
+	{
+		if (node.isLeaf)
+		{
+			node.first = this->handles[this->movingCount + node.first].slot;
+		}
+	}
+}
+
+} //namespace phys
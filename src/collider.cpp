@@ -1,18 +1,24 @@
 #include "collider.h"
+#include "colliderCache.h"
+#include "debugDraw.h"
 #include "halfEdge.h"
 #include "utils.h"
 
 #include <algorithm>
+#include <array>
 #include <cassert>
+#include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <format>
 #include <iterator>
 #include <limits>
-#include <map>
+#include <memory_resource>
+#include <numeric>
 #include <ranges>
 #include <raylib.h>
 #include <raymath.h>
-#include <set>
+#include <span>
 #include <utility>
 #include <variant>
 #include <vector>
@@ -35,8 +41,8 @@ using std::vector;
 using std::ostream;
 #endif
 
-auto GetEdgeCrosses(const HullCollider& col1, const HullCollider& col2)
-	-> vector<Vector3Tuple>
+void GetEdgeCrosses(const HullCollider& col1, const HullCollider& col2,
+					std::pmr::vector<Vector3Tuple>& out)
 {
 	auto crosses = [](auto pair) -> Vector3Tuple
 	{
@@ -48,10 +54,12 @@ auto GetEdgeCrosses(const HullCollider& col1, const HullCollider& col2)
 	{
 		return !Vector3Equivalent(std::get<0>(pair), std::get<1>(pair));
 	};
-	return rv::cartesian_product(col1.edgeDirs, col2.edgeDirs)
-		   | rv::filter(deDupe)
-		   | rv::transform(crosses)
-		   | r::to<std::vector<Vector3Tuple>>();
+	out.reserve(out.size()
+				+ (col1.GetEdgeDirs().size() * col2.GetEdgeDirs().size()));
+	r::copy(rv::cartesian_product(col1.GetEdgeDirs(), col2.GetEdgeDirs())
+				| rv::filter(deDupe)
+				| rv::transform(crosses),
+			std::back_inserter(out));
 }
 auto GetClosestPoints(const EdgeHit hit) -> std::pair<Vector3, Vector3>
 {
@@ -70,141 +78,193 @@ auto GetClosestPoints(const EdgeHit hit) -> std::pair<Vector3, Vector3>
 	return {point1, point2};
 }
 
+HullGeometry::HullGeometry(const HullGeometry& copy) :
+	edgeDirs(copy.edgeDirs), origin(copy.origin), bounds(copy.bounds)
+{
+	this->vertices.reserve(copy.vertices.size());
+	for (auto vert : copy.vertices)
+	{
+		vert.edgeArr = &this->edges;
+		this->vertices.push_back(vert);
+	}
+	this->edges.reserve(copy.edges.size());
+	for (auto edge : copy.edges)
+	{
+		edge.vertArr = &this->vertices;
+		edge.edgeArr = &this->edges;
+		edge.faceArr = &this->faces;
+		this->edges.push_back(edge);
+	}
+	this->faces.reserve(copy.faces.size());
+	for (auto face : copy.faces)
+	{
+		face.edgeArr = &this->edges;
+		this->faces.push_back(face);
+	}
+}
+void HullGeometry::UpdateBounds()
+{
+	this->bounds = {
+		.min = Vector3{1.0f, 1.0f, 1.0f} * std::numeric_limits<float>::max(),
+		.max = Vector3{1.0f, 1.0f, 1.0f} * -std::numeric_limits<float>::max(),
+	};
+	for (const auto& vert : this->vertices)
+	{
+		this->bounds.min = Vector3Min(this->bounds.min, vert.Vec());
+		this->bounds.max = Vector3Max(this->bounds.max, vert.Vec());
+	}
+}
+
 HullCollider::HullCollider(const vector<HE::HVertex>& verts,
 						   const vector<HE::FaceInit>& faces,
-						   const Vector3 origin) : origin(origin)
+						   const Vector3 origin)
 {
 #ifndef NDEBUG
 	// std::cout << "new hull\n";
 #endif // NDEBUG
 
-	auto initVerts = [this](auto vert) -> auto
+	auto hull{std::make_shared<HullGeometry>()};
+	hull->origin = origin;
+	auto initVerts = [&hull](auto vert) -> auto
 	{
-		vert.edgeArr = &this->edges;
+		vert.edgeArr = &hull->edges;
 		return vert;
 	};
-	this->vertices
+	hull->vertices
 		= verts | rv::transform(initVerts) | r::to<vector<HE::HVertex>>();
 
-	using VertPair = std::pair<uint8_t, uint8_t>;
-	std::map<VertPair, HE::HEdge> tmpEdges;
-	std::set<VertPair> uniqueEdges;
-	vector<VertPair> anchors;
-	anchors.resize(faces.size());
-	this->faces.reserve(faces.size());
-	for (auto face : faces)
-	{
-		this->faces.emplace_back(face.normal);
-		this->faces.back().edgeArr = &this->edges;
-		for (uint64_t i{0}; i < face.indices.size(); i++)
-		{
-			VertPair pair{face.indices[i],
-						  face.indices[(i + 1) % face.indices.size()]};
-			tmpEdges.insert({pair, HE::HEdge()});
-
-			tmpEdges[pair].vertArr = &this->vertices;
-			tmpEdges[pair].edgeArr = &this->edges;
-			tmpEdges[pair].faceArr = &this->faces;
-
-			tmpEdges[pair].faceID
-				= static_cast<uint8_t>(this->faces.size() - 1);
-			tmpEdges[pair].vertID = face.indices[i];
-			tmpEdges[pair].nextID = pair.second;
-			anchors[this->faces.size() - 1] = pair;
-
-			if (!uniqueEdges.contains(pair)
-				&& !uniqueEdges.contains({pair.second, pair.first}))
-			{
-				uniqueEdges.emplace(pair);
-			}
-		}
+	uint64_t edgeCount{0};
+	for (const auto& face : faces)
+	{
+		edgeCount += face.indices.size();
 	}
-	for (uint64_t i{0}; i < this->faces.size(); i++)
+	hull->edges.reserve(edgeCount);
+	hull->faces.reserve(faces.size());
+
+	for (const auto& face : faces)
 	{
-		auto face = faces[i];
-		this->faces[i].edgeID = static_cast<uint8_t>(
-			std::distance(tmpEdges.begin(), tmpEdges.find(anchors[i])));
-		for (uint64_t j{0}; j < face.indices.size(); j++)
+		const auto faceID{static_cast<uint32_t>(hull->faces.size())};
+		const auto first{static_cast<uint32_t>(hull->edges.size())};
+		const auto count{static_cast<uint32_t>(face.indices.size())};
+		hull->faces.emplace_back(face.normal);
+		hull->faces.back().edgeID = first;
+		hull->faces.back().edgeArr = &hull->edges;
+		for (uint32_t i{0}; i < count; i++)
 		{
-			VertPair pair{face.indices[j],
-						  face.indices[(j + 1) % face.indices.size()]};
-			VertPair pairO{face.indices[(j + 1) % face.indices.size()],
-						   face.indices[j]};
-			VertPair next{face.indices[(j + 1) % face.indices.size()],
-						  face.indices[(j + 2) % face.indices.size()]};
-			tmpEdges[pair].nextID = static_cast<uint8_t>(
-				std::distance(tmpEdges.begin(), tmpEdges.find(next)));
-			if (tmpEdges.contains(pairO))
-			{
-				tmpEdges[pair].twinID = static_cast<uint8_t>(
-					std::distance(tmpEdges.begin(), tmpEdges.find(pairO)));
-				tmpEdges[pairO].twinID = static_cast<uint8_t>(
-					std::distance(tmpEdges.begin(), tmpEdges.find(pair)));
-			}
+			hull->edges.push_back({
+				.vertID = face.indices[i],
+				.twinID = 0,
+				.nextID = first + ((i + 1) % count),
+				.faceID = faceID,
+				.vertArr = &hull->vertices,
+				.edgeArr = &hull->edges,
+				.faceArr = &hull->faces,
+			});
+			hull->vertices[face.indices[i]].edgeID = first + i;
 		}
 	}
 
-	auto getEdgeDir = [this](auto pair) -> Vector3
+	// Half-edges are bucketed by origin vertex, so each twin is found by
+	// scanning the few edges leaving the destination vertex
+	vector<uint32_t> firstOut(hull->vertices.size() + 1, 0);
+	for (const auto& edge : hull->edges)
 	{
-		return this->vertices[pair.first].Vec()
-			   - this->vertices[pair.second].Vec();
-	};
-	this->edgeDirs = uniqueEdges
-					 | rv::transform(getEdgeDir)
-					 | rv::transform(Vector3Normalize)
-					 | r::to<vector<Vector3>>();
+		firstOut[edge.vertID + 1]++;
+	}
+	for (uint64_t i{1}; i < firstOut.size(); i++)
+	{
+		firstOut[i] += firstOut[i - 1];
+	}
+	vector<uint32_t> outgoing(hull->edges.size());
+	vector<uint32_t> fill(firstOut.begin(), firstOut.end() - 1);
+	for (uint32_t i{0}; i < hull->edges.size(); i++)
+	{
+		outgoing[fill[hull->edges[i].vertID]++] = i;
+	}
 
-	auto initEdge = [this](HE::HEdge edge) -> HE::HEdge
+	for (uint32_t i{0}; i < hull->edges.size(); i++)
 	{
-		edge.Vertex()->edgeID = static_cast<uint8_t>(this->edges.size() - 1);
-		edge.vertArr = &this->vertices;
-		edge.edgeArr = &this->edges;
-		edge.faceArr = &this->faces;
-		return edge;
-	};
-	this->edges = tmpEdges
-				  | rv::transform([](auto edge) -> auto { return edge.second; })
-				  | rv::transform(initEdge)
-				  | r::to<vector<HE::HEdge>>();
+		auto& edge = hull->edges[i];
+		const uint32_t next{hull->edges[edge.nextID].vertID};
+		bool hasTwin{false};
+		for (uint32_t j{firstOut[next]}; j < firstOut[next + 1]; j++)
+		{
+			const auto& other = hull->edges[outgoing[j]];
+			if (hull->edges[other.nextID].vertID == edge.vertID)
+			{
+				edge.twinID = outgoing[j];
+				hasTwin = true;
+				break;
+			}
+		}
+		// Only one half of each edge contributes a direction
+		if (!hasTwin || i < edge.twinID)
+		{
+			hull->edgeDirs.push_back(
+				Vector3Normalize(hull->vertices[edge.vertID].Vec()
+								 - hull->vertices[next].Vec()));
+		}
+	}
+	hull->UpdateBounds();
+	this->geometry = std::move(hull);
 }
-HullCollider::HullCollider(const HullCollider& copy) : edgeDirs(copy.edgeDirs)
+HullCollider::HullCollider(const HullView& view)
 {
-	this->vertices.reserve(copy.vertices.size());
-	for (auto vert : copy.vertices)
+	auto hull{std::make_shared<HullGeometry>()};
+	hull->origin = view.origin;
+	hull->bounds = view.bounds;
+	hull->vertices.reserve(view.vertices.size());
+	for (const auto& vert : view.vertices)
 	{
-		vert.edgeArr = &this->edges;
-		this->vertices.push_back(vert);
+		hull->vertices.push_back({
+			.x = vert.x,
+			.y = vert.y,
+			.z = vert.z,
+			.edgeID = vert.edgeID,
+			.edgeArr = &hull->edges,
+		});
 	}
-	this->edges.reserve(copy.edges.size());
-	for (auto edge : copy.edges)
+	hull->edges.reserve(view.edges.size());
+	for (const auto& edge : view.edges)
 	{
-		edge.vertArr = &this->vertices;
-		edge.edgeArr = &this->edges;
-		edge.faceArr = &this->faces;
-		this->edges.push_back(edge);
+		hull->edges.push_back({
+			.vertID = edge.vertID,
+			.twinID = edge.twinID,
+			.nextID = edge.nextID,
+			.faceID = edge.faceID,
+			.vertArr = &hull->vertices,
+			.edgeArr = &hull->edges,
+			.faceArr = &hull->faces,
+		});
 	}
-	this->faces.reserve(copy.faces.size());
-	for (auto face : copy.faces)
+	hull->faces.reserve(view.faces.size());
+	for (const auto& face : view.faces)
 	{
-		face.edgeArr = &this->edges;
-		this->faces.push_back(face);
+		hull->faces.emplace_back(face.normal);
+		hull->faces.back().edgeID = face.edgeID;
+		hull->faces.back().edgeArr = &hull->edges;
 	}
+	hull->edgeDirs.assign(view.edgeDirs.begin(), view.edgeDirs.end());
+	this->geometry = std::move(hull);
 }
 void HullCollider::GetTransformed(const Matrix trans,
-								  vector<Collider>& out) const
+								  std::pmr::vector<Collider>& out) const
 {
-	HullCollider newCol{HullCollider(*this)};
-	for (uint64_t i{0}; i < newCol.vertices.size(); i++)
+	// Transformed hulls are scratch, so they skip the registry and share the
+	// output's memory
+	auto hull{std::allocate_shared<HullGeometry>(out.get_allocator(),
+												 *this->geometry)};
+	for (uint64_t i{0}; i < hull->vertices.size(); i++)
 	{
-		newCol.vertices[i] = newCol.vertices[i] * trans;
+		hull->vertices[i] = hull->vertices[i] * trans;
 	}
-	for (uint64_t i{0}; i < newCol.faces.size(); i++)
+	for (uint64_t i{0}; i < hull->faces.size(); i++)
 	{
-		auto newNor = newCol.faces[i].normal * trans;
-		newCol.faces[i].normal = Vector3Normalize(
+		auto newNor = hull->faces[i].normal * trans;
+		hull->faces[i].normal = Vector3Normalize(
 			Vector3Subtract(newNor, {trans.m12, trans.m13, trans.m14}));
 	}
-	for (auto& dir : newCol.edgeDirs)
+	for (auto& dir : hull->edgeDirs)
 	{
 		Vector3 translation;
 		Quaternion rotation;
@@ -212,12 +272,13 @@ void HullCollider::GetTransformed(const Matrix trans,
 		MatrixDecompose(trans, &translation, &rotation, &scale);
 		dir = dir * QuaternionToMatrix(rotation);
 	}
-	newCol.origin = newCol.origin * trans;
-	out.emplace_back(newCol);
+	hull->origin = hull->origin * trans;
+	hull->UpdateBounds();
+	out.push_back(HullCollider{std::move(hull)});
 }
-void HullCollider::GetNormals(vector<Vector3>& out) const
+void HullCollider::GetNormals(std::pmr::vector<Vector3>& out) const
 {
-	for (const auto face : this->faces)
+	for (const auto face : this->geometry->faces)
 	{
 		out.push_back(face.normal);
 	}
@@ -228,7 +289,7 @@ auto HullCollider::GetProjection(const Vector3 nor) const -> Range
 		.min = std::numeric_limits<float>::max(),
 		.max = std::numeric_limits<float>::min(),
 	};
-	for (const auto vert : this->vertices)
+	for (const auto vert : this->geometry->vertices)
 	{
 		float projected = Vector3DotProduct(vert.Vec(), nor);
 		proj.min = projected < proj.min ? projected : proj.min;
@@ -240,27 +301,27 @@ auto HullCollider::GetSupportPoint(const Vector3 axis) const -> Vector3
 {
 	auto comp = [this, axis](auto a, auto b) -> bool
 	{
-		return Vector3DotProduct(axis, a.Vec() - this->origin)
-			   < Vector3DotProduct(axis, b.Vec() - this->origin);
+		return Vector3DotProduct(axis, a.Vec() - this->geometry->origin)
+			   < Vector3DotProduct(axis, b.Vec() - this->geometry->origin);
 	};
-	return r::max_element(this->vertices, comp)->Vec();
+	return r::max_element(this->geometry->vertices, comp)->Vec();
 }
 auto HullCollider::GetSupportPoints(const Vector3 axis, Vector3 dir) const
 	-> std::pair<Vector3, Vector3>
 {
 	auto comp = [this, axis](auto a, auto b) -> bool
 	{
-		return Vector3DotProduct(axis, a.Vec() - this->origin)
-			   < Vector3DotProduct(axis, b.Vec() - this->origin);
+		return Vector3DotProduct(axis, a.Vec() - this->geometry->origin)
+			   < Vector3DotProduct(axis, b.Vec() - this->geometry->origin);
 	};
-	auto support = *r::max_element(this->vertices, comp);
+	auto support = *r::max_element(this->geometry->vertices, comp);
 
 	auto attachedToVec = [support](auto edge) -> auto
 	{
 		return (*edge.Vertex() == support)
 			   && (*edge.Twin()->Vertex() != support);
 	};
-	auto twins = this->edges
+	auto twins = this->geometry->edges
 				 | rv::filter(attachedToVec)
 				 | rv::filter([dir](auto edge) -> bool
 							  { return Vector3Equivalent(dir, edge.Dir()); });
@@ -274,33 +335,40 @@ auto HullCollider::GetSupportPoints(const Vector3 axis, Vector3 dir) const
 }
 void HullCollider::DebugDraw(const Matrix& transform, const Color& col) const
 {
-	for (const auto& edge : this->edges)
+	if (IsDebugDrawEnabled(DEBUG_HULLS))
 	{
-		Vector3 start = edge.Vertex()->Vec() * transform;
-		Vector3 end = edge.Twin()->Vertex()->Vec() * transform;
-		DrawLine3D(start, end, col);
+		for (const auto& edge : this->geometry->edges)
+		{
+			Vector3 start = edge.Vertex()->Vec() * transform;
+			Vector3 end = edge.Twin()->Vertex()->Vec() * transform;
+			DebugLine(DEBUG_HULLS, start, end, col);
+		}
 	}
-	for (const auto& face : this->faces)
+	if (IsDebugDrawEnabled(DEBUG_NORMALS))
 	{
-		for (const auto& edge : face)
+		for (const auto& face : this->geometry->faces)
 		{
-			Vector3 start = edge.Twin()->Vertex()->Vec() * transform;
-			Vector3 end
-				= (Vector3RotateByAxisAngle((-edge.Dir()) * 0.1f, face.normal,
-											20.0f * DEG2RAD)
-				   + edge.Twin()->Vertex()->Vec())
-				  * transform;
-			DrawLine3D(start, end, col);
+			for (const auto& edge : face)
+			{
+				Vector3 start = edge.Twin()->Vertex()->Vec() * transform;
+				Vector3 end = (Vector3RotateByAxisAngle((-edge.Dir()) * 0.1f,
+														face.normal,
+														20.0f * DEG2RAD)
+							   + edge.Twin()->Vertex()->Vec())
+							  * transform;
+				DebugLine(DEBUG_NORMALS, start, end, col);
+			}
+			DebugLine(DEBUG_NORMALS, face.Center() * transform,
+					  (face.Center() + (face.normal * 0.1f)) * transform, col);
 		}
-		DrawLine3D(face.Center() * transform,
-				   (face.Center() + (face.normal * 0.1f)) * transform, col);
 	}
-	DrawSphere(this->origin * transform, 0.025f, col);
+	DebugPoint(DEBUG_HULLS, this->geometry->origin * transform, 0.05f, col);
 }
 void HullCollider::DebugDrawEdge(const uint64_t index) const
 {
-	DrawSphere(this->edges[index].Vertex()->Vec(), 0.05f, GREEN);
-	DrawSphere(this->edges[index].Next()->Vertex()->Vec(), 0.05f, GREEN);
+	const auto& edge{this->geometry->edges[index]};
+	DebugPoint(DEBUG_HULLS, edge.Vertex()->Vec(), 0.1f, GREEN);
+	DebugPoint(DEBUG_HULLS, edge.Next()->Vertex()->Vec(), 0.1f, GREEN);
 }
 
 auto CreateBoxCollider(Matrix transform) -> Collider
@@ -358,11 +426,164 @@ auto CreateBoxCollider(Matrix transform) -> Collider
 	return {newCol};
 }
 
+auto MergeBounds(const BoundingBox& a, const BoundingBox& b) -> BoundingBox
+{
+	return {
+		.min = Vector3Min(a.min, b.min),
+		.max = Vector3Max(a.max, b.max),
+	};
+}
+
+auto TransformBounds(const BoundingBox& box, const Matrix& trans)
+	-> BoundingBox
+{
+	const Vector3 centre{((box.min + box.max) * 0.5f) * trans};
+	const Vector3 half{(box.max - box.min) * 0.5f};
+	const Vector3 extents{
+		(std::fabs(trans.m0) * half.x) + (std::fabs(trans.m4) * half.y)
+			+ (std::fabs(trans.m8) * half.z),
+		(std::fabs(trans.m1) * half.x) + (std::fabs(trans.m5) * half.y)
+			+ (std::fabs(trans.m9) * half.z),
+		(std::fabs(trans.m2) * half.x) + (std::fabs(trans.m6) * half.y)
+			+ (std::fabs(trans.m10) * half.z),
+	};
+	return {.min = centre - extents, .max = centre + extents};
+}
+
+namespace
+{
+
+auto GetVolume(const BoundingBox& box) -> float
+{
+	const Vector3 size{box.max - box.min};
+	return size.x * size.y * size.z;
+}
+
+} //namespace
+
+void BuildBoundsTree(std::span<uint32_t> ids, const vector<BoundingBox>& boxes,
+					 const uint32_t rootID, vector<BoundsNode>& tree)
+{
+	BoundingBox bounds{boxes[ids.front()]};
+	const Vector3 firstCentre{
+		(boxes[ids.front()].min + boxes[ids.front()].max) * 0.5f};
+	BoundingBox centres{.min = firstCentre, .max = firstCentre};
+	for (const auto id : ids | rv::drop(1))
+	{
+		const Vector3 centre{(boxes[id].min + boxes[id].max) * 0.5f};
+		bounds = MergeBounds(bounds, boxes[id]);
+		centres = MergeBounds(centres, {.min = centre, .max = centre});
+	}
+	if (ids.size() == 1)
+	{
+		tree[rootID] = {.bounds = bounds, .first = ids.front(), .isLeaf = true};
+		return;
+	}
+
+	// Split at the median centre along the axis the centres spread most on
+	const Vector3 spread{centres.max - centres.min};
+	const uint32_t axis{spread.x >= spread.y && spread.x >= spread.z ? 0U
+						: spread.y >= spread.z						 ? 1U
+																	 : 2U};
+	const auto getCentre = [&boxes, axis](const uint32_t id) -> float
+	{
+		const Vector3 centre{(boxes[id].min + boxes[id].max) * 0.5f};
+		return std::array{centre.x, centre.y, centre.z}[axis];
+	};
+	const auto half{ids.size() / 2};
+	std::nth_element(
+		ids.begin(), ids.begin() + static_cast<std::ptrdiff_t>(half),
+		ids.end(), [&getCentre](const uint32_t a, const uint32_t b) -> bool
+		{ return getCentre(a) < getCentre(b); });
+
+	const auto left{static_cast<uint32_t>(tree.size())};
+	tree.resize(tree.size() + 2);
+	tree[rootID] = {.bounds = bounds, .first = left, .isLeaf = false};
+	BuildBoundsTree(ids.first(half), boxes, left, tree);
+	BuildBoundsTree(ids.subspan(half), boxes, left + 1, tree);
+}
+
 CompoundCollider::CompoundCollider(const vector<Collider>& cols) :
 	colliders(cols)
-{ }
+{
+	auto getBounds = [](const isCollider auto& col) -> BoundingBox
+	{ return col.GetBounds(); };
+	if (this->colliders.empty())
+		return;
+	vector<BoundingBox> boxes;
+	boxes.reserve(this->colliders.size());
+	for (const auto& col : this->colliders)
+	{
+		boxes.push_back(std::visit(getBounds, col));
+	}
+	vector<uint32_t> ids(this->colliders.size());
+	std::iota(ids.begin(), ids.end(), 0U);
+	// A binary tree with one child per leaf always has 2n - 1 nodes
+	this->tree.reserve((ids.size() * 2) - 1);
+	this->tree.resize(1);
+	BuildBoundsTree(ids, boxes, 0, this->tree);
+	this->bounds = this->tree.front().bounds;
+}
+void CompoundCollider::GetOverlaps(const BoundingBox& box,
+								   std::pmr::vector<uint32_t>& out) const
+{
+	if (this->tree.empty())
+		return;
+	std::pmr::vector<uint32_t> stack{{0}, out.get_allocator()};
+	while (!stack.empty())
+	{
+		const BoundsNode& node{this->tree[stack.back()]};
+		stack.pop_back();
+		if (!CheckCollisionBoxes(node.bounds, box))
+			continue;
+		if (node.isLeaf)
+		{
+			out.push_back(node.first);
+			continue;
+		}
+		stack.push_back(node.first);
+		stack.push_back(node.first + 1);
+	}
+}
+void CompoundCollider::GetOverlaps(
+	const CompoundCollider& other, const Matrix& trans,
+	std::pmr::vector<std::pair<uint32_t, uint32_t>>& out) const
+{
+	if (this->tree.empty() || other.tree.empty())
+		return;
+	std::pmr::vector<std::pair<uint32_t, uint32_t>> stack{
+		{{0, 0}}, out.get_allocator()};
+	while (!stack.empty())
+	{
+		const auto [idA, idB] = stack.back();
+		stack.pop_back();
+		const BoundsNode& nodeA{this->tree[idA]};
+		const BoundsNode& nodeB{other.tree[idB]};
+		const BoundingBox boundsB{TransformBounds(nodeB.bounds, trans)};
+		if (!CheckCollisionBoxes(nodeA.bounds, boundsB))
+			continue;
+		if (nodeA.isLeaf && nodeB.isLeaf)
+		{
+			out.emplace_back(nodeA.first, nodeB.first);
+			continue;
+		}
+		// Descend the larger node so both sides shrink at a similar rate
+		if (nodeB.isLeaf
+			|| (!nodeA.isLeaf
+				&& GetVolume(nodeA.bounds) >= GetVolume(boundsB)))
+		{
+			stack.emplace_back(nodeA.first, idB);
+			stack.emplace_back(nodeA.first + 1, idB);
+		}
+		else
+		{
+			stack.emplace_back(idA, nodeB.first);
+			stack.emplace_back(idA, nodeB.first + 1);
+		}
+	}
+}
 void CompoundCollider::GetTransformed(const Matrix trans,
-									  vector<Collider>& out) const
+									  std::pmr::vector<Collider>& out) const
 {
 	for (const auto& elem : this->colliders)
 	{
@@ -371,7 +592,7 @@ void CompoundCollider::GetTransformed(const Matrix trans,
 				   { col.GetTransformed(trans, out); }, elem);
 	}
 }
-void CompoundCollider::GetNormals(vector<Vector3>& out) const
+void CompoundCollider::GetNormals(std::pmr::vector<Vector3>& out) const
 {
 	for (const auto& col : this->colliders)
 	{
@@ -395,6 +616,53 @@ void CompoundCollider::DebugDraw(const Matrix& transform,
 	}
 }
 
+auto GetLeaves(const Collider& col) -> std::span<const Collider>
+{
+	if (const auto* compound = std::get_if<CompoundCollider>(&col))
+		return compound->GetColliders();
+	return {&col, 1};
+}
+void GetLeafOverlaps(const Collider& colA, const Collider& colB,
+					 const Matrix& trans, const Matrix& inverse,
+					 std::pmr::vector<std::pair<uint32_t, uint32_t>>& out)
+{
+	auto getBounds = [](const isCollider auto& col) -> BoundingBox
+	{ return col.GetBounds(); };
+	const auto* compoundA = std::get_if<CompoundCollider>(&colA);
+	const auto* compoundB = std::get_if<CompoundCollider>(&colB);
+	if (compoundA != nullptr && compoundB != nullptr)
+	{
+		compoundA->GetOverlaps(*compoundB, trans, out);
+		return;
+	}
+
+	std::pmr::vector<uint32_t> ids{out.get_allocator()};
+	if (compoundA != nullptr)
+	{
+		compoundA->GetOverlaps(
+			TransformBounds(std::visit(getBounds, colB), trans), ids);
+		for (const auto id : ids)
+		{
+			out.emplace_back(id, 0);
+		}
+	}
+	else if (compoundB != nullptr)
+	{
+		compoundB->GetOverlaps(
+			TransformBounds(std::visit(getBounds, colA), inverse), ids);
+		for (const auto id : ids)
+		{
+			out.emplace_back(0, id);
+		}
+	}
+	else if (CheckCollisionBoxes(
+				 std::visit(getBounds, colA),
+				 TransformBounds(std::visit(getBounds, colB), trans)))
+	{
+		out.emplace_back(0, 0);
+	}
+}
+
 #ifndef NDEBUG
 auto operator<<(ostream& ostr, Vector3 vec) -> ostream&
 {
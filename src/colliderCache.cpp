@@ -0,0 +1,578 @@
+#include "colliderCache.h"
+#include "collider.h"
+#include "halfEdge.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <optional>
+#include <ranges>
+#include <raylib.h>
+#include <raymath.h>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+namespace phys
+{
+
+namespace r = std::ranges;
+
+using std::vector;
+
+namespace
+{
+/** @brief Every array in the file starts on a multiple of this. */
+constexpr uint64_t COOKED_ALIGN{16};
+} // namespace
+
+struct ColliderCache::Header
+{
+	uint32_t magic;
+	uint32_t endianTag;
+	uint32_t version;
+	uint32_t entryCount;
+	uint32_t rootCount;
+	uint32_t reserved;
+	uint64_t fileSize;
+	uint64_t entryOffset;
+	uint64_t rootOffset;
+	/** @brief What the colliders were cooked from, see GetCookKey(). */
+	uint64_t sourceKey;
+};
+struct ColliderCache::Entry
+{
+	enum Type : uint32_t
+	{
+		HULL = 0,
+		COMPOUND = 1,
+		SPHERE = 2,
+		CAPSULE = 3,
+		BOX = 4,
+		MESH = 5,
+		HEIGHTFIELD = 6,
+	};
+
+	uint32_t type;
+	uint32_t vertCount;
+	uint32_t edgeCount;
+	uint32_t faceCount;
+	uint32_t dirCount;
+	uint32_t childCount;
+	uint32_t triangleCount;
+	uint32_t nodeCount;
+	/** @brief A heightfield's samples along x and z. */
+	uint32_t gridWidth;
+	uint32_t gridDepth;
+	uint64_t vertOffset;
+	uint64_t edgeOffset;
+	uint64_t faceOffset;
+	uint64_t dirOffset;
+	uint64_t childOffset;
+	uint64_t triangleOffset;
+	uint64_t nodeOffset;
+	/** @brief A mesh or heightfield's transform, as a single Matrix. */
+	uint64_t transformOffset;
+	Vector3 origin;
+	BoundingBox bounds;
+	/**
+	 * @brief A capsule's end points, or a box's axes scaled by its half
+	 *        extents. A heightfield keeps its cell size in the first, and its
+	 *        height offset and scale in the second. Unused by every other
+	 *        type.
+	 */
+	std::array<Vector3, 3> shape;
+	/** @brief Radius of a sphere or capsule. */
+	float radius;
+};
+/**
+ * @brief Accumulates the file in memory. Entries are appended children
+ *        first, so a compound only ever references lower entry indices.
+ */
+struct ColliderCache::Writer
+{
+	vector<std::byte> blob;
+	vector<Entry> entries;
+
+	template <typename T>
+	auto Append(std::span<const T> data) -> uint64_t
+	{
+		static_assert(std::is_trivially_copyable_v<T>);
+		const uint64_t offset{(this->blob.size() + COOKED_ALIGN - 1)
+							  & ~(COOKED_ALIGN - 1)};
+		this->blob.resize(offset + data.size_bytes());
+		if (!data.empty())
+			std::memcpy(this->blob.data() + offset, data.data(),
+						data.size_bytes());
+		return offset;
+	}
+};
+static_assert(std::is_trivially_copyable_v<Vector3>
+			  && std::is_trivially_copyable_v<BoundingBox>);
+
+ColliderCache::ColliderCache(const char* path) : file(path)
+{
+	this->valid = this->file.IsOpen() && this->Validate();
+}
+
+auto ColliderCache::ColliderCount() const -> uint32_t
+{
+	return this->valid ? this->GetHeader().rootCount : 0;
+}
+auto ColliderCache::GetSourceKey() const -> uint64_t
+{
+	return this->valid ? this->GetHeader().sourceKey : 0;
+}
+auto ColliderCache::GetHull(uint32_t i) const -> std::optional<HullView>
+{
+	assert(i < this->ColliderCount());
+	const auto roots = this->GetArray<uint32_t>(this->GetHeader().rootOffset,
+												this->GetHeader().rootCount);
+	const auto& entry = this->GetEntry(roots[i]);
+	if (entry.type != Entry::HULL)
+		return std::nullopt;
+	return this->GetHullView(entry);
+}
+auto ColliderCache::GetCollider(uint32_t i) const -> Collider
+{
+	assert(i < this->ColliderCount());
+	const auto roots = this->GetArray<uint32_t>(this->GetHeader().rootOffset,
+												this->GetHeader().rootCount);
+	return this->Build(roots[i]);
+}
+
+auto ColliderCache::Save(const char* path, std::span<const Collider> cols,
+						 const uint64_t sourceKey) -> bool
+{
+	Writer out;
+	// Reserve space for the header, it is filled in once offsets are known
+	out.blob.resize(sizeof(Header));
+	vector<uint32_t> roots;
+	roots.reserve(cols.size());
+	for (const auto& col : cols)
+	{
+		roots.push_back(Cook(col, out));
+	}
+
+	Header header{
+		.magic = COOKED_MAGIC,
+		.endianTag = COOKED_ENDIAN_TAG,
+		.version = COOKED_VERSION,
+		.entryCount = static_cast<uint32_t>(out.entries.size()),
+		.rootCount = static_cast<uint32_t>(roots.size()),
+		.reserved = 0,
+		.fileSize = 0,
+		.entryOffset = out.Append(std::span<const Entry>(out.entries)),
+		.rootOffset = out.Append(std::span<const uint32_t>(roots)),
+		.sourceKey = sourceKey,
+	};
+	header.fileSize = out.blob.size();
+	std::memcpy(out.blob.data(), &header, sizeof(Header));
+
+	std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+	if (!stream)
+		return false;
+	stream.write(reinterpret_cast<const char*>(out.blob.data()),
+				 static_cast<std::streamsize>(out.blob.size()));
+	return static_cast<bool>(stream);
+}
+auto ColliderCache::Cook(const Collider& col, Writer& out) -> uint32_t
+{
+	Entry entry{};
+	if (const auto* hull = std::get_if<HullCollider>(&col))
+	{
+		const HullGeometry& geometry{*hull->GetGeometry()};
+		vector<CookedVertex> verts;
+		verts.reserve(geometry.vertices.size());
+		for (const auto& vert : geometry.vertices)
+		{
+			verts.push_back({vert.x, vert.y, vert.z, vert.edgeID});
+		}
+		vector<CookedEdge> edges;
+		edges.reserve(geometry.edges.size());
+		for (const auto& edge : geometry.edges)
+		{
+			edges.push_back(
+				{edge.vertID, edge.twinID, edge.nextID, edge.faceID});
+		}
+		vector<CookedFace> faces;
+		faces.reserve(geometry.faces.size());
+		for (const auto& face : geometry.faces)
+		{
+			faces.push_back({face.normal, face.edgeID});
+		}
+
+		entry.type = Entry::HULL;
+		entry.vertCount = static_cast<uint32_t>(verts.size());
+		entry.edgeCount = static_cast<uint32_t>(edges.size());
+		entry.faceCount = static_cast<uint32_t>(faces.size());
+		entry.dirCount = static_cast<uint32_t>(geometry.edgeDirs.size());
+		entry.vertOffset = out.Append(std::span<const CookedVertex>(verts));
+		entry.edgeOffset = out.Append(std::span<const CookedEdge>(edges));
+		entry.faceOffset = out.Append(std::span<const CookedFace>(faces));
+		entry.dirOffset =
+			out.Append(std::span<const Vector3>(geometry.edgeDirs));
+		entry.origin = geometry.origin;
+		entry.bounds = geometry.bounds;
+	}
+	else if (const auto* sphere = std::get_if<SphereCollider>(&col))
+	{
+		entry.type = Entry::SPHERE;
+		entry.origin = sphere->GetOrigin();
+		entry.bounds = sphere->GetBounds();
+		entry.radius = sphere->GetRadius();
+	}
+	else if (const auto* capsule = std::get_if<CapsuleCollider>(&col))
+	{
+		entry.type = Entry::CAPSULE;
+		entry.origin = capsule->GetOrigin();
+		entry.bounds = capsule->GetBounds();
+		entry.shape = {capsule->GetStart(), capsule->GetEnd(), Vector3Zero()};
+		entry.radius = capsule->GetRadius();
+	}
+	else if (const auto* box = std::get_if<BoxCollider>(&col))
+	{
+		const auto& axes = box->GetAxes();
+		const Vector3 half{box->GetHalfExtents()};
+		entry.type = Entry::BOX;
+		entry.origin = box->GetOrigin();
+		entry.bounds = box->GetBounds();
+		entry.shape = {axes[0] * half.x, axes[1] * half.y, axes[2] * half.z};
+	}
+	else if (const auto* mesh = std::get_if<TriangleMeshCollider>(&col))
+	{
+		// A mesh's vertices are plain positions, unlike a hull's
+		const TriangleMeshGeometry& geometry{*mesh->GetGeometry()};
+		entry.type = Entry::MESH;
+		entry.vertCount = static_cast<uint32_t>(geometry.vertices.size());
+		entry.triangleCount = static_cast<uint32_t>(geometry.triangles.size());
+		entry.nodeCount = static_cast<uint32_t>(geometry.nodes.size());
+		entry.vertOffset =
+			out.Append(std::span<const Vector3>(geometry.vertices));
+		entry.triangleOffset =
+			out.Append(std::span<const TriangleIndices>(geometry.triangles));
+		entry.nodeOffset =
+			out.Append(std::span<const QuantisedNode>(geometry.nodes));
+		entry.transformOffset =
+			out.Append(std::span<const Matrix>(&mesh->GetTransform(), 1));
+		entry.origin = mesh->GetOrigin();
+		entry.bounds = geometry.bounds;
+	}
+	else if (const auto* field = std::get_if<HeightfieldCollider>(&col))
+	{
+		// Samples take the place of vertices and tiles of nodes
+		const HeightfieldGeometry& geometry{*field->GetGeometry()};
+		entry.type = Entry::HEIGHTFIELD;
+		entry.gridWidth = geometry.width;
+		entry.gridDepth = geometry.depth;
+		entry.vertCount = static_cast<uint32_t>(geometry.samples.size());
+		entry.nodeCount = static_cast<uint32_t>(geometry.tiles.size());
+		entry.vertOffset =
+			out.Append(std::span<const uint16_t>(geometry.samples));
+		entry.nodeOffset =
+			out.Append(std::span<const HeightRange>(geometry.tiles));
+		entry.transformOffset =
+			out.Append(std::span<const Matrix>(&field->GetTransform(), 1));
+		entry.origin = field->GetOrigin();
+		entry.bounds = geometry.GetBounds();
+		entry.shape = {Vector3{geometry.cellSize.x, geometry.cellSize.y, 0.0f},
+					   Vector3{geometry.heightOffset, geometry.heightScale,
+							   0.0f},
+					   Vector3Zero()};
+	}
+	else
+	{
+		const auto& compound = std::get<CompoundCollider>(col);
+		vector<uint32_t> children;
+		children.reserve(compound.colliders.size());
+		for (const auto& child : compound.colliders)
+		{
+			children.push_back(Cook(child, out));
+		}
+
+		entry.type = Entry::COMPOUND;
+		entry.childCount = static_cast<uint32_t>(children.size());
+		entry.childOffset = out.Append(std::span<const uint32_t>(children));
+		entry.origin = compound.origin;
+		entry.bounds = compound.bounds;
+	}
+	out.entries.push_back(entry);
+	return static_cast<uint32_t>(out.entries.size() - 1);
+}
+
+auto ColliderCache::GetHeader() const -> const Header&
+{
+	return *reinterpret_cast<const Header*>(this->file.Bytes().data());
+}
+auto ColliderCache::GetEntry(uint32_t id) const -> const Entry&
+{
+	const auto& header = this->GetHeader();
+	return this->GetArray<Entry>(header.entryOffset, header.entryCount)[id];
+}
+auto ColliderCache::GetHullView(const Entry& entry) const -> HullView
+{
+	return {
+		.vertices =
+			this->GetArray<CookedVertex>(entry.vertOffset, entry.vertCount),
+		.edges = this->GetArray<CookedEdge>(entry.edgeOffset, entry.edgeCount),
+		.faces = this->GetArray<CookedFace>(entry.faceOffset, entry.faceCount),
+		.edgeDirs = this->GetArray<Vector3>(entry.dirOffset, entry.dirCount),
+		.origin = entry.origin,
+		.bounds = entry.bounds,
+	};
+}
+
+auto ColliderCache::GetMeshView(const Entry& entry) const -> MeshView
+{
+	return {
+		.vertices = this->GetArray<Vector3>(entry.vertOffset, entry.vertCount),
+		.triangles = this->GetArray<TriangleIndices>(entry.triangleOffset,
+													 entry.triangleCount),
+		.nodes =
+			this->GetArray<QuantisedNode>(entry.nodeOffset, entry.nodeCount),
+		.bounds = entry.bounds,
+		.transform = this->GetArray<Matrix>(entry.transformOffset, 1)[0],
+	};
+}
+
+auto ColliderCache::GetHeightfieldView(const Entry& entry) const
+	-> HeightfieldView
+{
+	return {
+		.width = entry.gridWidth,
+		.depth = entry.gridDepth,
+		.cellSize = {entry.shape[0].x, entry.shape[0].y},
+		.heightOffset = entry.shape[1].x,
+		.heightScale = entry.shape[1].y,
+		.samples = this->GetArray<uint16_t>(entry.vertOffset, entry.vertCount),
+		.tiles = this->GetArray<HeightRange>(entry.nodeOffset, entry.nodeCount),
+		.transform = this->GetArray<Matrix>(entry.transformOffset, 1)[0],
+	};
+}
+
+template <typename T>
+auto ColliderCache::InBounds(uint64_t offset, uint64_t count) const -> bool
+{
+	const uint64_t size{this->file.Bytes().size()};
+	return offset % alignof(T) == 0 && offset <= size
+		   && count <= (size - offset) / sizeof(T);
+}
+template <typename T>
+auto ColliderCache::GetArray(uint64_t offset, uint64_t count) const
+	-> std::span<const T>
+{
+	return {reinterpret_cast<const T*>(this->file.Bytes().data() + offset),
+			count};
+}
+
+auto ColliderCache::Validate() const -> bool
+{
+	if (this->file.Bytes().size() < sizeof(Header))
+		return false;
+	const auto& header = this->GetHeader();
+	if (header.magic != COOKED_MAGIC || header.endianTag != COOKED_ENDIAN_TAG
+		|| header.version != COOKED_VERSION
+		|| header.fileSize != this->file.Bytes().size())
+		return false;
+	if (!this->InBounds<Entry>(header.entryOffset, header.entryCount)
+		|| !this->InBounds<uint32_t>(header.rootOffset, header.rootCount))
+		return false;
+
+	const auto roots =
+		this->GetArray<uint32_t>(header.rootOffset, header.rootCount);
+	if (r::any_of(roots, [&header](uint32_t root) -> bool
+				  { return root >= header.entryCount; }))
+		return false;
+
+	// Half-edge indices are used unchecked once loaded, so every one of them
+	// is checked here instead
+	for (uint32_t i{0}; i < header.entryCount; i++)
+	{
+		const auto& entry = this->GetEntry(i);
+		if (entry.type == Entry::COMPOUND)
+		{
+			if (!this->InBounds<uint32_t>(entry.childOffset, entry.childCount))
+				return false;
+			// Children are always written before their parent, which also
+			// rules out cycles
+			const auto children =
+				this->GetArray<uint32_t>(entry.childOffset, entry.childCount);
+			if (r::any_of(children,
+						  [i](uint32_t child) -> bool { return child >= i; }))
+				return false;
+			continue;
+		}
+		if (entry.type == Entry::SPHERE || entry.type == Entry::CAPSULE
+			|| entry.type == Entry::BOX)
+			continue;
+		if (entry.type == Entry::MESH)
+		{
+			if (!this->ValidateMesh(entry))
+				return false;
+			continue;
+		}
+		if (entry.type == Entry::HEIGHTFIELD)
+		{
+			if (!this->ValidateHeightfield(entry))
+				return false;
+			continue;
+		}
+		if (entry.type != Entry::HULL
+			|| !this->InBounds<CookedVertex>(entry.vertOffset, entry.vertCount)
+			|| !this->InBounds<CookedEdge>(entry.edgeOffset, entry.edgeCount)
+			|| !this->InBounds<CookedFace>(entry.faceOffset, entry.faceCount)
+			|| !this->InBounds<Vector3>(entry.dirOffset, entry.dirCount))
+			return false;
+		const auto view = this->GetHullView(entry);
+		const auto badEdge = [&entry](uint32_t id) -> bool
+		{ return id >= entry.edgeCount; };
+		if (r::any_of(view.vertices, badEdge, &CookedVertex::edgeID)
+			|| r::any_of(view.faces, badEdge, &CookedFace::edgeID))
+			return false;
+		for (const auto& edge : view.edges)
+		{
+			if (edge.vertID >= entry.vertCount || badEdge(edge.twinID)
+				|| badEdge(edge.nextID) || edge.faceID >= entry.faceCount)
+				return false;
+		}
+	}
+	return true;
+}
+auto ColliderCache::ValidateMesh(const Entry& entry) const -> bool
+{
+	if (!this->InBounds<Vector3>(entry.vertOffset, entry.vertCount)
+		|| !this->InBounds<TriangleIndices>(entry.triangleOffset,
+											entry.triangleCount)
+		|| !this->InBounds<QuantisedNode>(entry.nodeOffset, entry.nodeCount)
+		|| !this->InBounds<Matrix>(entry.transformOffset, 1)
+		|| (entry.nodeCount == 0) != (entry.triangleCount == 0))
+		return false;
+	const auto view = this->GetMeshView(entry);
+	for (const auto& tri : view.triangles)
+	{
+		if (r::any_of(tri.verts, [&entry](uint32_t id) -> bool
+					  { return id >= entry.vertCount; }))
+			return false;
+	}
+	// Children always come after their parent, so walking the tree from the
+	// root can neither loop nor leave it
+	for (uint32_t i{0}; i < entry.nodeCount; i++)
+	{
+		const QuantisedNode& node{view.nodes[i]};
+		const uint64_t index{node.Index()};
+		if (node.IsLeaf() && index + node.Count() > entry.triangleCount)
+			return false;
+		if (!node.IsLeaf() && (index <= i + 1 || index >= entry.nodeCount))
+			return false;
+	}
+	return true;
+}
+auto ColliderCache::ValidateHeightfield(const Entry& entry) const -> bool
+{
+	if (entry.gridWidth < 2 || entry.gridDepth < 2
+		|| uint64_t{entry.gridWidth} * entry.gridDepth != entry.vertCount
+		|| !this->InBounds<uint16_t>(entry.vertOffset, entry.vertCount)
+		|| !this->InBounds<HeightRange>(entry.nodeOffset, entry.nodeCount)
+		|| !this->InBounds<Matrix>(entry.transformOffset, 1)
+		|| !(entry.shape[1].y > 0.0f))
+		return false;
+	// The levels follow from the grid's size, and must fill the tiles
+	HeightfieldGeometry expected{};
+	expected.width = entry.gridWidth;
+	expected.depth = entry.gridDepth;
+	expected.FindLevels();
+	return expected.tiles.size() == entry.nodeCount;
+}
+auto ColliderCache::Build(uint32_t id) const -> Collider
+{
+	const auto& entry = this->GetEntry(id);
+	switch (entry.type)
+	{
+	case Entry::HULL:
+		return Collider{std::in_place_type<HullCollider>,
+						this->GetHullView(entry)};
+	case Entry::SPHERE:
+		return SphereCollider{entry.origin, entry.radius};
+	case Entry::CAPSULE:
+		return CapsuleCollider{entry.shape[0], entry.shape[1], entry.radius};
+	case Entry::BOX:
+	{
+		const auto& half = entry.shape;
+		return BoxCollider{entry.origin,
+						   {Vector3Normalize(half[0]),
+							Vector3Normalize(half[1]),
+							Vector3Normalize(half[2])},
+						   {Vector3Length(half[0]), Vector3Length(half[1]),
+							Vector3Length(half[2])}};
+	}
+	case Entry::MESH:
+		return TriangleMeshCollider{this->GetMeshView(entry)};
+	case Entry::HEIGHTFIELD:
+		return HeightfieldCollider{this->GetHeightfieldView(entry)};
+	default:
+		break;
+	}
+
+	vector<Collider> children;
+	children.reserve(entry.childCount);
+	for (const auto child :
+		 this->GetArray<uint32_t>(entry.childOffset, entry.childCount))
+	{
+		children.push_back(this->Build(child));
+	}
+	Collider col{std::in_place_type<CompoundCollider>, children};
+	std::get<CompoundCollider>(col).origin = entry.origin;
+	return col;
+}
+
+auto GetCookKey(const Mesh& mesh, const std::string_view cookID) -> uint64_t
+{
+	// FNV-1a, like the hull registry's
+	uint64_t hash{0xcbf29ce484222325};
+	auto mix = [&hash](const uint32_t value) -> void
+	{
+		hash ^= value;
+		hash *= 0x100000001b3;
+	};
+	const auto vertexCount{static_cast<uint32_t>(mesh.vertexCount)};
+	const auto triangleCount{static_cast<uint32_t>(mesh.triangleCount)};
+	mix(vertexCount);
+	mix(triangleCount);
+	for (uint32_t i{0}; i < vertexCount * 3; i++)
+	{
+		mix(std::bit_cast<uint32_t>(mesh.vertices[i]));
+	}
+	if (mesh.indices != nullptr)
+	{
+		for (uint32_t i{0}; i < triangleCount * 3; i++)
+		{
+			mix(mesh.indices[i]);
+		}
+	}
+	for (const char c : cookID)
+	{
+		mix(static_cast<uint8_t>(c));
+	}
+	return hash;
+}
+auto LoadCachedCollider(const char* path, const uint64_t sourceKey,
+						const std::function<Collider()>& cook) -> Collider
+{
+	const ColliderCache cache{path};
+	if (cache.ColliderCount() == 1 && cache.GetSourceKey() == sourceKey)
+		return cache.GetCollider(0);
+
+	const Collider col = cook();
+	ColliderCache::Save(path, {&col, 1}, sourceKey);
+	return col;
+}
+
+} //namespace phys
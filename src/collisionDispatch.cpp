@@ -0,0 +1,170 @@
+#include "collisionDispatch.h"
+#include "collider.h"
+#include "frameArena.h"
+#include "primitiveTests.h"
+
+#include <algorithm>
+#include <concepts>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <raymath.h>
+#include <variant>
+#include <vector>
+
+namespace phys
+{
+
+using std::optional;
+
+namespace
+{
+
+auto FlipContact(optional<ContactHit> hit) -> optional<ContactHit>
+{
+	if (hit.has_value())
+	{
+		hit->normal = Vector3Negate(hit->normal);
+	}
+	return hit;
+}
+
+template <isCollider ColA, isCollider ColB>
+auto CheckShapes(const ColA& colA, const ColB& colB) -> optional<ContactHit>
+{
+	static_assert(hasPairTest<ColA, ColB> || hasPairTest<ColB, ColA>
+					  || std::same_as<ColA, CompoundCollider>
+					  || std::same_as<ColB, CompoundCollider>
+					  || hasTriangles<ColA> || hasTriangles<ColB>,
+				  "Every pair of shapes needs a PairTest");
+	if constexpr (hasPairTest<ColA, ColB>)
+		return PairTest<ColA, ColB>::Check(colA, colB);
+	else if constexpr (hasPairTest<ColB, ColA>)
+		return FlipContact(PairTest<ColB, ColA>::Check(colB, colA));
+	else if constexpr (std::same_as<ColA, CompoundCollider>)
+	{
+		optional<ContactHit> deepest{};
+		for (const auto& child : colA.GetColliders())
+		{
+			const auto hit{std::visit(
+				[&colB](const isCollider auto& shape) -> optional<ContactHit>
+				{ return CheckShapes(shape, colB); },
+				child)};
+			if (hit.has_value()
+				&& (!deepest.has_value()
+					|| hit->penetration > deepest->penetration))
+			{
+				deepest = hit;
+			}
+		}
+		return deepest;
+	}
+	else if constexpr (std::same_as<ColB, CompoundCollider>)
+		return FlipContact(CheckShapes(colB, colA));
+	else if constexpr (hasTriangles<ColA>)
+	{
+		if constexpr (!hasTriangleTest<ColB>)
+			return std::nullopt;
+		else
+		{
+			std::pmr::vector<uint32_t> tris{&GetFrameArena()};
+			colA.GetOverlaps(colB.GetBounds(), tris);
+			optional<ContactHit> deepest{};
+			for (const uint32_t i : tris)
+			{
+				const auto hit{CheckTriangle(colA.GetTriangle(i), colB)};
+				if (hit.has_value()
+					&& (!deepest.has_value()
+						|| hit->penetration > deepest->penetration))
+				{
+					deepest = hit;
+				}
+			}
+			return deepest;
+		}
+	}
+	else
+		return FlipContact(CheckShapes(colB, colA));
+}
+
+/** @returns true if one of hull's face normals separates it from col. */
+template <isCollider Col>
+auto IsSeparatedByFace(const HullCollider& hull, const Col& col) -> bool
+{
+	for (uint32_t i{0}; i < hull.FaceCount(); i++)
+	{
+		const HE::HFace& face{hull.GetFace(i)};
+		const Vector3 support{col.GetSupportPoint(Vector3Negate(face.normal))};
+		if (Vector3DotProduct(support - face.Edge()->Vertex()->Vec(),
+							  face.normal)
+			> 0.0f)
+			return true;
+	}
+	return false;
+}
+
+template <isCollider ColA, isCollider ColB>
+auto CheckShapesOverlap(const ColA& colA, const ColB& colB) -> bool
+{
+	if constexpr (std::same_as<ColA, CompoundCollider>)
+	{
+		return std::ranges::any_of(
+			colA.GetColliders(),
+			[&colB](const Collider& child) -> bool
+			{
+				return std::visit([&colB](const isCollider auto& shape) -> bool
+								  { return CheckShapesOverlap(shape, colB); },
+								  child);
+			});
+	}
+	else if constexpr (std::same_as<ColB, CompoundCollider>)
+		return CheckShapesOverlap(colB, colA);
+	else if constexpr (hasTriangles<ColA>)
+	{
+		if constexpr (!hasTriangleTest<ColB>)
+			return false;
+		else
+		{
+			std::pmr::vector<uint32_t> tris{&GetFrameArena()};
+			colA.GetOverlaps(colB.GetBounds(), tris);
+			return std::ranges::any_of(
+				tris,
+				[&colA, &colB](const uint32_t i) -> bool
+				{
+					return CheckTriangle(colA.GetTriangle(i), colB)
+						.has_value();
+				});
+		}
+	}
+	else if constexpr (hasTriangles<ColB>)
+		return CheckShapesOverlap(colB, colA);
+	else
+	{
+		if constexpr (std::same_as<ColA, HullCollider>)
+		{
+			if (IsSeparatedByFace(colA, colB))
+				return false;
+		}
+		return CheckGJKOverlap(colA, colB);
+	}
+}
+
+} //namespace
+
+auto CheckPairCollision(const Collider& colA, const Collider& colB)
+	-> optional<ContactHit>
+{
+	return std::visit([](const isCollider auto& shapeA,
+						 const isCollider auto& shapeB) -> optional<ContactHit>
+					  { return CheckShapes(shapeA, shapeB); },
+					  colA, colB);
+}
+auto CheckPairOverlap(const Collider& colA, const Collider& colB) -> bool
+{
+	return std::visit([](const isCollider auto& shapeA,
+						 const isCollider auto& shapeB) -> bool
+					  { return CheckShapesOverlap(shapeA, shapeB); },
+					  colA, colB);
+}
+
+} //namespace phys
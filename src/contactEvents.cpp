@@ -0,0 +1,94 @@
+#include "contactEvents.h"
+#include "bodyStorage.h"
+#include "physObject.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <raymath.h>
+#include <utility>
+
+namespace phys
+{
+
+void ContactTracker::BeginStep()
+{
+	this->events.clear();
+	this->lastCount = static_cast<uint32_t>(this->pairs.size());
+	this->persistCount = 0;
+}
+void ContactTracker::AddContact(const HitObj& hit)
+{
+	BodyPair pair{hit.ThisCol.GetHandle(), hit.OtherCol.GetHandle()};
+	Vector3 normal{hit.Normal};
+	if (pair.second < pair.first)
+	{
+		std::swap(pair.first, pair.second);
+		normal = Vector3Negate(normal);
+	}
+
+	ContactEventType type{ContactEventType::BEGIN};
+	if (auto found = this->indices.find(pair); found != this->indices.end())
+	{
+		const uint32_t index{found->second};
+		assert(index >= this->persistCount && index < this->lastCount
+			   && "Pair added twice in one step");
+		// Grow the touched range over it
+		if (index != this->persistCount)
+		{
+			const TrackedPair other{this->pairs[this->persistCount]};
+			this->MovePair(index, this->persistCount);
+			this->pairs[index] = other;
+			this->indices[other.bodies] = index;
+		}
+		this->pairs[this->persistCount].sensor = hit.IsSensor;
+		this->persistCount++;
+		type = ContactEventType::PERSIST;
+	}
+	else
+	{
+		this->indices.emplace(pair,
+							  static_cast<uint32_t>(this->pairs.size()));
+		this->pairs.push_back({.bodies = pair, .sensor = hit.IsSensor});
+	}
+	this->events.push_back({.type = type,
+							.pointCount = static_cast<uint8_t>(hit.PointCount),
+							.sensor = hit.IsSensor,
+							.body1 = pair.first,
+							.body2 = pair.second,
+							.normal = normal,
+							.depth = hit.Penetration,
+							.points = hit.Points});
+}
+void ContactTracker::EndStep()
+{
+	const uint32_t ended{this->lastCount - this->persistCount};
+	for (uint32_t i{this->persistCount}; i < this->lastCount; i++)
+	{
+		this->events.push_back({.type = ContactEventType::END,
+								.pointCount = 0,
+								.sensor = this->pairs[i].sensor,
+								.body1 = this->pairs[i].bodies.first,
+								.body2 = this->pairs[i].bodies.second,
+								.normal = {},
+								.depth = 0.0f,
+								.points = {}});
+		this->indices.erase(this->pairs[i].bodies);
+	}
+	// Fill the gap the ended pairs left with new pairs from the back
+	const auto size{static_cast<uint32_t>(this->pairs.size())};
+	const uint32_t moved{std::min(ended, size - this->lastCount)};
+	for (uint32_t i{0}; i < moved; i++)
+	{
+		this->MovePair(size - 1 - i, this->persistCount + i);
+	}
+	this->pairs.resize(size - ended);
+}
+
+void ContactTracker::MovePair(const uint32_t from, const uint32_t to)
+{
+	this->pairs[to] = this->pairs[from];
+	this->indices[this->pairs[to].bodies] = to;
+}
+
+} //namespace phys
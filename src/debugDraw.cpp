@@ -0,0 +1,144 @@
+#include "debugDraw.h"
+
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <numbers>
+#include <raylib.h>
+#include <raymath.h>
+#include <rlgl.h>
+#include <vector>
+
+namespace phys
+{
+
+namespace
+{
+
+/** @brief Every live thread's buffer, guarded by GetBuffersMutex(). */
+auto GetBuffers() -> std::vector<DebugDrawBuffer*>&
+{
+	static std::vector<DebugDrawBuffer*> buffers;
+	return buffers;
+}
+auto GetBuffersMutex() -> std::mutex&
+{
+	static std::mutex mutex;
+	return mutex;
+}
+
+void Vertex(const Vector3 pos)
+{
+	rlVertex3f(pos.x, pos.y, pos.z);
+}
+
+} //namespace
+
+DebugDrawBuffer::DebugDrawBuffer()
+{
+	const std::scoped_lock lock{GetBuffersMutex()};
+	GetBuffers().push_back(this);
+}
+DebugDrawBuffer::~DebugDrawBuffer()
+{
+	const std::scoped_lock lock{GetBuffersMutex()};
+	std::erase(GetBuffers(), this);
+}
+
+void DebugDrawBuffer::Submit()
+{
+	if (this->lines.empty() && this->points.empty())
+		return;
+	rlBegin(RL_LINES);
+	for (const auto& line : this->lines)
+	{
+		rlColor4ub(line.colour.r, line.colour.g, line.colour.b,
+				   line.colour.a);
+		Vertex(line.start);
+		Vertex(line.end);
+	}
+	for (const auto& point : this->points)
+	{
+		rlColor4ub(point.colour.r, point.colour.g, point.colour.b,
+				   point.colour.a);
+		const float half{point.size * 0.5f};
+		for (const Vector3 axis : {Vector3{half, 0.0f, 0.0f},
+								   Vector3{0.0f, half, 0.0f},
+								   Vector3{0.0f, 0.0f, half}})
+		{
+			Vertex(point.pos - axis);
+			Vertex(point.pos + axis);
+		}
+	}
+	rlEnd();
+	this->lines.clear();
+	this->points.clear();
+}
+
+void SubmitDebugDraw()
+{
+	const std::scoped_lock lock{GetBuffersMutex()};
+	for (DebugDrawBuffer* buffer : GetBuffers())
+	{
+		buffer->Submit();
+	}
+}
+
+#ifdef PHYS_DEBUG_DRAW
+
+auto detail::GetDebugDrawBuffer() -> DebugDrawBuffer&
+{
+	thread_local DebugDrawBuffer buffer;
+	return buffer;
+}
+
+void DebugBox(const DebugCategory category, const BoundingBox& box,
+			  const Color colour)
+{
+	if (!IsDebugDrawEnabled(category))
+		return;
+	auto corner = [&box](const uint32_t i) -> Vector3
+	{
+		return {(i & 1U) != 0 ? box.max.x : box.min.x,
+				(i & 2U) != 0 ? box.max.y : box.min.y,
+				(i & 4U) != 0 ? box.max.z : box.min.z};
+	};
+	// Corners one bit apart share an edge
+	DebugDrawBuffer& buffer{detail::GetDebugDrawBuffer()};
+	for (uint32_t i{0}; i < 8; i++)
+	{
+		for (const uint32_t bit : {1U, 2U, 4U})
+		{
+			if ((i & bit) == 0)
+			{
+				buffer.AddLine(corner(i), corner(i | bit), colour);
+			}
+		}
+	}
+}
+void DebugSphere(const DebugCategory category, const Vector3 centre,
+				 const float radius, const Color colour)
+{
+	if (!IsDebugDrawEnabled(category))
+		return;
+	constexpr uint32_t SEGMENTS{16};
+	constexpr float STEP{2.0f * std::numbers::pi_v<float> / SEGMENTS};
+	DebugDrawBuffer& buffer{detail::GetDebugDrawBuffer()};
+	for (uint32_t i{0}; i < SEGMENTS; i++)
+	{
+		const float cos0{std::cos(STEP * static_cast<float>(i)) * radius};
+		const float sin0{std::sin(STEP * static_cast<float>(i)) * radius};
+		const float cos1{std::cos(STEP * static_cast<float>(i + 1)) * radius};
+		const float sin1{std::sin(STEP * static_cast<float>(i + 1)) * radius};
+		buffer.AddLine(centre + Vector3{cos0, sin0, 0.0f},
+					   centre + Vector3{cos1, sin1, 0.0f}, colour);
+		buffer.AddLine(centre + Vector3{cos0, 0.0f, sin0},
+					   centre + Vector3{cos1, 0.0f, sin1}, colour);
+		buffer.AddLine(centre + Vector3{0.0f, cos0, sin0},
+					   centre + Vector3{0.0f, cos1, sin1}, colour);
+	}
+}
+
+#endif // PHYS_DEBUG_DRAW
+
+} //namespace phys
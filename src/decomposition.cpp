@@ -0,0 +1,775 @@
+#include "decomposition.h"
+#include "collider.h"
+#include "halfEdge.h"
+#include "quickhull.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <ranges>
+#include <raylib.h>
+#include <raymath.h>
+#include <span>
+#include <thread>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace phys
+{
+
+using std::vector;
+
+namespace
+{
+
+using Triangle = std::array<Vector3, 3>;
+using Cell = std::array<int32_t, 3>;
+
+/** @brief Cost of an uneven split, per voxel of difference between sides. */
+constexpr float BALANCE_WEIGHT{0.05f};
+
+auto GetAxis(const Vector3 vec, const uint32_t axis) -> float
+{
+	return axis == 0 ? vec.x : (axis == 1 ? vec.y : vec.z);
+}
+void SetAxis(Vector3& vec, const uint32_t axis, const float value)
+{
+	(axis == 0 ? vec.x : (axis == 1 ? vec.y : vec.z)) = value;
+}
+
+/**
+ * @brief Runs func(i) for every i in [0, count), spread over at most threads
+ *        threads including the calling one.
+ */
+void ParallelFor(const uint32_t count, const uint32_t threads,
+				 const std::function<void(uint32_t)>& func)
+{
+	const uint32_t workers{std::min(threads, count)};
+	if (workers <= 1)
+	{
+		for (uint32_t i{0}; i < count; i++)
+		{
+			func(i);
+		}
+		return;
+	}
+	std::atomic<uint32_t> next{0};
+	auto work = [&next, count, &func]() -> void
+	{
+		for (uint32_t i{next++}; i < count; i = next++)
+		{
+			func(i);
+		}
+	};
+	vector<std::jthread> pool;
+	pool.reserve(workers - 1);
+	for (uint32_t i{1}; i < workers; i++)
+	{
+		pool.emplace_back(work);
+	}
+	work();
+}
+
+/**
+ * @brief Finds where the line through (y, z) running along +x crosses a
+ *        triangle. Edges follow a top-left rule, so a line through an edge
+ *        shared by two triangles crosses exactly one of them.
+ * @returns The x coordinate of the crossing, and +1 when entering the solid
+ *          or -1 when leaving it.
+ */
+auto CrossX(const Triangle& tri, const float y, const float z)
+	-> std::optional<std::pair<float, int32_t>>
+{
+	Vector2 a{tri[0].y, tri[0].z};
+	Vector2 b{tri[1].y, tri[1].z};
+	Vector2 c{tri[2].y, tri[2].z};
+	// Twice the triangle's area projected onto the yz plane, which is also
+	// the x component of its unnormalized normal
+	const float area{((b.x - a.x) * (c.y - a.y)) - ((b.y - a.y) * (c.x - a.x))};
+	if (area == 0.0f)
+		return std::nullopt;
+	if (area < 0.0f)
+		std::swap(b, c);
+
+	auto isInside = [y, z](const Vector2 from, const Vector2 to) -> bool
+	{
+		const Vector2 edge{to.x - from.x, to.y - from.y};
+		const float side{(edge.x * (z - from.y)) - (edge.y * (y - from.x))};
+		return side > 0.0f
+			   || (side == 0.0f
+				   && (edge.y > 0.0f || (edge.y == 0.0f && edge.x < 0.0f)));
+	};
+	if (!isInside(a, b) || !isInside(b, c) || !isInside(c, a))
+		return std::nullopt;
+
+	const Vector3 normal{
+		Vector3CrossProduct(tri[1] - tri[0], tri[2] - tri[0])};
+	const float x{tri[0].x
+				  - (((normal.y * (y - tri[0].y)) + (normal.z * (z - tri[0].z)))
+					 / normal.x)};
+	return std::pair{x, area > 0.0f ? -1 : 1};
+}
+
+/** @returns The volume of the convex hull of points. */
+auto HullVolume(std::span<const Vector3> points) -> float
+{
+	vector<HE::HVertex> verts;
+	vector<HE::FaceInit> faces;
+	if (!ComputeConvexHull(points, verts, faces))
+		return 0.0f;
+	float volume{0.0f};
+	for (const auto& face : faces)
+	{
+		const Vector3 a{verts[face.indices[0]].Vec()};
+		for (uint64_t i{2}; i < face.indices.size(); i++)
+		{
+			volume += Vector3DotProduct(
+				a, Vector3CrossProduct(verts[face.indices[i - 1]].Vec(),
+									   verts[face.indices[i]].Vec()));
+		}
+	}
+	return std::abs(volume) / 6.0f;
+}
+
+/** @brief A box of voxels and the solid voxels within it. */
+struct Part
+{
+	// The region this part owns, sibling parts never overlap
+	Cell lo{};
+	Cell hi{};
+	// The same region in mesh space, with cuts moved onto nearby features
+	BoundingBox region{};
+	// Bounds of the solid voxels inside the region
+	Cell solidLo{};
+	Cell solidHi{};
+	uint64_t voxels{0};
+	// Spanned by voxel centres, so it sits about half a voxel inside the
+	// surface. That margin absorbs the voxels' staircase on slopes.
+	float hullVolume{0.0f};
+	bool done{false};
+
+	/** @returns The volume inside the hull but outside the part. */
+	auto Concavity() const -> float
+	{
+		return std::max(this->hullVolume - static_cast<float>(this->voxels),
+						0.0f);
+	}
+};
+
+/** @brief A candidate plane splitting a part in two. */
+struct Cut
+{
+	uint32_t axis{0};
+	int32_t pos{0};
+	Part left{};
+	Part right{};
+	float cost{0.0f};
+};
+
+/**
+ * @brief Hierarchical splitting of a solid voxelization. All volumes are
+ *        measured in voxels.
+ */
+class Decomposer
+{
+	public:
+	Decomposer(vector<Triangle>&& tris, const BoundingBox bounds,
+			   const DecompositionSettings& settings, const uint32_t threads);
+
+	auto Solve() -> vector<Part>;
+	auto BuildHull(const Part& part, vector<HE::HVertex>& vertsOut,
+				   vector<HE::FaceInit>& facesOut) const -> bool;
+
+	private:
+	void Voxelize();
+	auto Evaluate(const Cell lo, const Cell hi) const -> Part;
+	auto FindCuts(const Part& part) const -> vector<Cut>;
+	void EvaluateCuts(const Part& part, vector<Cut>& cuts) const;
+	auto Split(const Part& part) const -> std::optional<Cut>;
+	auto IsSolid(const int32_t x, const int32_t y, const int32_t z) const
+		-> bool
+	{
+		return this->solid[static_cast<uint64_t>(
+								   (((z * this->dims[1]) + y) * this->dims[0])
+								   + x)]
+			   != 0;
+	}
+	auto ToWorld(const Vector3 gridPos) const -> Vector3
+	{
+		return this->origin + (gridPos * this->size);
+	}
+	auto Winding(const Vector3 point) const -> int32_t;
+	auto SnapCut(const uint32_t axis, const int32_t pos) const -> float;
+
+	vector<Triangle> tris;
+	// Sorted vertex coordinates along each axis
+	std::array<vector<float>, 3> coords;
+	DecompositionSettings settings;
+	uint32_t threads;
+
+	Cell dims{};
+	Vector3 origin{};
+	float size{0.0f};
+	vector<uint8_t> solid;
+	uint64_t totalVoxels{0};
+};
+
+Decomposer::Decomposer(vector<Triangle>&& tris, const BoundingBox bounds,
+					   const DecompositionSettings& settings,
+					   const uint32_t threads) :
+	tris(std::move(tris)), settings(settings), threads(threads)
+{
+	for (uint32_t axis{0}; axis < 3; axis++)
+	{
+		auto& axisCoords = this->coords[axis];
+		for (const auto& tri : this->tris)
+		{
+			for (const auto pos : tri)
+			{
+				axisCoords.push_back(GetAxis(pos, axis));
+			}
+		}
+		std::ranges::sort(axisCoords);
+		const auto [first, last] = std::ranges::unique(axisCoords);
+		axisCoords.erase(first, last);
+	}
+
+	const Vector3 extent{bounds.max - bounds.min};
+	const float longest{std::max({extent.x, extent.y, extent.z})};
+	// Thin meshes would otherwise produce an enormous grid along their other
+	// axes
+	this->size = std::max(
+		std::cbrt((extent.x * extent.y * extent.z)
+				  / static_cast<float>(std::max(settings.resolution, 1U))),
+		longest / 512.0f);
+	for (uint32_t i{0}; i < 3; i++)
+	{
+		this->dims[i] = std::max(1, static_cast<int32_t>(std::ceil(
+										GetAxis(extent, i) / this->size)));
+	}
+	const Vector3 gridExtent{Vector3{static_cast<float>(this->dims[0]),
+									 static_cast<float>(this->dims[1]),
+									 static_cast<float>(this->dims[2])}
+							 * this->size};
+	this->origin = ((bounds.min + bounds.max) - gridExtent) * 0.5f;
+	this->Voxelize();
+}
+
+void Decomposer::Voxelize()
+{
+	const auto [nx, ny, nz] = this->dims;
+	// Each row of voxels along x is filled by sorting where the line through
+	// its centres crosses the surface and tracking the winding number
+	vector<vector<std::pair<float, int32_t>>> rows(
+		static_cast<uint64_t>(ny * nz));
+	auto toRow = [this](const float pos, const float offset,
+						const int32_t count, const bool upper) -> int32_t
+	{
+		const float cell{((pos - offset) / this->size) - 0.5f};
+		const auto row{static_cast<int32_t>(upper ? std::floor(cell)
+												  : std::ceil(cell))};
+		return std::clamp(row, 0, count - 1);
+	};
+	for (const auto& tri : this->tris)
+	{
+		const float minY{std::min({tri[0].y, tri[1].y, tri[2].y})};
+		const float maxY{std::max({tri[0].y, tri[1].y, tri[2].y})};
+		const float minZ{std::min({tri[0].z, tri[1].z, tri[2].z})};
+		const float maxZ{std::max({tri[0].z, tri[1].z, tri[2].z})};
+		for (int32_t z{toRow(minZ, this->origin.z, nz, false)};
+			 z <= toRow(maxZ, this->origin.z, nz, true); z++)
+		{
+			for (int32_t y{toRow(minY, this->origin.y, ny, false)};
+				 y <= toRow(maxY, this->origin.y, ny, true); y++)
+			{
+				const auto hit = CrossX(
+					tri,
+					this->origin.y
+						+ ((static_cast<float>(y) + 0.5f) * this->size),
+					this->origin.z
+						+ ((static_cast<float>(z) + 0.5f) * this->size));
+				if (hit.has_value())
+					rows[static_cast<uint64_t>((z * ny) + y)].push_back(*hit);
+			}
+		}
+	}
+
+	this->solid.assign(static_cast<uint64_t>(nx * ny * nz), 0);
+	for (int32_t row{0}; row < ny * nz; row++)
+	{
+		auto& hits = rows[static_cast<uint64_t>(row)];
+		std::ranges::sort(hits);
+		int32_t winding{0};
+		uint64_t next{0};
+		for (int32_t x{0}; x < nx; x++)
+		{
+			const float centre{this->origin.x
+							   + ((static_cast<float>(x) + 0.5f) * this->size)};
+			for (; next < hits.size() && hits[next].first < centre; next++)
+			{
+				winding += hits[next].second;
+			}
+			if (winding != 0)
+			{
+				this->solid[static_cast<uint64_t>((row * nx) + x)] = 1;
+				this->totalVoxels++;
+			}
+		}
+	}
+}
+
+auto Decomposer::Evaluate(const Cell lo, const Cell hi) const -> Part
+{
+	Part part{.lo = lo, .hi = hi, .solidLo = hi, .solidHi = lo};
+	// Only the first and last solid voxel of each row can be on the hull
+	const int32_t rowCountY{hi[1] - lo[1]};
+	const int32_t rowCountZ{hi[2] - lo[2]};
+	vector<int32_t> rowFirst(static_cast<uint64_t>(rowCountY * rowCountZ),
+							 std::numeric_limits<int32_t>::max());
+	vector<int32_t> rowLast(rowFirst.size(),
+							std::numeric_limits<int32_t>::min());
+	auto row = [lo, rowCountY](const int32_t y, const int32_t z) -> uint64_t
+	{ return static_cast<uint64_t>(((z - lo[2]) * rowCountY) + (y - lo[1])); };
+	for (int32_t z{lo[2]}; z < hi[2]; z++)
+	{
+		for (int32_t y{lo[1]}; y < hi[1]; y++)
+		{
+			auto& first = rowFirst[row(y, z)];
+			auto& last = rowLast[row(y, z)];
+			for (int32_t x{lo[0]}; x < hi[0]; x++)
+			{
+				if (!this->IsSolid(x, y, z))
+					continue;
+				first = std::min(first, x);
+				last = x;
+				part.voxels++;
+			}
+			if (last < first)
+				continue;
+			part.solidLo = {std::min(part.solidLo[0], first),
+							std::min(part.solidLo[1], y),
+							std::min(part.solidLo[2], z)};
+			part.solidHi = {std::max(part.solidHi[0], last + 1),
+							std::max(part.solidHi[1], y + 1),
+							std::max(part.solidHi[2], z + 1)};
+		}
+	}
+	if (part.voxels == 0)
+		return part;
+
+	// A row end with neighbours on both sides that reach at least as far
+	// sits inside them, which strips the interior of flat faces
+	vector<Vector3> points;
+	auto reaches = [&row, lo, hi](const vector<int32_t>& ends, const int32_t y,
+								  const int32_t z, const auto isFurther) -> bool
+	{
+		if (y < lo[1] || y >= hi[1] || z < lo[2] || z >= hi[2])
+			return false;
+		return isFurther(ends[row(y, z)]);
+	};
+	for (int32_t z{lo[2]}; z < hi[2]; z++)
+	{
+		for (int32_t y{lo[1]}; y < hi[1]; y++)
+		{
+			if (rowLast[row(y, z)] < rowFirst[row(y, z)])
+				continue;
+			for (const bool isLast : {false, true})
+			{
+				const auto& ends = isLast ? rowLast : rowFirst;
+				const int32_t end{ends[row(y, z)]};
+				auto isFurther = [end, isLast](const int32_t other) -> bool
+				{ return isLast ? other >= end : other <= end; };
+				if ((reaches(ends, y - 1, z, isFurther)
+					 && reaches(ends, y + 1, z, isFurther))
+					|| (reaches(ends, y, z - 1, isFurther)
+						&& reaches(ends, y, z + 1, isFurther)))
+					continue;
+				points.emplace_back(static_cast<float>(end),
+									static_cast<float>(y),
+									static_cast<float>(z));
+			}
+		}
+	}
+	part.hullVolume = HullVolume(points);
+	return part;
+}
+
+auto Decomposer::FindCuts(const Part& part) const -> vector<Cut>
+{
+	vector<Cut> cuts;
+	for (uint32_t axis{0}; axis < 3; axis++)
+	{
+		const int32_t span{part.solidHi[axis] - part.solidLo[axis]};
+		const auto samples{std::min(
+			this->settings.planeSamples,
+			static_cast<uint32_t>(std::max(span - 1, 0)))};
+		for (uint32_t i{1}; i <= samples; i++)
+		{
+			const int32_t pos{
+				part.solidLo[axis]
+				+ std::max(1, static_cast<int32_t>(
+								  (i * static_cast<uint32_t>(span))
+								  / (samples + 1)))};
+			if (cuts.empty() || cuts.back().axis != axis
+				|| cuts.back().pos != pos)
+				cuts.push_back({.axis = axis, .pos = pos});
+		}
+	}
+
+	this->EvaluateCuts(part, cuts);
+	return cuts;
+}
+void Decomposer::EvaluateCuts(const Part& part, vector<Cut>& cuts) const
+{
+	ParallelFor(static_cast<uint32_t>(cuts.size()), this->threads,
+				[this, &part, &cuts](const uint32_t i) -> void
+				{
+					auto& cut = cuts[i];
+					Cell leftHi{part.hi};
+					Cell rightLo{part.lo};
+					leftHi[cut.axis] = cut.pos;
+					rightLo[cut.axis] = cut.pos;
+					cut.left = this->Evaluate(part.lo, leftHi);
+					cut.right = this->Evaluate(rightLo, part.hi);
+					// Slivers are cheap to shave off but rarely worth a hull
+					const auto imbalance{static_cast<float>(
+						std::max(cut.left.voxels, cut.right.voxels)
+						- std::min(cut.left.voxels, cut.right.voxels))};
+					cut.cost = cut.left.Concavity() + cut.right.Concavity()
+							   + (BALANCE_WEIGHT * imbalance);
+				});
+}
+auto Decomposer::Split(const Part& part) const -> std::optional<Cut>
+{
+	const auto cuts = this->FindCuts(part);
+	if (cuts.empty())
+		return std::nullopt;
+	auto best = std::ranges::min_element(cuts, {}, &Cut::cost);
+
+	// Some cuts only pay off after a second one, like halving a ring before
+	// quartering it. When no cut helps much on its own, the best cut along
+	// each axis is judged by how well its halves can be split in turn.
+	float expected{best->cost};
+	if (best->cost > part.Concavity() * 0.5f)
+	{
+		float bestCost{std::numeric_limits<float>::max()};
+		for (uint32_t axis{0}; axis < 3; axis++)
+		{
+			auto axisCuts = cuts
+							| std::views::filter([axis](const Cut& cut) -> bool
+												 { return cut.axis == axis; });
+			if (axisCuts.empty())
+				continue;
+			const auto candidate = std::ranges::min_element(axisCuts, {},
+															&Cut::cost);
+			float cost{0.0f};
+			for (const Part* half : {&candidate->left, &candidate->right})
+			{
+				const auto halfCuts = this->FindCuts(*half);
+				cost += halfCuts.empty()
+							? half->Concavity()
+							: std::min(half->Concavity(),
+									   std::ranges::min(halfCuts, {},
+														&Cut::cost)
+										   .cost);
+			}
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				best = candidate.base();
+			}
+		}
+		expected = bestCost;
+	}
+	// A part that can't be improved only spends the hull budget
+	if (expected >= part.Concavity())
+		return std::nullopt;
+
+	// The samples are spread over the whole part, so the winner is refined
+	// against every voxel boundary between it and its neighbouring samples
+	Cut cut{*best};
+	const int32_t span{part.solidHi[cut.axis] - part.solidLo[cut.axis]};
+	const int32_t step{span / static_cast<int32_t>(std::min(
+								  this->settings.planeSamples + 1,
+								  static_cast<uint32_t>(span)))};
+	vector<Cut> refined;
+	for (int32_t pos{std::max(cut.pos - step + 1, part.solidLo[cut.axis] + 1)};
+		 pos < std::min(cut.pos + step, part.solidHi[cut.axis]); pos++)
+	{
+		if (pos != cut.pos)
+			refined.push_back({.axis = cut.axis, .pos = pos});
+	}
+	this->EvaluateCuts(part, refined);
+	for (const auto& other : refined)
+	{
+		if (other.cost < cut.cost)
+			cut = other;
+	}
+
+	const float plane{this->SnapCut(cut.axis, cut.pos)};
+	cut.left.region = part.region;
+	cut.right.region = part.region;
+	SetAxis(cut.left.region.max, cut.axis, plane);
+	SetAxis(cut.right.region.min, cut.axis, plane);
+	return cut;
+}
+
+auto Decomposer::Solve() -> vector<Part>
+{
+	vector<Part> parts;
+	if (this->totalVoxels == 0)
+		return parts;
+	parts.push_back(this->Evaluate({0, 0, 0}, this->dims));
+	parts.back().region = {
+		.min = this->origin,
+		.max = this->ToWorld({static_cast<float>(this->dims[0]),
+							  static_cast<float>(this->dims[1]),
+							  static_cast<float>(this->dims[2])}),
+	};
+
+	const float threshold{this->settings.maxConcavity
+						  * static_cast<float>(this->totalVoxels)};
+	while (parts.size() < this->settings.maxHulls)
+	{
+		// The least convex part is always split first, so running out of
+		// hulls leaves the error spread as evenly as possible
+		auto worst = parts.end();
+		for (auto it = parts.begin(); it != parts.end(); it++)
+		{
+			if (!it->done
+				&& (worst == parts.end()
+					|| it->Concavity() > worst->Concavity()))
+				worst = it;
+		}
+		if (worst == parts.end() || worst->Concavity() <= threshold)
+			break;
+
+		auto split = this->Split(*worst);
+		if (!split.has_value())
+		{
+			worst->done = true;
+			continue;
+		}
+		*worst = split->left;
+		parts.push_back(split->right);
+	}
+	return parts;
+}
+
+auto Decomposer::Winding(const Vector3 point) const -> int32_t
+{
+	int32_t winding{0};
+	for (const auto& tri : this->tris)
+	{
+		const auto hit = CrossX(tri, point.y, point.z);
+		if (hit.has_value() && hit->first < point.x)
+			winding += hit->second;
+	}
+	return winding;
+}
+
+auto Decomposer::SnapCut(const uint32_t axis, const int32_t pos) const
+	-> float
+{
+	// Voxel boundaries rarely line up with the mesh, and a cut just off a
+	// step leaves a sliver of it that skews the whole hull. Cutting exactly
+	// on the nearest vertex within a voxel avoids that.
+	const float cut{GetAxis(this->origin, axis)
+					+ (static_cast<float>(pos) * this->size)};
+	const auto& axisCoords = this->coords[axis];
+	const auto next = std::ranges::lower_bound(axisCoords, cut);
+	float best{cut};
+	float bestDist{this->size};
+	if (next != axisCoords.end() && *next - cut < bestDist)
+	{
+		best = *next;
+		bestDist = *next - cut;
+	}
+	if (next != axisCoords.begin() && cut - *(next - 1) < bestDist)
+		best = *(next - 1);
+	return best;
+}
+auto Decomposer::BuildHull(const Part& part, vector<HE::HVertex>& vertsOut,
+						   vector<HE::FaceInit>& facesOut) const -> bool
+{
+	const Vector3 boxMin{part.region.min};
+	const Vector3 boxMax{part.region.max};
+
+	// The part is the solid inside its box, so its hull is spanned by the
+	// surface clipped to the box plus any box corners buried in the solid
+	vector<Vector3> points;
+	vector<Vector3> poly;
+	vector<Vector3> clipped;
+	const float tolerance{this->size * 0.001f};
+	auto isBehindFace = [boxMin, boxMax, tolerance](const Triangle& tri) -> bool
+	{
+		// A face lying on a cut with its solid on the far side belongs to
+		// the neighbouring part, it only touches this one
+		const Vector3 normal{
+			Vector3CrossProduct(tri[1] - tri[0], tri[2] - tri[0])};
+		for (uint32_t axis{0}; axis < 3; axis++)
+		{
+			for (const bool isMax : {false, true})
+			{
+				const float bound{GetAxis(isMax ? boxMax : boxMin, axis)};
+				const bool onPlane{std::ranges::all_of(
+					tri,
+					[axis, bound, tolerance](const Vector3 pos) -> bool
+					{
+						return std::abs(GetAxis(pos, axis) - bound)
+							   <= tolerance;
+					})};
+				const float facing{GetAxis(normal, axis)};
+				if (onPlane && (isMax ? facing < 0.0f : facing > 0.0f))
+					return true;
+			}
+		}
+		return false;
+	};
+	for (const auto& tri : this->tris)
+	{
+		if (isBehindFace(tri))
+			continue;
+		poly.assign(tri.begin(), tri.end());
+		for (uint32_t plane{0}; plane < 6 && !poly.empty(); plane++)
+		{
+			const uint32_t axis{plane / 2};
+			const bool isMax{plane % 2 == 1};
+			const float bound{GetAxis(isMax ? boxMax : boxMin, axis)};
+			auto dist = [axis, isMax, bound](const Vector3 pos) -> float
+			{
+				const float coord{GetAxis(pos, axis)};
+				return isMax ? bound - coord : coord - bound;
+			};
+			clipped.clear();
+			for (uint64_t i{0}; i < poly.size(); i++)
+			{
+				const Vector3 from{poly[i]};
+				const Vector3 to{poly[(i + 1) % poly.size()]};
+				const float fromDist{dist(from)};
+				const float toDist{dist(to)};
+				if (fromDist >= 0.0f)
+					clipped.push_back(from);
+				if ((fromDist < 0.0f) != (toDist < 0.0f))
+					clipped.push_back(
+						Vector3Lerp(from, to, fromDist / (fromDist - toDist)));
+			}
+			std::swap(poly, clipped);
+		}
+		// A face merely touching the box, such as a side wall running along
+		// a cut, clips down to a line that the part's solid doesn't reach
+		Vector3 area{};
+		for (uint64_t i{2}; i < poly.size(); i++)
+		{
+			area = area
+				   + Vector3CrossProduct(poly[i - 1] - poly[0],
+										 poly[i] - poly[0]);
+		}
+		if (Vector3Length(area) > tolerance * this->size)
+			points.insert(points.end(), poly.begin(), poly.end());
+	}
+	for (uint32_t i{0}; i < 8; i++)
+	{
+		const Vector3 corner{(i & 1) != 0 ? boxMax.x : boxMin.x,
+							 (i & 2) != 0 ? boxMax.y : boxMin.y,
+							 (i & 4) != 0 ? boxMax.z : boxMin.z};
+		// Corners often sit right on the surface, so the solid is sampled a
+		// hair inside the box instead
+		const Vector3 inset{
+			corner
+			+ (Vector3Normalize(((boxMin + boxMax) * 0.5f) - corner)
+			   * tolerance)};
+		if (this->Winding(inset) != 0)
+			points.push_back(corner);
+	}
+
+	HullSettings hullSettings{};
+	hullSettings.weldDistance = this->size * 0.001f;
+	hullSettings.maxVertices = this->settings.maxVertsPerHull;
+	return ComputeConvexHull(points, vertsOut, facesOut, hullSettings);
+}
+
+} // namespace
+
+auto CreateDecomposedCollider(const Mesh& mesh,
+							  const DecompositionSettings& settings)
+	-> Collider
+{
+	auto vertex = [&mesh](const uint64_t i) -> Vector3
+	{
+		const uint64_t id{mesh.indices != nullptr ? mesh.indices[i] : i};
+		return {mesh.vertices[(id * 3) + 0], mesh.vertices[(id * 3) + 1],
+				mesh.vertices[(id * 3) + 2]};
+	};
+	vector<Triangle> tris;
+	tris.reserve(static_cast<uint64_t>(mesh.triangleCount));
+	BoundingBox bounds{
+		Vector3{1.0f, 1.0f, 1.0f} * std::numeric_limits<float>::max(),
+		Vector3{1.0f, 1.0f, 1.0f} * -std::numeric_limits<float>::max()};
+	for (uint64_t i{0}; i < static_cast<uint64_t>(mesh.triangleCount); i++)
+	{
+		tris.push_back({vertex(i * 3), vertex((i * 3) + 1),
+						vertex((i * 3) + 2)});
+		for (const auto pos : tris.back())
+		{
+			bounds.min = Vector3Min(bounds.min, pos);
+			bounds.max = Vector3Max(bounds.max, pos);
+		}
+	}
+	const Vector3 extent{bounds.max - bounds.min};
+	if (tris.empty() || extent.x <= 0.0f || extent.y <= 0.0f
+		|| extent.z <= 0.0f)
+		return CreateHullCollider(mesh);
+
+#if defined(PLATFORM_WEB)
+	const uint32_t threads{1};
+#else
+	const uint32_t threads{settings.threads != 0
+							   ? settings.threads
+							   : std::max(std::thread::hardware_concurrency(),
+										  1U)};
+#endif // defined(PLATFORM_WEB)
+	Decomposer decomposer{std::move(tris), bounds, settings, threads};
+	const auto parts = decomposer.Solve();
+
+	vector<vector<HE::HVertex>> verts(parts.size());
+	vector<vector<HE::FaceInit>> faces(parts.size());
+	vector<uint8_t> built(parts.size(), 0);
+	ParallelFor(static_cast<uint32_t>(parts.size()), threads,
+				[&decomposer, &parts, &verts, &faces,
+				 &built](const uint32_t i) -> void
+				{
+					built[i] = decomposer.BuildHull(parts[i], verts[i],
+													faces[i])
+								   ? 1
+								   : 0;
+				});
+
+	vector<Collider> hulls;
+	for (uint64_t i{0}; i < parts.size(); i++)
+	{
+		if (built[i] == 0)
+			continue;
+		Vector3 centre{};
+		for (const auto& vert : verts[i])
+		{
+			centre = centre + vert.Vec();
+		}
+		centre = centre / static_cast<float>(verts[i].size());
+		hulls.emplace_back(std::in_place_type<HullCollider>, verts[i],
+						   faces[i], centre);
+	}
+	if (hulls.empty())
+		return CreateHullCollider(mesh);
+	if (hulls.size() == 1)
+		return hulls.front();
+	return CompoundCollider(hulls);
+}
+
+} //namespace phys
@@ -0,0 +1,211 @@
+#include "eventLog.h"
+#include "utils.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <raylib.h>
+#include <stop_token>
+#include <thread>
+
+namespace phys
+{
+
+namespace
+{
+
+auto GetLevelName(const LogLevel level) -> const char*
+{
+	switch (level)
+	{
+	case LogLevel::TRACE:
+		return "TRACE";
+	case LogLevel::DEBUG:
+		return "DEBUG";
+	case LogLevel::INFO:
+		return "INFO";
+	case LogLevel::WARNING:
+		return "WARN";
+	case LogLevel::ERROR:
+		return "ERROR";
+	}
+	return "";
+}
+auto GetLevelColour(const LogLevel level) -> Color
+{
+	switch (level)
+	{
+	case LogLevel::TRACE:
+	case LogLevel::DEBUG:
+		return {150, 150, 150, 0};
+	case LogLevel::INFO:
+		return INFO;
+	case LogLevel::WARNING:
+		return {230, 150, 0, 0};
+	case LogLevel::ERROR:
+		return ERROR;
+	}
+	return INFO;
+}
+
+} //namespace
+
+EventLog::EventLog(const char* path) :
+	slots(std::make_unique<Slot[]>(CAPACITY)),
+	start(std::chrono::steady_clock::now()), out(&std::cout),
+	useColour(path == nullptr)
+{
+	for (uint32_t i{0}; i < CAPACITY; i++)
+	{
+		this->slots[i].sequence.store(i, std::memory_order_relaxed);
+	}
+	if (path != nullptr)
+	{
+		this->file.open(path);
+		this->out = &this->file;
+	}
+#if !defined(PLATFORM_WEB)
+	this->drainer = std::jthread{[this](const std::stop_token stop) -> void
+								 { this->Drain(stop); }};
+#endif // !defined(PLATFORM_WEB)
+}
+
+auto EventLog::Push(const LogRecord& record) -> bool
+{
+	// A slot is free for position pos once its sequence has come round to
+	// pos, and holds a finished record once it has moved on to pos + 1
+	uint64_t pos{this->head.load(std::memory_order_relaxed)};
+	Slot* slot{nullptr};
+	while (true)
+	{
+		slot = &this->slots[pos & (CAPACITY - 1)];
+		const uint64_t sequence{slot->sequence.load(std::memory_order_acquire)};
+		const auto diff{static_cast<int64_t>(sequence - pos)};
+		if (diff == 0)
+		{
+			if (this->head.compare_exchange_weak(pos, pos + 1,
+												 std::memory_order_relaxed))
+				break;
+		}
+		else if (diff < 0)
+		{
+			// Still holds a record from a lap ago, so the ring is full
+			this->dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		else
+		{
+			pos = this->head.load(std::memory_order_relaxed);
+		}
+	}
+	slot->record = record;
+	slot->sequence.store(pos + 1, std::memory_order_release);
+#if defined(PLATFORM_WEB)
+	// No drain thread, and the pusher is the only thread there is
+	this->WritePending();
+#endif // defined(PLATFORM_WEB)
+	return true;
+}
+auto EventLog::Pop(LogRecord& out) -> bool
+{
+	const uint64_t pos{this->tail.load(std::memory_order_relaxed)};
+	Slot& slot{this->slots[pos & (CAPACITY - 1)]};
+	if (slot.sequence.load(std::memory_order_acquire) != pos + 1)
+		return false;
+	out = slot.record;
+	slot.sequence.store(pos + CAPACITY, std::memory_order_release);
+	this->tail.store(pos + 1, std::memory_order_release);
+	return true;
+}
+void EventLog::Flush()
+{
+#if defined(PLATFORM_WEB)
+	this->WritePending();
+#else
+	const uint64_t end{this->head.load(std::memory_order_acquire)};
+	while (this->tail.load(std::memory_order_acquire) < end)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds{1});
+	}
+#endif // defined(PLATFORM_WEB)
+}
+
+void EventLog::Drain(const std::stop_token stop)
+{
+	while (true)
+	{
+		// Checked before draining so records pushed up to the stop still
+		// make it out
+		const bool stopping{stop.stop_requested()};
+		this->WritePending();
+		if (stopping)
+			break;
+		std::this_thread::sleep_for(DRAIN_INTERVAL);
+	}
+}
+void EventLog::WritePending()
+{
+	LogRecord record{};
+	bool wrote{false};
+	while (this->Pop(record))
+	{
+		this->Write(record);
+		wrote = true;
+	}
+	const uint64_t dropped{this->GetDropped()};
+	if (dropped != this->reportedDropped)
+	{
+		this->Write({.time = this->Now(),
+					 .thread = GetLogThreadID(),
+					 .level = LogLevel::WARNING,
+					 .valueCount = 1,
+					 .message = "Log ring full, records dropped:",
+					 .values = {static_cast<float>(dropped
+												   - this->reportedDropped)}});
+		this->reportedDropped = dropped;
+		wrote = true;
+	}
+	if (wrote)
+	{
+		this->out->flush();
+	}
+}
+void EventLog::Write(const LogRecord& record)
+{
+	if (this->useColour)
+	{
+		SetTextColor(GetLevelColour(record.level));
+	}
+	*this->out << '[' << std::fixed << std::setprecision(6) << std::setw(12)
+			   << static_cast<double>(record.time) * 1e-9 << "] " << std::left
+			   << std::setw(5) << GetLevelName(record.level) << std::right
+			   << " t" << record.thread << ' ' << record.message
+			   << std::defaultfloat;
+	for (uint32_t i{0}; i < record.valueCount; i++)
+	{
+		*this->out << ' ' << record.values[i];
+	}
+	if (this->useColour)
+	{
+		ClearStyles();
+	}
+	*this->out << '\n';
+}
+
+auto GetEventLog() -> EventLog&
+{
+	static EventLog log;
+	return log;
+}
+auto GetLogThreadID() -> uint32_t
+{
+	static std::atomic<uint32_t> nextID{0};
+	thread_local const uint32_t id{
+		nextID.fetch_add(1, std::memory_order_relaxed)};
+	return id;
+}
+
+} //namespace phys
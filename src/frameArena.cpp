@@ -0,0 +1,69 @@
+#include "frameArena.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+
+namespace phys
+{
+
+FrameArena::FrameArena(const size_t initialSize)
+{
+	this->AddBlock(initialSize);
+	this->stats = {};
+}
+
+void FrameArena::Reset()
+{
+	// Merging is part of the overflow the last step already counted
+	this->lastStats = this->stats;
+	if (this->blocks.size() > 1)
+	{
+		size_t total{0};
+		for (const auto& block : this->blocks)
+		{
+			total += block.size;
+		}
+		this->blocks.clear();
+		this->AddBlock(total);
+	}
+	this->used = 0;
+	this->stats = {};
+}
+
+auto FrameArena::do_allocate(const size_t bytes, const size_t alignment)
+	-> void*
+{
+	void* ptr{this->blocks.back().data.get() + this->used};
+	size_t space{this->blocks.back().size - this->used};
+	if (std::align(alignment, bytes, ptr, space) == nullptr)
+	{
+		this->AddBlock(std::max(this->blocks.back().size * 2,
+								bytes + alignment));
+		ptr = this->blocks.back().data.get();
+		space = this->blocks.back().size;
+		std::align(alignment, bytes, ptr, space);
+	}
+	const size_t end{this->blocks.back().size - space + bytes};
+	this->stats.allocations++;
+	this->stats.bytes += end - this->used;
+	this->used = end;
+	return ptr;
+}
+
+void FrameArena::AddBlock(const size_t size)
+{
+	this->blocks.push_back(
+		{.data = std::make_unique_for_overwrite<std::byte[]>(size),
+		 .size = size});
+	this->used = 0;
+	this->stats.blockAllocations++;
+}
+
+auto GetFrameArena() -> FrameArena&
+{
+	thread_local FrameArena arena;
+	return arena;
+}
+
+} //namespace phys
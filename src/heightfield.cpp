@@ -0,0 +1,615 @@
+#include "collider.h"
+#include "colliderCache.h"
+#include "debugDraw.h"
+#include "eventLog.h"
+#include "frameArena.h"
+#include "primitiveTests.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <raylib.h>
+#include <raymath.h>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace phys
+{
+
+using std::optional;
+using std::vector;
+
+namespace
+{
+
+/** @brief Neighbours whose normals agree this closely are coplanar. */
+constexpr float FLAT_COSINE{0.9999f};
+constexpr float SAMPLE_MAX{65535.0f};
+
+/** @brief A sample of the grid, which may lie outside it. */
+struct GridPoint
+{
+	int64_t x;
+	int64_t z;
+};
+
+/** @brief Directions of the three edges starting in each cell. */
+enum class GridEdge : uint8_t
+{
+	/** @brief From (x, z) to (x + 1, z). */
+	X,
+	/** @brief From (x, z) to (x, z + 1). */
+	Z,
+	/** @brief From (x + 1, z) to (x, z + 1), splitting cell (x, z). */
+	DIAGONAL,
+};
+
+/** @brief A tile of one level of the hierarchy, waiting to be visited. */
+struct TileRef
+{
+	uint32_t level;
+	uint32_t x;
+	uint32_t z;
+	/** @brief Where a ray enters the tile, unused by overlap queries. */
+	float entry;
+};
+
+auto IsInGrid(const HeightfieldGeometry& geometry, const GridPoint point)
+	-> bool
+{
+	return point.x >= 0 && point.z >= 0 && point.x < geometry.width
+		   && point.z < geometry.depth;
+}
+auto GetGridPoint(const HeightfieldGeometry& geometry, const GridPoint point)
+	-> Vector3
+{
+	return geometry.GetPoint(static_cast<uint32_t>(point.x),
+							 static_cast<uint32_t>(point.z));
+}
+/** @returns The normal of the triangle abc, facing up out of the ground. */
+auto GetUpNormal(const Vector3 a, const Vector3 b, const Vector3 c) -> Vector3
+{
+	const Vector3 normal{Vector3Normalize(Vector3CrossProduct(b - a, c - a))};
+	return normal.y < 0.0f ? -normal : normal;
+}
+/**
+ * @returns false if the edge of the given direction from (x, z) is flat or
+ *          concave. Edges on the boundary are always active, and edges
+ *          leaving the grid never are.
+ */
+auto IsEdgeActive(const HeightfieldGeometry& geometry, const int64_t x,
+				  const int64_t z, const GridEdge edge) -> bool
+{
+	// The edge's ends, then the corners of the triangles either side of it
+	std::array<GridPoint, 4> points{};
+	switch (edge)
+	{
+	case GridEdge::X:
+		points = {{{x, z}, {x + 1, z}, {x, z + 1}, {x + 1, z - 1}}};
+		break;
+	case GridEdge::Z:
+		points = {{{x, z}, {x, z + 1}, {x + 1, z}, {x - 1, z + 1}}};
+		break;
+	case GridEdge::DIAGONAL:
+		points = {{{x + 1, z}, {x, z + 1}, {x, z}, {x + 1, z + 1}}};
+		break;
+	}
+	if (!IsInGrid(geometry, points[0]) || !IsInGrid(geometry, points[1]))
+		return false;
+	if (!IsInGrid(geometry, points[2]) || !IsInGrid(geometry, points[3]))
+		return true;
+
+	const Vector3 start{GetGridPoint(geometry, points[0])};
+	const Vector3 end{GetGridPoint(geometry, points[1])};
+	const Vector3 other{GetGridPoint(geometry, points[3])};
+	const Vector3 normal{
+		GetUpNormal(start, end, GetGridPoint(geometry, points[2]))};
+	if (Vector3DotProduct(normal, GetUpNormal(start, end, other))
+		>= FLAT_COSINE)
+		return false;
+	return Vector3DotProduct(normal, other - start) <= 0.0f;
+}
+/** @returns true if any of the six edges touching (x, z) is active. */
+auto IsVertexActive(const HeightfieldGeometry& geometry, const int64_t x,
+					const int64_t z) -> bool
+{
+	return IsEdgeActive(geometry, x, z, GridEdge::X)
+		   || IsEdgeActive(geometry, x - 1, z, GridEdge::X)
+		   || IsEdgeActive(geometry, x, z, GridEdge::Z)
+		   || IsEdgeActive(geometry, x, z - 1, GridEdge::Z)
+		   || IsEdgeActive(geometry, x - 1, z, GridEdge::DIAGONAL)
+		   || IsEdgeActive(geometry, x, z - 1, GridEdge::DIAGONAL);
+}
+
+/** @returns The first and last cell along one axis under [low, high]. */
+auto GetCellSpan(const float low, const float high, const float cellSize,
+				 const uint32_t cells) -> std::pair<uint32_t, uint32_t>
+{
+	const float last{static_cast<float>(cells - 1)};
+	return {static_cast<uint32_t>(
+				std::clamp(std::floor(low / cellSize), 0.0f, last)),
+			static_cast<uint32_t>(
+				std::clamp(std::floor(high / cellSize), 0.0f, last))};
+}
+/** @returns The cells a tile covers along one axis, end exclusive. */
+auto GetTileSpan(const uint32_t level, const uint32_t tile,
+				 const uint32_t cells) -> std::pair<uint32_t, uint32_t>
+{
+	const uint32_t shift{level + HeightfieldGeometry::TILE_SHIFT};
+	return {tile << shift, std::min((tile + 1) << shift, cells)};
+}
+auto GetTileBounds(const HeightfieldGeometry& geometry, const TileRef& tile)
+	-> BoundingBox
+{
+	const auto [startX, endX] = GetTileSpan(tile.level, tile.x,
+											geometry.CellsX());
+	const auto [startZ, endZ] = GetTileSpan(tile.level, tile.z,
+											geometry.CellsZ());
+	const HeightRange& range{geometry.GetTile(tile.level, tile.x, tile.z)};
+	const auto height = [&geometry](const uint16_t sample) -> float
+	{
+		return geometry.heightOffset
+			   + (static_cast<float>(sample) * geometry.heightScale);
+	};
+	return {
+		.min = {static_cast<float>(startX) * geometry.cellSize.x,
+				height(range.min),
+				static_cast<float>(startZ) * geometry.cellSize.y},
+		.max = {static_cast<float>(endX) * geometry.cellSize.x,
+				height(range.max),
+				static_cast<float>(endZ) * geometry.cellSize.y},
+	};
+}
+/** @returns The samples at the corners of a cell, for either triangle. */
+auto GetCellTriangle(const uint32_t x, const uint32_t z, const uint32_t half)
+	-> std::array<GridPoint, 3>
+{
+	const int64_t i{x};
+	const int64_t j{z};
+	if (half == 0)
+		return {{{i, j}, {i, j + 1}, {i + 1, j}}};
+	return {{{i + 1, j}, {i, j + 1}, {i + 1, j + 1}}};
+}
+
+/**
+ * @returns Where each edge of a cell's triangle starts and which way it
+ *          goes, edge j running from corner j to the next like MeshTriangle.
+ */
+auto GetCellEdges(const uint32_t x, const uint32_t z, const uint32_t half)
+	-> std::array<std::pair<GridPoint, GridEdge>, 3>
+{
+	const int64_t i{x};
+	const int64_t j{z};
+	if (half == 0)
+		return {{{{i, j}, GridEdge::Z},
+				 {{i, j}, GridEdge::DIAGONAL},
+				 {{i, j}, GridEdge::X}}};
+	return {{{{i, j}, GridEdge::DIAGONAL},
+			 {{i, j + 1}, GridEdge::X},
+			 {{i + 1, j}, GridEdge::Z}}};
+}
+
+auto GetTopTile(const HeightfieldGeometry& geometry) -> TileRef
+{
+	return {.level = static_cast<uint32_t>(geometry.levels.size() - 1),
+			.x = 0,
+			.z = 0,
+			.entry = 0.0f};
+}
+/** @brief Calls visit with each tile of the level below that tile covers. */
+template <typename Visit>
+void VisitChildren(const HeightfieldGeometry& geometry, const TileRef& tile,
+				   const Visit& visit)
+{
+	const HeightTileLevel& below{geometry.levels[tile.level - 1]};
+	const uint32_t endX{std::min((tile.x * 2) + 2, below.width)};
+	const uint32_t endZ{std::min((tile.z * 2) + 2, below.depth)};
+	for (uint32_t z{tile.z * 2}; z < endZ; z++)
+	{
+		for (uint32_t x{tile.x * 2}; x < endX; x++)
+		{
+			visit(TileRef{
+				.level = tile.level - 1, .x = x, .z = z, .entry = 0.0f});
+		}
+	}
+}
+
+} //namespace
+
+auto HeightfieldGeometry::GetBounds() const -> BoundingBox
+{
+	const HeightRange& top{this->tiles.back()};
+	return {
+		.min = {0.0f,
+				this->heightOffset
+					+ (static_cast<float>(top.min) * this->heightScale),
+				0.0f},
+		.max = {static_cast<float>(this->CellsX()) * this->cellSize.x,
+				this->heightOffset
+					+ (static_cast<float>(top.max) * this->heightScale),
+				static_cast<float>(this->CellsZ()) * this->cellSize.y},
+	};
+}
+void HeightfieldGeometry::FindLevels()
+{
+	const uint32_t tileCells{1U << TILE_SHIFT};
+	uint32_t width{(this->CellsX() + tileCells - 1) >> TILE_SHIFT};
+	uint32_t depth{(this->CellsZ() + tileCells - 1) >> TILE_SHIFT};
+	uint32_t offset{0};
+	this->levels.clear();
+	while (true)
+	{
+		this->levels.push_back(
+			{.offset = offset, .width = width, .depth = depth});
+		offset += width * depth;
+		if (width == 1 && depth == 1)
+			break;
+		width = (width + 1) / 2;
+		depth = (depth + 1) / 2;
+	}
+	this->tiles.resize(offset);
+}
+void HeightfieldGeometry::BuildTiles()
+{
+	const HeightTileLevel& finest{this->levels.front()};
+	for (uint32_t z{0}; z < finest.depth; z++)
+	{
+		for (uint32_t x{0}; x < finest.width; x++)
+		{
+			// Tiles share the samples along their borders
+			const auto [startX, endX] = GetTileSpan(0, x, this->CellsX());
+			const auto [startZ, endZ] = GetTileSpan(0, z, this->CellsZ());
+			HeightRange range{.min = UINT16_MAX, .max = 0};
+			for (uint32_t j{startZ}; j <= endZ; j++)
+			{
+				for (uint32_t i{startX}; i <= endX; i++)
+				{
+					range.min = std::min(range.min, this->GetSample(i, j));
+					range.max = std::max(range.max, this->GetSample(i, j));
+				}
+			}
+			this->tiles[finest.offset + (z * finest.width) + x] = range;
+		}
+	}
+	for (uint32_t level{1}; level < this->levels.size(); level++)
+	{
+		const HeightTileLevel& info{this->levels[level]};
+		for (uint32_t z{0}; z < info.depth; z++)
+		{
+			for (uint32_t x{0}; x < info.width; x++)
+			{
+				HeightRange range{.min = UINT16_MAX, .max = 0};
+				VisitChildren(
+					*this, {.level = level, .x = x, .z = z, .entry = 0.0f},
+					[this, &range](const TileRef& child) -> void
+					{
+						const HeightRange& below{
+							this->GetTile(child.level, child.x, child.z)};
+						range.min = std::min(range.min, below.min);
+						range.max = std::max(range.max, below.max);
+					});
+				this->tiles[info.offset + (z * info.width) + x] = range;
+			}
+		}
+	}
+}
+
+HeightfieldCollider::HeightfieldCollider(std::span<const float> heights,
+										 const uint32_t width,
+										 const uint32_t depth,
+										 const Vector2 cellSize)
+{
+	// Under 2 samples a side there are no cells, and the tile levels would
+	// never shrink down to one, so such grids become a single flat cell
+	const bool valid{width >= 2 && depth >= 2
+					 && heights.size() == uint64_t{width} * depth};
+	if (!valid)
+	{
+		Log<LogLevel::WARNING>("Heightfield needs 2 samples a side, got",
+							   width, depth, heights.size());
+	}
+	constexpr std::array<float, 4> FLAT_CELL{};
+	const std::span<const float> samples{valid ? heights : FLAT_CELL};
+	auto geometry{std::make_shared<HeightfieldGeometry>()};
+	geometry->width = valid ? width : 2;
+	geometry->depth = valid ? depth : 2;
+	geometry->cellSize = cellSize;
+	const auto [low, high] = std::ranges::minmax(samples);
+	geometry->heightOffset = low;
+	// A flat heightfield still needs a scale it can divide by
+	geometry->heightScale = high > low ? (high - low) / SAMPLE_MAX : 1.0f;
+	geometry->samples.reserve(samples.size());
+	for (const float height : samples)
+	{
+		geometry->samples.push_back(static_cast<uint16_t>(
+			std::round((height - low) / geometry->heightScale)));
+	}
+	geometry->FindLevels();
+	geometry->BuildTiles();
+	this->geometry = std::move(geometry);
+}
+HeightfieldCollider::HeightfieldCollider(const HeightfieldView& view)
+{
+	auto geometry{std::make_shared<HeightfieldGeometry>()};
+	geometry->width = view.width;
+	geometry->depth = view.depth;
+	geometry->cellSize = view.cellSize;
+	geometry->heightOffset = view.heightOffset;
+	geometry->heightScale = view.heightScale;
+	geometry->samples.assign(view.samples.begin(), view.samples.end());
+	geometry->FindLevels();
+	std::ranges::copy(view.tiles, geometry->tiles.begin());
+	this->geometry = std::move(geometry);
+	this->transform = view.transform;
+	this->inverseTransform = MatrixInvert(view.transform);
+}
+
+auto HeightfieldCollider::GetOrigin() const -> Vector3
+{
+	const BoundingBox bounds{this->geometry->GetBounds()};
+	return ((bounds.min + bounds.max) * 0.5f) * this->transform;
+}
+void HeightfieldCollider::GetTransformed(
+	const Matrix trans, std::pmr::vector<Collider>& out) const
+{
+	HeightfieldCollider copy{*this};
+	copy.transform = this->transform * trans;
+	copy.inverseTransform = MatrixInvert(copy.transform);
+	out.emplace_back(std::move(copy));
+}
+auto HeightfieldCollider::GetSupportPoint(const Vector3 axis) const
+	-> Vector3
+{
+	const BoundingBox bounds{this->geometry->GetBounds()};
+	Vector3 best{bounds.min * this->transform};
+	for (uint32_t i{1}; i < 8; i++)
+	{
+		const Vector3 corner{
+			Vector3{(i & 1U) != 0 ? bounds.max.x : bounds.min.x,
+					(i & 2U) != 0 ? bounds.max.y : bounds.min.y,
+					(i & 4U) != 0 ? bounds.max.z : bounds.min.z}
+			* this->transform};
+		if (Vector3DotProduct(corner, axis) > Vector3DotProduct(best, axis))
+		{
+			best = corner;
+		}
+	}
+	return best;
+}
+auto HeightfieldCollider::GetBounds() const -> BoundingBox
+{
+	return TransformBounds(this->geometry->GetBounds(), this->transform);
+}
+auto HeightfieldCollider::GetTriangle(const uint32_t i) const -> MeshTriangle
+{
+	const HeightfieldGeometry& geometry{*this->geometry};
+	const uint32_t cell{i / 2};
+	const uint32_t x{cell % geometry.CellsX()};
+	const uint32_t z{cell / geometry.CellsX()};
+	const auto corners{GetCellTriangle(x, z, i % 2)};
+	const auto edges{GetCellEdges(x, z, i % 2)};
+
+	MeshTriangle out{.verts = {}, .normal = {}, .activeFeatures = 0};
+	for (uint32_t j{0}; j < 3; j++)
+	{
+		out.verts[j] = GetGridPoint(geometry, corners[j]) * this->transform;
+		const auto& [start, edge] = edges[j];
+		if (IsEdgeActive(geometry, start.x, start.z, edge))
+		{
+			out.activeFeatures |= MESH_EDGE_0 << j;
+		}
+		if (IsVertexActive(geometry, corners[j].x, corners[j].z))
+		{
+			out.activeFeatures |= MESH_VERTEX_0 << j;
+		}
+	}
+	out.normal = Vector3Normalize(Vector3CrossProduct(
+		out.verts[1] - out.verts[0], out.verts[2] - out.verts[0]));
+	return out;
+}
+void HeightfieldCollider::GetOverlaps(const BoundingBox& box,
+									  std::pmr::vector<uint32_t>& out) const
+{
+	const HeightfieldGeometry& geometry{*this->geometry};
+	const BoundingBox local{TransformBounds(box, this->inverseTransform)};
+	if (!CheckCollisionBoxes(local, geometry.GetBounds()))
+		return;
+	const auto [minX, maxX] = GetCellSpan(local.min.x, local.max.x,
+										  geometry.cellSize.x,
+										  geometry.CellsX());
+	const auto [minZ, maxZ] = GetCellSpan(local.min.z, local.max.z,
+										  geometry.cellSize.y,
+										  geometry.CellsZ());
+	const auto toSample = [&geometry](const float height) -> float
+	{
+		return std::clamp((height - geometry.heightOffset)
+							  / geometry.heightScale,
+						  0.0f, SAMPLE_MAX);
+	};
+	const auto low{static_cast<uint16_t>(std::floor(toSample(local.min.y)))};
+	const auto high{static_cast<uint16_t>(std::ceil(toSample(local.max.y)))};
+	const auto overlaps = [low, high](const HeightRange& range) -> bool
+	{ return range.max >= low && range.min <= high; };
+
+	std::pmr::vector<TileRef> stack{{GetTopTile(geometry)},
+									out.get_allocator()};
+	while (!stack.empty())
+	{
+		const TileRef tile{stack.back()};
+		stack.pop_back();
+		const auto [startX, endX] = GetTileSpan(tile.level, tile.x,
+												geometry.CellsX());
+		const auto [startZ, endZ] = GetTileSpan(tile.level, tile.z,
+												geometry.CellsZ());
+		if (startX > maxX || endX <= minX || startZ > maxZ || endZ <= minZ
+			|| !overlaps(geometry.GetTile(tile.level, tile.x, tile.z)))
+			continue;
+		if (tile.level > 0)
+		{
+			VisitChildren(geometry, tile,
+						  [&stack](const TileRef& child) -> void
+						  { stack.push_back(child); });
+			continue;
+		}
+		for (uint32_t z{std::max(startZ, minZ)}; z < std::min(endZ, maxZ + 1);
+			 z++)
+		{
+			for (uint32_t x{std::max(startX, minX)};
+				 x < std::min(endX, maxX + 1); x++)
+			{
+				const std::array corners{
+					geometry.GetSample(x, z), geometry.GetSample(x + 1, z),
+					geometry.GetSample(x, z + 1),
+					geometry.GetSample(x + 1, z + 1)};
+				const auto [lowest, highest] = std::ranges::minmax(corners);
+				if (!overlaps({.min = lowest, .max = highest}))
+					continue;
+				const uint32_t cell{(z * geometry.CellsX()) + x};
+				out.push_back(cell * 2);
+				out.push_back((cell * 2) + 1);
+			}
+		}
+	}
+}
+auto HeightfieldCollider::Raycast(const Ray ray) const -> optional<float>
+{
+	const HeightfieldGeometry& geometry{*this->geometry};
+	const Ray local{GetLocalRay(ray, this->inverseTransform)};
+	const Vector3 invDir{GetInverseDir(local.direction)};
+	const auto maxDist = [](const optional<float> best) -> float
+	{ return best.value_or(std::numeric_limits<float>::max()); };
+
+	optional<float> best;
+	TileRef top{GetTopTile(geometry)};
+	const auto topEntry{RaycastBounds(local.position, invDir,
+									  GetTileBounds(geometry, top),
+									  maxDist(best))};
+	if (!topEntry.has_value())
+		return std::nullopt;
+	top.entry = *topEntry;
+	// Tiles are visited front to back, so the first hit ends the search as
+	// soon as every tile left starts beyond it
+	std::pmr::vector<TileRef> stack{{top}, &GetFrameArena()};
+	while (!stack.empty())
+	{
+		const TileRef tile{stack.back()};
+		stack.pop_back();
+		if (tile.entry > maxDist(best))
+			continue;
+		if (tile.level > 0)
+		{
+			std::array<TileRef, 4> children{};
+			uint32_t count{0};
+			VisitChildren(
+				geometry, tile,
+				[&geometry, &local, invDir, &maxDist, &best, &children,
+				 &count](TileRef child) -> void
+				{
+					const auto entry{RaycastBounds(
+						local.position, invDir,
+						GetTileBounds(geometry, child), maxDist(best))};
+					if (entry.has_value())
+					{
+						child.entry = *entry;
+						children[count++] = child;
+					}
+				});
+			// Furthest first, so the nearest is popped next
+			std::sort(children.begin(), children.begin() + count,
+					  [](const TileRef& a, const TileRef& b) -> bool
+					  { return a.entry > b.entry; });
+			stack.insert(stack.end(), children.begin(),
+						 children.begin() + count);
+			continue;
+		}
+		const auto [startX, endX] = GetTileSpan(0, tile.x, geometry.CellsX());
+		const auto [startZ, endZ] = GetTileSpan(0, tile.z, geometry.CellsZ());
+		for (uint32_t z{startZ}; z < endZ; z++)
+		{
+			for (uint32_t x{startX}; x < endX; x++)
+			{
+				for (uint32_t half{0}; half < 2; half++)
+				{
+					const auto corners{GetCellTriangle(x, z, half)};
+					const auto dist{RaycastTriangle(
+						local, {GetGridPoint(geometry, corners[0]),
+								GetGridPoint(geometry, corners[1]),
+								GetGridPoint(geometry, corners[2])})};
+					if (dist.has_value() && *dist < maxDist(best))
+					{
+						best = dist;
+					}
+				}
+			}
+		}
+	}
+	return best;
+}
+void HeightfieldCollider::DebugDraw(const Matrix& transform,
+									const Color& col) const
+{
+	if (!IsDebugDrawEnabled(DEBUG_HULLS))
+		return;
+	const HeightfieldGeometry& geometry{*this->geometry};
+	const Matrix trans{this->transform * transform};
+	for (uint32_t z{0}; z < geometry.depth; z++)
+	{
+		for (uint32_t x{0}; x < geometry.width; x++)
+		{
+			const Vector3 point{geometry.GetPoint(x, z) * trans};
+			if (x + 1 < geometry.width)
+			{
+				DebugLine(DEBUG_HULLS, point,
+						  geometry.GetPoint(x + 1, z) * trans, col);
+			}
+			if (z + 1 < geometry.depth)
+			{
+				DebugLine(DEBUG_HULLS, point,
+						  geometry.GetPoint(x, z + 1) * trans, col);
+			}
+		}
+	}
+}
+
+auto CreateHeightfieldCollider(const Image& heightmap, const Vector3 size)
+	-> Collider
+{
+	if (heightmap.width < 2 || heightmap.height < 2)
+	{
+		// Like flat meshes, a heightmap with no cells gets a thin box over
+		// the ground it would have covered instead
+		Log<LogLevel::WARNING>("Heightmap needs 2 pixels a side, got",
+							   heightmap.width, heightmap.height);
+		constexpr float THICKNESS{0.001f};
+		return CreateBoxCollider(
+			MatrixScale(std::max(size.x, THICKNESS), THICKNESS,
+						std::max(size.z, THICKNESS))
+			* MatrixTranslate(size.x / 2.0f, 0.0f, size.z / 2.0f));
+	}
+	const auto width{static_cast<uint32_t>(heightmap.width)};
+	const auto depth{static_cast<uint32_t>(heightmap.height)};
+	Color* pixels{LoadImageColors(heightmap)};
+	vector<float> heights;
+	heights.reserve(width * depth);
+	for (uint32_t i{0}; i < width * depth; i++)
+	{
+		// The same grey GenMeshHeightmap() uses
+		const float grey{static_cast<float>(pixels[i].r + pixels[i].g
+											+ pixels[i].b)
+						 / 3.0f};
+		heights.push_back(grey * size.y / 255.0f);
+	}
+	UnloadImageColors(pixels);
+	return HeightfieldCollider{heights, width, depth,
+							   {size.x / static_cast<float>(width - 1),
+								size.z / static_cast<float>(depth - 1)}};
+}
+
+} //namespace phys
@@ -0,0 +1,132 @@
+#include "hullRegistry.h"
+#include "collider.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <raylib.h>
+#include <unordered_map>
+#include <variant>
+
+namespace phys
+{
+
+namespace
+{
+
+/** @brief FNV-1a over everything that makes two hulls the same shape. */
+auto HashHull(const HullGeometry& hull) -> uint64_t
+{
+	uint64_t hash{0xcbf29ce484222325};
+	auto mix = [&hash](const uint32_t value) -> void
+	{
+		hash ^= value;
+		hash *= 0x100000001b3;
+	};
+	auto mixVec = [&mix](const Vector3 vec) -> void
+	{
+		mix(std::bit_cast<uint32_t>(vec.x));
+		mix(std::bit_cast<uint32_t>(vec.y));
+		mix(std::bit_cast<uint32_t>(vec.z));
+	};
+	mix(static_cast<uint32_t>(hull.vertices.size()));
+	mix(static_cast<uint32_t>(hull.edges.size()));
+	mix(static_cast<uint32_t>(hull.faces.size()));
+	for (const auto& vert : hull.vertices)
+	{
+		mixVec(vert.Vec());
+	}
+	for (const auto& face : hull.faces)
+	{
+		mix(face.edgeID);
+	}
+	mixVec(hull.origin);
+	return hash;
+}
+auto IsSameHull(const HullGeometry& a, const HullGeometry& b) -> bool
+{
+	auto sameVec = [](const Vector3 vecA, const Vector3 vecB) -> bool
+	{ return vecA.x == vecB.x && vecA.y == vecB.y && vecA.z == vecB.z; };
+	auto sameVert = [&sameVec](const HE::HVertex& vertA,
+							   const HE::HVertex& vertB) -> bool
+	{
+		return sameVec(vertA.Vec(), vertB.Vec())
+			   && vertA.edgeID == vertB.edgeID;
+	};
+	auto sameEdge = [](const HE::HEdge& edgeA, const HE::HEdge& edgeB) -> bool
+	{
+		return edgeA.vertID == edgeB.vertID && edgeA.twinID == edgeB.twinID
+			   && edgeA.nextID == edgeB.nextID && edgeA.faceID == edgeB.faceID;
+	};
+	auto sameFace = [&sameVec](const HE::HFace& faceA,
+							   const HE::HFace& faceB) -> bool
+	{
+		return sameVec(faceA.normal, faceB.normal)
+			   && faceA.edgeID == faceB.edgeID;
+	};
+	return sameVec(a.origin, b.origin)
+		   && std::ranges::equal(a.vertices, b.vertices, sameVert)
+		   && std::ranges::equal(a.edges, b.edges, sameEdge)
+		   && std::ranges::equal(a.faces, b.faces, sameFace)
+		   && std::ranges::equal(a.edgeDirs, b.edgeDirs, sameVec);
+}
+
+} //namespace
+
+void HullRegistry::Intern(Collider& col)
+{
+	if (auto* hull = std::get_if<HullCollider>(&col))
+	{
+		hull->geometry = this->InternGeometry(hull->geometry);
+	}
+	else if (auto* compound = std::get_if<CompoundCollider>(&col))
+	{
+		for (auto& child : compound->colliders)
+		{
+			this->Intern(child);
+		}
+	}
+}
+auto HullRegistry::InternGeometry(
+	std::shared_ptr<const HullGeometry> geometry)
+	-> std::shared_ptr<const HullGeometry>
+{
+	const uint64_t hash{HashHull(*geometry)};
+	const std::scoped_lock lock{this->mutex};
+	auto [first, last] = this->hulls.equal_range(hash);
+	for (auto entry{first}; entry != last; entry++)
+	{
+		auto existing{entry->second.lock()};
+		if (existing != nullptr && IsSameHull(*existing, *geometry))
+			return existing;
+	}
+	this->hulls.emplace(hash, geometry);
+	if (this->hulls.size() >= this->pruneSize)
+	{
+		this->Prune();
+		this->pruneSize = std::max<uint64_t>(64, this->hulls.size() * 2);
+	}
+	return geometry;
+}
+auto HullRegistry::GetLiveCount() -> uint32_t
+{
+	const std::scoped_lock lock{this->mutex};
+	this->Prune();
+	return static_cast<uint32_t>(this->hulls.size());
+}
+void HullRegistry::Prune()
+{
+	std::erase_if(this->hulls,
+				  [](const auto& entry) -> bool
+				  { return entry.second.expired(); });
+}
+
+auto GetHullRegistry() -> HullRegistry&
+{
+	static HullRegistry registry;
+	return registry;
+}
+
+} //namespace phys
@@ -0,0 +1,477 @@
+#include "hullSimplify.h"
+#include "collider.h"
+#include "halfEdge.h"
+#include "quickhull.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <raylib.h>
+#include <raymath.h>
+#include <variant>
+#include <vector>
+
+namespace phys
+{
+
+using std::vector;
+
+namespace
+{
+
+/** @brief Plane ID given to the faces of the box polytopes start out as. */
+constexpr uint32_t BOX_PLANE{std::numeric_limits<uint32_t>::max()};
+/** @brief Half size of the starting box, relative to the hull's extents. */
+constexpr float BOX_SCALE{64.0f};
+
+/** @brief The half-space dot(normal, x) <= offset. */
+struct HalfSpace
+{
+	Vector3 normal{};
+	float offset{0.0f};
+
+	auto Distance(const Vector3 point) const -> float
+	{
+		return Vector3DotProduct(this->normal, point) - this->offset;
+	}
+};
+
+/**
+ * @brief Face of a polytope under construction, wound counter clockwise when
+ *        seen from outside.
+ */
+struct Polygon
+{
+	vector<Vector3> verts;
+	uint32_t plane{BOX_PLANE};
+};
+
+/** @brief Convex polytope built by clipping a box with half-spaces. */
+class Polytope
+{
+	public:
+	Polytope(const Vector3 centre, const float halfSize);
+
+	void Clip(const HalfSpace& space, const uint32_t plane, const float eps);
+	auto Volume() const -> float;
+	void GetVertices(vector<Vector3>& out, const float eps) const;
+
+	auto Faces() const -> const vector<Polygon>& { return this->faces; }
+
+	private:
+	vector<Polygon> faces;
+};
+
+Polytope::Polytope(const Vector3 centre, const float halfSize)
+{
+	const float s{halfSize};
+	const auto corner = [centre, s](const float x, const float y,
+									const float z) -> Vector3
+	{
+		return centre + Vector3{x * s, y * s, z * s};
+	};
+	this->faces = {
+		{{corner(1, -1, -1), corner(1, 1, -1), corner(1, 1, 1),
+		  corner(1, -1, 1)}},
+		{{corner(-1, -1, -1), corner(-1, -1, 1), corner(-1, 1, 1),
+		  corner(-1, 1, -1)}},
+		{{corner(-1, 1, -1), corner(-1, 1, 1), corner(1, 1, 1),
+		  corner(1, 1, -1)}},
+		{{corner(-1, -1, -1), corner(1, -1, -1), corner(1, -1, 1),
+		  corner(-1, -1, 1)}},
+		{{corner(-1, -1, 1), corner(1, -1, 1), corner(1, 1, 1),
+		  corner(-1, 1, 1)}},
+		{{corner(-1, -1, -1), corner(-1, 1, -1), corner(1, 1, -1),
+		  corner(1, -1, -1)}},
+	};
+}
+
+/**
+ * @brief Cuts away everything outside of space, closing the hole with a new
+ *        face tagged with plane. Planes that cut nothing add no face.
+ */
+void Polytope::Clip(const HalfSpace& space, const uint32_t plane,
+					const float eps)
+{
+	const bool cuts{std::ranges::any_of(
+		this->faces, [&space, eps](const Polygon& face) -> bool
+		{
+			return std::ranges::any_of(
+				face.verts, [&space, eps](const Vector3 point) -> bool
+				{ return space.Distance(point) > eps; });
+		})};
+	if (!cuts)
+		return;
+
+	vector<Polygon> kept;
+	kept.reserve(this->faces.size() + 1);
+	vector<Vector3> section;
+	for (const auto& face : this->faces)
+	{
+		Polygon clipped{.verts = {}, .plane = face.plane};
+		const uint64_t count{face.verts.size()};
+		for (uint64_t i{0}; i < count; i++)
+		{
+			const Vector3 a{face.verts[i]};
+			const Vector3 b{face.verts[(i + 1) % count]};
+			const float distA{space.Distance(a)};
+			const float distB{space.Distance(b)};
+			if (distA <= eps)
+			{
+				clipped.verts.push_back(a);
+			}
+			if (std::fabs(distA) <= eps)
+			{
+				section.push_back(a);
+			}
+			if ((distA < -eps && distB > eps) || (distA > eps && distB < -eps))
+			{
+				const Vector3 cross{a + ((b - a) * (distA / (distA - distB)))};
+				clipped.verts.push_back(cross);
+				section.push_back(cross);
+			}
+		}
+		if (clipped.verts.size() >= 3)
+		{
+			kept.push_back(std::move(clipped));
+		}
+	}
+
+	// Weld the section points and sort them around the plane normal
+	vector<Vector3> cap;
+	for (const auto point : section)
+	{
+		const bool duplicate{std::ranges::any_of(
+			cap, [point, eps](const Vector3 other) -> bool
+			{ return Vector3Distance(point, other) <= eps; })};
+		if (!duplicate)
+		{
+			cap.push_back(point);
+		}
+	}
+	if (cap.size() >= 3)
+	{
+		Vector3 centre{};
+		for (const auto point : cap)
+		{
+			centre = centre + point;
+		}
+		centre = centre / static_cast<float>(cap.size());
+
+		const Vector3 ref{std::fabs(space.normal.x) < 0.9f
+							  ? Vector3{1.0f, 0.0f, 0.0f}
+							  : Vector3{0.0f, 1.0f, 0.0f}};
+		const Vector3 u{
+			Vector3Normalize(Vector3CrossProduct(space.normal, ref))};
+		const Vector3 v{Vector3CrossProduct(space.normal, u)};
+		const auto angle = [centre, u, v](const Vector3 point) -> float
+		{
+			const Vector3 offset{point - centre};
+			return std::atan2(Vector3DotProduct(offset, v),
+							  Vector3DotProduct(offset, u));
+		};
+		std::ranges::sort(cap, {}, angle);
+		kept.push_back({.verts = std::move(cap), .plane = plane});
+	}
+	this->faces = std::move(kept);
+}
+
+auto Polytope::Volume() const -> float
+{
+	float volume{0.0f};
+	for (const auto& face : this->faces)
+	{
+		for (uint64_t i{1}; i + 1 < face.verts.size(); i++)
+		{
+			volume += Vector3DotProduct(
+				face.verts[0],
+				Vector3CrossProduct(face.verts[i], face.verts[i + 1]));
+		}
+	}
+	return volume / 6.0f;
+}
+
+void Polytope::GetVertices(vector<Vector3>& out, const float eps) const
+{
+	for (const auto& face : this->faces)
+	{
+		for (const auto point : face.verts)
+		{
+			const bool duplicate{std::ranges::any_of(
+				out, [point, eps](const Vector3 other) -> bool
+				{ return Vector3Distance(point, other) <= eps; })};
+			if (!duplicate)
+			{
+				out.push_back(point);
+			}
+		}
+	}
+}
+
+/** @brief The region a face's removal would add to the hull. */
+struct Cap
+{
+	float volume{0.0f};
+	/** @brief Furthest distance of the cap from the removed face's plane. */
+	float height{0.0f};
+	bool bounded{false};
+	/** @brief Planes the cap touches, whose own caps grow if it is removed. */
+	vector<uint32_t> neighbours;
+	/** @brief Corners of the cap that do not lie on the removed face. */
+	vector<Vector3> corners;
+};
+
+/**
+ * @brief Greedily removes hull faces. The vertices of the growing hull are
+ *        tracked directly, as removing a face only replaces the vertices on
+ *        it with the corners of its cap.
+ */
+class Simplifier
+{
+	public:
+	Simplifier(const HullCollider& hull, const float eps);
+
+	auto Run(const SimplifySettings& settings) -> bool;
+	auto GetVertices() const -> const vector<Vector3>& { return this->verts; }
+
+	private:
+	void UpdateCap(const uint32_t face);
+	void RemoveFace(const uint32_t face);
+	auto IsCorner(const Vector3 point) const -> bool;
+
+	vector<HalfSpace> planes;
+	vector<Cap> caps;
+	vector<bool> alive;
+	vector<Vector3> verts;
+	Vector3 centre{};
+	float halfSize{0.0f};
+	float eps;
+};
+
+Simplifier::Simplifier(const HullCollider& hull, const float eps) : eps(eps)
+{
+	const BoundingBox bounds{hull.GetBounds()};
+	this->centre = (bounds.min + bounds.max) * 0.5f;
+	const Vector3 extents{bounds.max - bounds.min};
+	this->halfSize
+		= BOX_SCALE * std::max({extents.x, extents.y, extents.z, eps});
+
+	const auto faceCount{static_cast<uint32_t>(hull.FaceCount())};
+	this->planes.reserve(faceCount);
+	this->caps.resize(faceCount);
+	for (uint32_t i{0}; i < faceCount; i++)
+	{
+		// Take the furthest vertex so that every vertex stays inside
+		const HE::HFace& face{hull.GetFace(i)};
+		float offset{-std::numeric_limits<float>::max()};
+		for (const auto& edge : face)
+		{
+			const Vector3 point{edge.Vertex()->Vec()};
+			offset = std::max(offset, Vector3DotProduct(face.normal, point));
+			const bool duplicate{std::ranges::any_of(
+				this->verts, [point, eps](const Vector3 other) -> bool
+				{ return Vector3Distance(point, other) <= eps; })};
+			if (!duplicate)
+			{
+				this->verts.push_back(point);
+			}
+			// Adjacent faces are the likeliest to bound the cap, so clip by
+			// them first
+			this->caps[i].neighbours.push_back(edge.Twin()->faceID);
+		}
+		this->planes.push_back({.normal = face.normal, .offset = offset});
+	}
+	this->alive.assign(faceCount, true);
+	for (uint32_t i{0}; i < faceCount; i++)
+	{
+		this->UpdateCap(i);
+	}
+}
+
+/**
+ * @brief Measures the region between a face and the remaining planes, which
+ *        is what removing that face would add to the hull.
+ */
+void Simplifier::UpdateCap(const uint32_t face)
+{
+	const HalfSpace& own{this->planes[face]};
+	Cap& cap{this->caps[face]};
+	Polytope poly{this->centre, this->halfSize};
+	poly.Clip({.normal = Vector3Negate(own.normal), .offset = -own.offset},
+			  face, this->eps);
+	// Clipping by the previous neighbours first keeps the polytope small for
+	// the remaining planes, most of which then cut nothing
+	for (const uint32_t i : cap.neighbours)
+	{
+		if (this->alive[i])
+		{
+			poly.Clip(this->planes[i], i, this->eps);
+		}
+	}
+	for (uint32_t i{0}; i < this->planes.size(); i++)
+	{
+		if (i != face && this->alive[i])
+		{
+			poly.Clip(this->planes[i], i, this->eps);
+		}
+	}
+
+	cap.volume = std::max(poly.Volume(), 0.0f);
+	cap.height = 0.0f;
+	cap.bounded = true;
+	cap.neighbours.clear();
+	cap.corners.clear();
+	for (const auto& side : poly.Faces())
+	{
+		if (side.plane == BOX_PLANE)
+		{
+			cap.bounded = false;
+		}
+		else if (side.plane != face)
+		{
+			cap.neighbours.push_back(side.plane);
+		}
+	}
+	vector<Vector3> corners;
+	poly.GetVertices(corners, this->eps);
+	for (const auto point : corners)
+	{
+		const float height{own.Distance(point)};
+		cap.height = std::max(cap.height, height);
+		if (height > this->eps)
+		{
+			cap.corners.push_back(point);
+		}
+	}
+}
+
+/** @returns true if point lies on three independent remaining planes. */
+auto Simplifier::IsCorner(const Vector3 point) const -> bool
+{
+	vector<Vector3> normals;
+	for (uint32_t i{0}; i < this->planes.size(); i++)
+	{
+		if (this->alive[i]
+			&& std::fabs(this->planes[i].Distance(point)) <= this->eps)
+		{
+			normals.push_back(this->planes[i].normal);
+		}
+	}
+	for (uint64_t i{0}; i < normals.size(); i++)
+	{
+		for (uint64_t j{i + 1}; j < normals.size(); j++)
+		{
+			const Vector3 edge{Vector3CrossProduct(normals[i], normals[j])};
+			for (uint64_t k{j + 1}; k < normals.size(); k++)
+			{
+				if (std::fabs(Vector3DotProduct(edge, normals[k])) > 1e-4f)
+					return true;
+			}
+		}
+	}
+	return false;
+}
+
+void Simplifier::RemoveFace(const uint32_t face)
+{
+	this->alive[face] = false;
+
+	// Vertices on the removed face survive only where other planes still meet
+	const HalfSpace& own{this->planes[face]};
+	std::erase_if(this->verts,
+				  [this, &own](const Vector3 point) -> bool
+				  {
+					  return std::fabs(own.Distance(point)) <= this->eps
+							 && !this->IsCorner(point);
+				  });
+	const vector<Vector3> corners{this->caps[face].corners};
+	this->verts.insert(this->verts.end(), corners.begin(), corners.end());
+
+	for (uint32_t i{0}; i < this->planes.size(); i++)
+	{
+		if (this->alive[i]
+			&& std::ranges::find(this->caps[i].neighbours, face)
+				   != this->caps[i].neighbours.end())
+		{
+			this->UpdateCap(i);
+		}
+	}
+}
+
+/** @returns false if no face could be removed. */
+auto Simplifier::Run(const SimplifySettings& settings) -> bool
+{
+	auto faceCount{static_cast<uint32_t>(this->planes.size())};
+	bool changed{false};
+	while ((settings.maxFaces != 0 && faceCount > settings.maxFaces)
+		   || (settings.maxVertices != 0
+			   && this->verts.size() > settings.maxVertices))
+	{
+		std::optional<uint32_t> best;
+		for (uint32_t i{0}; i < this->planes.size(); i++)
+		{
+			const Cap& cap{this->caps[i]};
+			if (!this->alive[i] || !cap.bounded
+				|| cap.height > settings.maxError)
+				continue;
+			if (!best.has_value() || cap.volume < this->caps[*best].volume)
+			{
+				best = i;
+			}
+		}
+		if (!best.has_value())
+			break;
+
+		this->RemoveFace(*best);
+		faceCount--;
+		changed = true;
+	}
+	return changed;
+}
+
+} //namespace
+
+auto SimplifyHull(const HullCollider& hull, const SimplifySettings& settings)
+	-> Collider
+{
+	const BoundingBox bounds{hull.GetBounds()};
+	const float size{Vector3Distance(bounds.min, bounds.max)};
+	const float eps{std::max(size * 1e-5f, 1e-6f)};
+
+	Simplifier simplifier{hull, eps};
+	if (!simplifier.Run(settings))
+		return {hull};
+
+	vector<HE::HVertex> verts;
+	vector<HE::FaceInit> faces;
+	HullSettings hullSettings{};
+	hullSettings.weldDistance = eps;
+	if (!ComputeConvexHull(simplifier.GetVertices(), verts, faces,
+						   hullSettings))
+		return {hull};
+
+	HullCollider newCol{verts, faces, hull.GetOrigin()};
+	return {newCol};
+}
+
+auto SimplifyCollider(const Collider& col, const SimplifySettings& settings)
+	-> Collider
+{
+	if (const auto* hull = std::get_if<HullCollider>(&col))
+		return SimplifyHull(*hull, settings);
+	// Primitives are already as cheap as they get
+	const auto* compound = std::get_if<CompoundCollider>(&col);
+	if (compound == nullptr)
+		return col;
+
+	vector<Collider> children;
+	for (const auto& child : compound->GetColliders())
+	{
+		children.push_back(SimplifyCollider(child, settings));
+	}
+	return CompoundCollider(children);
+}
+
+} //namespace phys
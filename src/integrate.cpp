@@ -0,0 +1,299 @@
+#include "integrate.h"
+#include "lanes.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <raylib.h>
+#include <raymath.h>
+#include <utility>
+#include <vector>
+
+namespace phys
+{
+
+namespace
+{
+
+/**
+ * @brief Integrates bodies from first onwards, L::WIDTH at a time, while a
+ *        whole group still fits before last.
+ * @returns The index of the first body that was not processed.
+ */
+template <typename L>
+auto IntegrateLanes(BodyState& state, const IntegrateParams& params,
+					const uint32_t first, const uint32_t last) -> uint32_t
+{
+	using F = typename L::Float;
+	const F deltaTime{L::Splat(params.deltaTime)};
+	const F halfDelta{L::Splat(params.deltaTime * 0.5f)};
+	const F gravityX{L::Splat(params.gravity.x * params.deltaTime)};
+	const F gravityY{L::Splat(params.gravity.y * params.deltaTime)};
+	const F gravityZ{L::Splat(params.gravity.z * params.deltaTime)};
+	const F linearDamping{L::Splat(params.linearDamping)};
+	const F angularDamping{L::Splat(params.angularDamping)};
+	const F one{L::Splat(1.0f)};
+	const F two{L::Splat(2.0f)};
+
+	uint32_t i{first};
+	for (; i + L::WIDTH <= last; i += L::WIDTH)
+	{
+		const auto load = [i](const vector<float>& arr) -> F
+		{ return L::Load(&arr[i]); };
+		const auto store = [i](vector<float>& arr, const F val) -> void
+		{ L::Store(&arr[i], val); };
+		const auto dynamic{L::IsPositive(load(state.inverseMasses))};
+
+		// Velocities, then positions with the new velocities
+		auto& vel = state.velocities;
+		auto& angVel = state.angularVelocities;
+		auto& pos = state.positions;
+		const F oldVelX{load(vel.x)};
+		const F oldVelY{load(vel.y)};
+		const F oldVelZ{load(vel.z)};
+		const F velX{L::Select(dynamic, (oldVelX + gravityX) * linearDamping,
+							   oldVelX)};
+		const F velY{L::Select(dynamic, (oldVelY + gravityY) * linearDamping,
+							   oldVelY)};
+		const F velZ{L::Select(dynamic, (oldVelZ + gravityZ) * linearDamping,
+							   oldVelZ)};
+		const F posX{load(pos.x) + (velX * deltaTime)};
+		const F posY{load(pos.y) + (velY * deltaTime)};
+		const F posZ{load(pos.z) + (velZ * deltaTime)};
+		const F oldAngX{load(angVel.x)};
+		const F angX{L::Select(dynamic, oldAngX * angularDamping, oldAngX)};
+		const F oldAngY{load(angVel.y)};
+		const F angY{L::Select(dynamic, oldAngY * angularDamping, oldAngY)};
+		const F oldAngZ{load(angVel.z)};
+		const F angZ{L::Select(dynamic, oldAngZ * angularDamping, oldAngZ)};
+		store(vel.x, velX);
+		store(vel.y, velY);
+		store(vel.z, velZ);
+		store(pos.x, posX);
+		store(pos.y, posY);
+		store(pos.z, posZ);
+		store(angVel.x, angX);
+		store(angVel.y, angY);
+		store(angVel.z, angZ);
+
+		// q += dt / 2 * (angVel, 0) * q, then renormalise
+		auto& rot = state.rotations;
+		const F oldX{load(rot.x)};
+		const F oldY{load(rot.y)};
+		const F oldZ{load(rot.z)};
+		const F oldW{load(rot.w)};
+		const F spinX{oldX
+					  + (halfDelta
+						 * ((angX * oldW) + (angY * oldZ) - (angZ * oldY)))};
+		const F spinY{oldY
+					  + (halfDelta
+						 * ((angY * oldW) + (angZ * oldX) - (angX * oldZ)))};
+		const F spinZ{oldZ
+					  + (halfDelta
+						 * ((angZ * oldW) + (angX * oldY) - (angY * oldX)))};
+		const F spinW{oldW
+					  - (halfDelta
+						 * ((angX * oldX) + (angY * oldY) + (angZ * oldZ)))};
+		const F length{L::Sqrt((spinX * spinX) + (spinY * spinY)
+							   + (spinZ * spinZ) + (spinW * spinW))};
+		const F rotX{spinX / length};
+		const F rotY{spinY / length};
+		const F rotZ{spinZ / length};
+		const F rotW{spinW / length};
+		store(rot.x, rotX);
+		store(rot.y, rotY);
+		store(rot.z, rotZ);
+		store(rot.w, rotW);
+
+		// Rows of the scaled rotation, matching QuaternionToMatrix
+		const F scaleX{load(state.scales.x)};
+		const F scaleY{load(state.scales.y)};
+		const F scaleZ{load(state.scales.z)};
+		const F xx{rotX * rotX};
+		const F yy{rotY * rotY};
+		const F zz{rotZ * rotZ};
+		const F xy{rotX * rotY};
+		const F xz{rotX * rotZ};
+		const F yz{rotY * rotZ};
+		const F wx{rotW * rotX};
+		const F wy{rotW * rotY};
+		const F wz{rotW * rotZ};
+		const F m00{(one - (two * (yy + zz))) * scaleX};
+		const F m01{(two * (xy - wz)) * scaleY};
+		const F m02{(two * (xz + wy)) * scaleZ};
+		const F m10{(two * (xy + wz)) * scaleX};
+		const F m11{(one - (two * (xx + zz))) * scaleY};
+		const F m12{(two * (yz - wx)) * scaleZ};
+		const F m20{(two * (xz - wy)) * scaleX};
+		const F m21{(two * (yz + wx)) * scaleY};
+		const F m22{(one - (two * (xx + yy))) * scaleZ};
+
+		// World bounds of the body space box around the collider
+		const F centreX{load(state.localCentres.x)};
+		const F centreY{load(state.localCentres.y)};
+		const F centreZ{load(state.localCentres.z)};
+		const F extentX{load(state.localExtents.x)};
+		const F extentY{load(state.localExtents.y)};
+		const F extentZ{load(state.localExtents.z)};
+		const F worldX{(m00 * centreX) + (m01 * centreY) + (m02 * centreZ)
+					   + posX};
+		const F worldY{(m10 * centreX) + (m11 * centreY) + (m12 * centreZ)
+					   + posY};
+		const F worldZ{(m20 * centreX) + (m21 * centreY) + (m22 * centreZ)
+					   + posZ};
+		const F reachX{(L::Abs(m00) * extentX) + (L::Abs(m01) * extentY)
+					   + (L::Abs(m02) * extentZ)};
+		const F reachY{(L::Abs(m10) * extentX) + (L::Abs(m11) * extentY)
+					   + (L::Abs(m12) * extentZ)};
+		const F reachZ{(L::Abs(m20) * extentX) + (L::Abs(m21) * extentY)
+					   + (L::Abs(m22) * extentZ)};
+		store(state.boundsMin.x, worldX - reachX);
+		store(state.boundsMin.y, worldY - reachY);
+		store(state.boundsMin.z, worldZ - reachZ);
+		store(state.boundsMax.x, worldX + reachX);
+		store(state.boundsMax.y, worldY + reachY);
+		store(state.boundsMax.z, worldZ + reachZ);
+
+		for (uint32_t lane{0}; lane < L::WIDTH; lane++)
+		{
+			state.matrixFlags[i + lane] = WORLD_DIRTY | INVERSE_DIRTY;
+		}
+	}
+	return i;
+}
+
+} //namespace
+
+void BodyState::Swap(const uint32_t i, const uint32_t j)
+{
+	this->positions.Swap(i, j);
+	this->rotations.Swap(i, j);
+	this->scales.Swap(i, j);
+	this->velocities.Swap(i, j);
+	this->angularVelocities.Swap(i, j);
+	std::swap(this->inverseMasses[i], this->inverseMasses[j]);
+	this->localCentres.Swap(i, j);
+	this->localExtents.Swap(i, j);
+	this->boundsMin.Swap(i, j);
+	this->boundsMax.Swap(i, j);
+	std::swap(this->matrixFlags[i], this->matrixFlags[j]);
+}
+void BodyState::SwapRemove(const uint32_t i)
+{
+	this->positions.SwapRemove(i);
+	this->rotations.SwapRemove(i);
+	this->scales.SwapRemove(i);
+	this->velocities.SwapRemove(i);
+	this->angularVelocities.SwapRemove(i);
+	this->inverseMasses[i] = this->inverseMasses.back();
+	this->inverseMasses.pop_back();
+	this->localCentres.SwapRemove(i);
+	this->localExtents.SwapRemove(i);
+	this->boundsMin.SwapRemove(i);
+	this->boundsMax.SwapRemove(i);
+	this->matrixFlags[i] = this->matrixFlags.back();
+	this->matrixFlags.pop_back();
+}
+void BodyState::Reserve(const uint32_t count)
+{
+	this->positions.Reserve(count);
+	this->rotations.Reserve(count);
+	this->scales.Reserve(count);
+	this->velocities.Reserve(count);
+	this->angularVelocities.Reserve(count);
+	this->inverseMasses.reserve(count);
+	this->localCentres.Reserve(count);
+	this->localExtents.Reserve(count);
+	this->boundsMin.Reserve(count);
+	this->boundsMax.Reserve(count);
+	this->matrixFlags.reserve(count);
+}
+
+auto GetBestKernel() -> IntegrateKernel
+{
+#ifdef PHYS_HAS_SSE2
+#if defined(__GNUC__) || defined(__clang__)
+	if (!__builtin_cpu_supports("sse2"))
+		return IntegrateKernel::SCALAR;
+#endif // defined(__GNUC__) || defined(__clang__)
+	return IntegrateKernel::SSE2;
+#else
+	return IntegrateKernel::SCALAR;
+#endif // PHYS_HAS_SSE2
+}
+
+void IntegrateBodies(const IntegrateKernel kernel, BodyState& state,
+					 const IntegrateParams& params, const uint32_t count)
+{
+	uint32_t done{0};
+#ifdef PHYS_HAS_SSE2
+	if (kernel == IntegrateKernel::SSE2)
+	{
+		done = IntegrateLanes<SSE2Lanes>(state, params, 0, count);
+	}
+#else
+	(void)kernel;
+#endif // PHYS_HAS_SSE2
+	IntegrateLanes<ScalarLanes>(state, params, done, count);
+}
+
+auto CheckIntegrateKernels() -> bool
+{
+	// Enough bodies to leave some for the scalar tail of every kernel
+	constexpr uint32_t BODY_COUNT{1027};
+	std::mt19937 rng{0};
+	std::uniform_real_distribution<float> dist{-1.0f, 1.0f};
+	const auto random = [&rng, &dist]() -> Vector3
+	{ return {dist(rng), dist(rng), dist(rng)}; };
+
+	BodyState state;
+	for (uint32_t i{0}; i < BODY_COUNT; i++)
+	{
+		const Vector3 axis{random()};
+		const float angle{dist(rng)};
+		const float sine{std::sin(angle)};
+		state.positions.PushBack(random() * 10.0f);
+		state.rotations.PushBack({axis.x * sine, axis.y * sine, axis.z * sine,
+								  std::cos(angle)});
+		state.scales.PushBack(random() + Vector3{2.0f, 2.0f, 2.0f});
+		state.velocities.PushBack(random());
+		state.angularVelocities.PushBack(random() * 3.0f);
+		state.inverseMasses.push_back(i % 3 == 0 ? 0.0f : 1.0f);
+		state.localCentres.PushBack(random());
+		state.localExtents.PushBack(random() + Vector3{1.0f, 1.0f, 1.0f});
+		state.boundsMin.PushBack({});
+		state.boundsMax.PushBack({});
+		state.matrixFlags.push_back(0);
+	}
+	const IntegrateParams params{.deltaTime = 1.0f / 60.0f,
+								 .gravity = {0.0f, -9.8f, 0.0f},
+								 .linearDamping = 0.99f,
+								 .angularDamping = 0.95f};
+	BodyState expected{state};
+	IntegrateBodies(IntegrateKernel::SCALAR, expected, params, BODY_COUNT);
+	IntegrateBodies(GetBestKernel(), state, params, BODY_COUNT);
+
+	const auto matches = [](const vector<float>& a, const vector<float>& b)
+		-> bool
+	{
+		const auto close = [](const float x, const float y) -> bool
+		{ return std::fabs(x - y) <= 1e-5f * std::max(1.0f, std::fabs(x)); };
+		return std::ranges::equal(a, b, close);
+	};
+	const auto matches3 = [&matches](const Vector3Array& a,
+									 const Vector3Array& b) -> bool
+	{ return matches(a.x, b.x) && matches(a.y, b.y) && matches(a.z, b.z); };
+	return matches3(expected.positions, state.positions)
+		   && matches3(expected.velocities, state.velocities)
+		   && matches3(expected.angularVelocities, state.angularVelocities)
+		   && matches(expected.rotations.x, state.rotations.x)
+		   && matches(expected.rotations.y, state.rotations.y)
+		   && matches(expected.rotations.z, state.rotations.z)
+		   && matches(expected.rotations.w, state.rotations.w)
+		   && matches3(expected.boundsMin, state.boundsMin)
+		   && matches3(expected.boundsMax, state.boundsMax)
+		   && expected.matrixFlags == state.matrixFlags;
+}
+
+} //namespace phys
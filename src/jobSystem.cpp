@@ -0,0 +1,173 @@
+#include "jobSystem.h"
+#include "frameArena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <thread>
+
+namespace phys
+{
+
+namespace
+{
+
+auto PackRange(const uint32_t begin, const uint32_t end) -> uint64_t
+{
+	return (static_cast<uint64_t>(end) << 32U) | begin;
+}
+auto RangeBegin(const uint64_t range) -> uint32_t
+{
+	return static_cast<uint32_t>(range);
+}
+auto RangeEnd(const uint64_t range) -> uint32_t
+{
+	return static_cast<uint32_t>(range >> 32U);
+}
+/** @returns How many threads a JobSystem asked for threads should use. */
+auto ResolveThreadCount([[maybe_unused]] const uint32_t threads) -> uint32_t
+{
+#if defined(PLATFORM_WEB)
+	// Web builds have no pthreads, so every batch runs on the calling thread
+	return 1;
+#else
+	return threads != 0 ? threads
+						: std::max(std::thread::hardware_concurrency(), 1U);
+#endif // defined(PLATFORM_WEB)
+}
+
+} //namespace
+
+JobSystem::JobSystem(const uint32_t threads)
+	: queues(ResolveThreadCount(threads))
+{
+	this->workers.reserve(this->queues.size() - 1);
+	for (uint32_t i{1}; i < this->queues.size(); i++)
+	{
+		this->workers.emplace_back(
+			[this, i](const std::stop_token& stop) -> void
+			{
+				this->WorkerLoop(stop, i);
+			});
+	}
+}
+
+void JobSystem::Run(const std::span<const uint32_t> jobs,
+					const std::function<void(uint32_t)>& func)
+{
+	const auto count{static_cast<uint32_t>(jobs.size())};
+	if (count <= 1 || this->workers.empty())
+	{
+		std::ranges::for_each(jobs, func);
+		return;
+	}
+	// Worker w gets jobs w, w + n, w + 2n and so on
+	const uint32_t threads{this->GetThreadCount()};
+	this->dealt.resize(count);
+	uint32_t end{0};
+	for (uint32_t w{0}; w < threads; w++)
+	{
+		const uint32_t begin{end};
+		for (uint32_t i{w}; i < count; i += threads)
+		{
+			this->dealt[end++] = jobs[i];
+		}
+		this->queues[w].range.store(PackRange(begin, end),
+									std::memory_order_relaxed);
+	}
+	this->func = &func;
+	{
+		const std::lock_guard lock{this->mutex};
+		this->busyWorkers = threads - 1;
+		this->generation++;
+	}
+	this->wake.notify_all();
+	this->Work(0);
+
+	std::unique_lock lock{this->mutex};
+	this->done.wait(lock, [this]() -> bool { return this->busyWorkers == 0; });
+	this->func = nullptr;
+}
+void JobSystem::ParallelFor(const uint32_t count,
+							const std::function<void(uint32_t)>& func)
+{
+	this->sequence.resize(count);
+	std::iota(this->sequence.begin(), this->sequence.end(), 0U);
+	this->Run(this->sequence, func);
+}
+
+void JobSystem::WorkerLoop(const std::stop_token& stop, const uint32_t worker)
+{
+	uint64_t seen{0};
+	while (true)
+	{
+		{
+			std::unique_lock lock{this->mutex};
+			if (!this->wake.wait(lock, stop,
+								 [this, &seen]() -> bool
+								 {
+									 return this->generation != seen;
+								 }))
+				return;
+			seen = this->generation;
+		}
+		this->Work(worker);
+		// Nothing a job allocated is used once the batch is over
+		GetFrameArena().Reset();
+		{
+			const std::lock_guard lock{this->mutex};
+			this->busyWorkers--;
+		}
+		this->done.notify_one();
+	}
+}
+void JobSystem::Work(const uint32_t worker)
+{
+	const auto threads{this->GetThreadCount()};
+	while (true)
+	{
+		std::optional<uint32_t> job{this->PopFront(this->queues[worker])};
+		for (uint32_t i{1}; i < threads && !job.has_value(); i++)
+		{
+			job = this->PopBack(this->queues[(worker + i) % threads]);
+		}
+		// Batches never grow, so once every queue is empty the work is done
+		if (!job.has_value())
+			return;
+		(*this->func)(this->dealt[*job]);
+	}
+}
+auto JobSystem::PopFront(Queue& queue) -> std::optional<uint32_t>
+{
+	uint64_t range{queue.range.load(std::memory_order_relaxed)};
+	while (RangeBegin(range) < RangeEnd(range))
+	{
+		const uint32_t begin{RangeBegin(range)};
+		if (queue.range.compare_exchange_weak(
+				range, PackRange(begin + 1, RangeEnd(range)),
+				std::memory_order_relaxed))
+			return begin;
+	}
+	return std::nullopt;
+}
+auto JobSystem::PopBack(Queue& queue) -> std::optional<uint32_t>
+{
+	uint64_t range{queue.range.load(std::memory_order_relaxed)};
+	while (RangeBegin(range) < RangeEnd(range))
+	{
+		const uint32_t end{RangeEnd(range) - 1};
+		if (queue.range.compare_exchange_weak(
+				range, PackRange(RangeBegin(range), end),
+				std::memory_order_relaxed))
+			return end;
+	}
+	return std::nullopt;
+}
+
+} //namespace phys
@@ -0,0 +1,120 @@
+// NOTE: This file must not include raylib, its names collide with windows.h
+#include "mappedFile.h"
+
+#include <cstddef>
+#include <utility>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // _WIN32
+
+namespace phys
+{
+
+#ifdef _WIN32
+MappedFile::MappedFile(const char* path)
+{
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+							  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return;
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0)
+	{
+		CloseHandle(file);
+		return;
+	}
+	HANDLE mapping =
+		CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		CloseHandle(file);
+		return;
+	}
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == nullptr)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return;
+	}
+	this->file = file;
+	this->mapping = mapping;
+	this->data = static_cast<const std::byte*>(view);
+	this->size = static_cast<std::size_t>(fileSize.QuadPart);
+}
+void MappedFile::Close()
+{
+	if (this->data != nullptr)
+		UnmapViewOfFile(this->data);
+	if (this->mapping != nullptr)
+		CloseHandle(this->mapping);
+	if (this->file != nullptr)
+		CloseHandle(this->file);
+	this->data = nullptr;
+	this->size = 0;
+	this->mapping = nullptr;
+	this->file = nullptr;
+}
+#else
+MappedFile::MappedFile(const char* path)
+{
+	const int file = open(path, O_RDONLY);
+	if (file < 0)
+		return;
+	struct stat info{};
+	if (fstat(file, &info) != 0 || info.st_size <= 0)
+	{
+		close(file);
+		return;
+	}
+	const auto fileSize = static_cast<std::size_t>(info.st_size);
+	void* view = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, file, 0);
+	// The mapping keeps its own reference to the file
+	close(file);
+	if (view == MAP_FAILED)
+		return;
+	this->data = static_cast<const std::byte*>(view);
+	this->size = fileSize;
+}
+void MappedFile::Close()
+{
+	if (this->data != nullptr)
+		munmap(const_cast<std::byte*>(this->data), this->size);
+	this->data = nullptr;
+	this->size = 0;
+}
+#endif // _WIN32
+
+MappedFile::MappedFile(MappedFile&& other) noexcept :
+	data(std::exchange(other.data, nullptr)),
+	size(std::exchange(other.size, 0))
+#ifdef _WIN32
+	,
+	file(std::exchange(other.file, nullptr)),
+	mapping(std::exchange(other.mapping, nullptr))
+#endif // _WIN32
+{ }
+MappedFile::~MappedFile() { this->Close(); }
+auto MappedFile::operator=(MappedFile&& other) noexcept -> MappedFile&
+{
+	if (this != &other)
+	{
+		this->Close();
+		this->data = std::exchange(other.data, nullptr);
+		this->size = std::exchange(other.size, 0);
+#ifdef _WIN32
+		this->file = std::exchange(other.file, nullptr);
+		this->mapping = std::exchange(other.mapping, nullptr);
+#endif // _WIN32
+	}
+	return *this;
+}
+
+} //namespace phys
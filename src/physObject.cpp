@@ -1,19 +1,31 @@
 #include "physObject.h"
 #include "collider.h"
+#include "collisionDispatch.h"
+#include "debugDraw.h"
+#include "eventLog.h"
+#include "frameArena.h"
 #include "halfEdge.h"
+#include "hullRegistry.h"
+#include "hullSimplify.h"
+#include "primitiveTests.h"
+#include "renderCache.h"
 #include "utils.h"
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cmath>
 #include <cstdint>
 #include <iostream>
+#include <iterator>
 #include <limits>
+#include <memory_resource>
 #include <optional>
 #include <ranges>
 #include <raylib.h>
 #include <raymath.h>
 #include <rlgl.h>
+#include <span>
 #include <variant>
 
 namespace phys
@@ -29,108 +41,180 @@ namespace rv = std::views;
  */
 auto IsPointInPoly3D(const Vector3 point, const HE::HFace& poly) -> bool;
 
+/** @returns The contact points, allocated from the frame arena. */
 auto GenFaceContact(const HE::HFace& ref, const HE::HFace& incident)
-	-> vector<Vector3>;
+	-> std::pmr::vector<Vector3>;
 
 auto CheckCollision(const PhysObject& obj1, const PhysObject& obj2)
 	-> optional<HitObj>
 {
-	vector<Collider> cols1;
-	obj1.GetColliderT(MatrixIdentity(), cols1);
-	vector<Collider> cols2;
-	obj2.GetColliderT(obj2.GetTransformM() * MatrixInvert(obj1.GetTransformM()),
-					  cols2);
+	const Matrix trans{obj2.GetTransformM() * obj1.GetInverseTransformM()};
+	FrameArena& arena{GetFrameArena()};
+	// Midphase, only leaves whose bounds overlap reach the narrow phase
+	std::pmr::vector<std::pair<uint32_t, uint32_t>> pairs{&arena};
+	GetLeafOverlaps(obj1.ActiveCollider(), obj2.ActiveCollider(), trans,
+					obj1.GetTransformM() * obj2.GetInverseTransformM(), pairs);
+	const auto leaves1{GetLeaves(obj1.ActiveCollider())};
+	const auto leaves2{GetLeaves(obj2.ActiveCollider())};
+	// Leaves of object 2 in the local space of object 1, moved on first use
+	std::pmr::vector<std::pmr::vector<Collider>> cols2(leaves2.size(),
+													  &arena);
+	// Sensors only need to know whether anything overlaps at all
+	const bool sensor{obj1.IsSensor() || obj2.IsSensor()};
 	bool collision = false;
-	for (const auto& col1 : cols1)
+	// Deepest contact between any two leaves, in the local space of object 1
+	ContactHit deepest{};
+	std::array<Vector3, HitObj::MAX_POINTS> points{};
+	uint32_t pointCount{0};
+	for (const auto& [id1, id2] : pairs)
 	{
-		for (const auto& col2 : cols2)
+		if (cols2[id2].empty())
 		{
-			auto faces1 = CheckFaceNors(col1, col2);
-			if (faces1.penetration <= 0)
-				continue;
-			auto faces2 = CheckFaceNors(col2, col1);
-			if (faces2.penetration <= 0)
+			std::visit([trans, &cols2, id2](const isCollider auto& col) -> void
+					   { col.GetTransformed(trans, cols2[id2]); },
+					   leaves2[id2]);
+		}
+		for (const auto& col2 : cols2[id2])
+		{
+			if (sensor)
+			{
+				if (CheckPairOverlap(leaves1[id1], col2))
+				{
+					return HitObj{
+						.ThisCol = obj1, .OtherCol = obj2, .IsSensor = true};
+				}
 				continue;
-			auto edges = CheckEdgeNors(col1, col2);
-			if (edges.penetration <= 0)
+			}
+			const auto hit{CheckPairCollision(leaves1[id1], col2)};
+			if (!hit.has_value())
 				continue;
-
-			bool isEdgeCol{
-				(edges.penetration < faces1.penetration)
-					&& (edges.penetration < faces2.penetration),
-			};
-			if (isEdgeCol)
+			DebugPoint(DEBUG_CONTACTS, hit->point, 0.05f, BLUE);
+			DebugLine(DEBUG_NORMALS, hit->point,
+					  hit->point + (hit->normal * hit->penetration), RED);
+			if (!collision || hit->penetration > deepest.penetration)
 			{
-				// TODO: Get rid of this and rework hit object
-				std::cout << "Edge Collision\n";
-				auto [closest1, closest2] = GetClosestPoints(edges);
-				auto hitPos
-					= closest1 + (edges.normal * (edges.penetration / 2.0f));
-#ifndef NDEBUG
-				DrawSphere(edges.support1, 0.01f, BLUE);
-				DrawSphere(edges.twin1, 0.01f, BLUE);
-				DrawSphere(edges.support2, 0.01f, BLUE);
-				DrawSphere(edges.twin2, 0.01f, BLUE);
-
-				DrawSphere(hitPos, 0.025f, BLUE);
-				DrawSphere(closest1, 0.01f, BLUE);
-				DrawSphere(closest2, 0.01f, BLUE);
-				DrawLine3D(closest1, closest2, BLUE);
-#endif // !NDEBUG
+				deepest = *hit;
 			}
-			else
+			// Face contacts carry their manifold, the rest a single point
+			const std::span<const Vector3> hitPoints{
+				hit->pointCount > 0
+					? std::span<const Vector3>{hit->points.data(),
+											   hit->pointCount}
+					: std::span<const Vector3>{&hit->point, 1}};
+			for (const Vector3 point : hitPoints)
 			{
-				std::cout << "Face Collision\n";
-				CheckFaceCollision(col1, col2, faces1, faces2);
+				if (pointCount == points.size())
+					break;
+				points[pointCount++] = point * obj1.GetTransformM();
 			}
 			collision |= true;
 		}
 	}
-#ifndef NDEBUG
-	//Draw both objects' colliders in the local coordinate space of object 1
-	std::visit([](const isCollider auto& col) -> void
-			   { col.DebugDraw(MatrixIdentity(), {255, 255, 255, 255}); },
-			   obj1.GetCollider());
-	std::visit(
-		[&obj1, &obj2](const isCollider auto& col) -> auto
-		{
-			col.DebugDraw(obj2.GetTransformM()
-							  * MatrixInvert(obj1.GetTransformM()),
-						  {255, 255, 255, 255});
-		},
-		obj2.GetCollider());
-#endif // !NDEBUG
-	if (collision)
+	if (IsDebugDrawEnabled(DEBUG_HULLS | DEBUG_NORMALS))
 	{
-		// NOTE: Debug visualization code
-		std::visit([&obj1](const isCollider auto& col) -> auto
-				   { col.DebugDraw(obj1.GetTransformM(), {255, 0, 0, 255}); },
+		//Draw both objects' colliders in the local coordinate space of
+		//object 1, then in world space, red if they hit and green if not
+		std::visit([](const isCollider auto& col) -> void
+				   { col.DebugDraw(MatrixIdentity(), {255, 255, 255, 255}); },
+				   obj1.GetCollider());
+		std::visit([trans](const isCollider auto& col) -> auto
+				   { col.DebugDraw(trans, {255, 255, 255, 255}); },
+				   obj2.GetCollider());
+		const Color colour{collision ? Color{255, 0, 0, 255}
+									 : Color{0, 255, 0, 255}};
+		std::visit([&obj1, colour](const isCollider auto& col) -> auto
+				   { col.DebugDraw(obj1.GetTransformM(), colour); },
 				   obj1.GetCollider());
-		std::visit([&obj2](const isCollider auto& col) -> auto
-				   { col.DebugDraw(obj2.GetTransformM(), {255, 0, 0, 255}); },
+		std::visit([&obj2, colour](const isCollider auto& col) -> auto
+				   { col.DebugDraw(obj2.GetTransformM(), colour); },
 				   obj2.GetCollider());
-		HitObj hitObj{
-			.HitPos = {0.0f, 0.0f, 0.0f}, .ThisCol = &obj1, .OtherCol = &obj2};
+	}
+	if (collision)
+	{
+		// Normals go to world space by the inverse transpose, which has no
+		// translation of its own, and scaling stretches distances along them
+		// by the inverse of how much that lengthens them
+		const Vector3 normal{
+			deepest.normal * MatrixTranspose(obj1.GetInverseTransformM())};
+		const float stretch{Vector3Length(normal)};
+		HitObj hitObj{.HitPos = deepest.point * obj1.GetTransformM(),
+					  .ThisCol = obj1,
+					  .OtherCol = obj2,
+					  .Normal = normal / stretch,
+					  .Penetration = deepest.penetration / stretch,
+					  .Points = points,
+					  .PointCount = pointCount};
 		return hitObj;
 	}
+	return {};
+}
+auto CheckHullHull(const HullCollider& hullA, const HullCollider& hullB)
+	-> optional<ContactHit>
+{
+	auto faces1 = CheckFaceNors(hullA, hullB);
+	if (faces1.penetration <= 0)
+		return std::nullopt;
+	auto faces2 = CheckFaceNors(hullB, hullA);
+	if (faces2.penetration <= 0)
+		return std::nullopt;
+	auto edges = CheckEdgeNors(hullA, hullB);
+	if (edges.penetration <= 0)
+		return std::nullopt;
+
+	bool isEdgeCol{
+		(edges.penetration < faces1.penetration)
+			&& (edges.penetration < faces2.penetration),
+	};
+	if (isEdgeCol)
+	{
+		Log<LogLevel::TRACE>("Edge collision, penetration", edges.penetration);
+		auto [closest1, closest2] = GetClosestPoints(edges);
+		auto hitPos = closest1 + (edges.normal * (edges.penetration / 2.0f));
+		DebugPoint(DEBUG_CONTACTS, edges.support1, 0.02f, BLUE);
+		DebugPoint(DEBUG_CONTACTS, edges.twin1, 0.02f, BLUE);
+		DebugPoint(DEBUG_CONTACTS, edges.support2, 0.02f, BLUE);
+		DebugPoint(DEBUG_CONTACTS, edges.twin2, 0.02f, BLUE);
+
+		DebugPoint(DEBUG_CONTACTS, hitPos, 0.05f, BLUE);
+		DebugPoint(DEBUG_CONTACTS, closest1, 0.02f, BLUE);
+		DebugPoint(DEBUG_CONTACTS, closest2, 0.02f, BLUE);
+		DebugLine(DEBUG_CONTACTS, closest1, closest2, BLUE);
+		// Edge normals point from B to A
+		return ContactHit{.normal = -edges.normal,
+						  .penetration = edges.penetration,
+						  .point = hitPos};
+	}
+	Log<LogLevel::TRACE>("Face collision, penetration",
+						 std::min(faces1.penetration, faces2.penetration));
+	const auto manifold{CheckFaceCollision(hullA, hullB, faces1, faces2)};
+	ContactHit hit{};
+	if (faces1.penetration < faces2.penetration)
+	{
+		hit = {.normal = hullA.GetFace(faces1.id).normal,
+			   .penetration = faces1.penetration,
+			   .point = faces1.support};
+	}
 	else
 	{
-		// NOTE: Debug visualization code
-		std::visit([&obj1](const isCollider auto& col) -> auto
-				   { col.DebugDraw(obj1.GetTransformM(), {0, 255, 0, 255}); },
-				   obj1.GetCollider());
-		std::visit([&obj2](const isCollider auto& col) -> auto
-				   { col.DebugDraw(obj2.GetTransformM(), {0, 255, 0, 255}); },
-				   obj2.GetCollider());
+		hit = {.normal = -hullB.GetFace(faces2.id).normal,
+			   .penetration = faces2.penetration,
+			   .point = faces2.support};
 	}
-	return {};
+	// The clipped polygon is in winding order, so evenly spaced vertices
+	// keep its extent when it has more than fit
+	const auto count{static_cast<uint32_t>(manifold.size())};
+	hit.pointCount = std::min(count, ContactHit::MAX_POINTS);
+	for (uint32_t i{0}; i < hit.pointCount; i++)
+	{
+		hit.points[i] = manifold[i * count / hit.pointCount];
+	}
+	return hit;
 }
-void CheckFaceCollision(const Collider& colA, const Collider& colB,
+auto CheckFaceCollision(const HullCollider& hull1, const HullCollider& hull2,
 						const FaceHit faces1, const FaceHit faces2)
+	-> std::pmr::vector<Vector3>
 {
 	// Face collision
-	const auto& hull1{std::get<0>(colA)};
-	const auto& hull2{std::get<0>(colB)};
 	if (faces1.penetration < faces2.penetration)
 	{
 		const auto& ref = hull1.GetFace(faces1.id);
@@ -146,11 +230,11 @@ void CheckFaceCollision(const Collider& colA, const Collider& colB,
 				incidentID = i;
 			}
 		}
-		GenFaceContact(ref, hull2.GetFace(incidentID));
-		DrawLine3D(faces1.support,
-				   faces1.support
-					   + (hull1.GetFace(faces1.id).normal * faces1.penetration),
-				   RED);
+		DebugLine(DEBUG_NORMALS, faces1.support,
+				  faces1.support
+					  + (hull1.GetFace(faces1.id).normal * faces1.penetration),
+				  RED);
+		return GenFaceContact(ref, hull2.GetFace(incidentID));
 	}
 	else
 	{
@@ -167,26 +251,31 @@ void CheckFaceCollision(const Collider& colA, const Collider& colB,
 				incidentID = i;
 			}
 		}
-		GenFaceContact(ref, hull1.GetFace(incidentID));
-		DrawLine3D(faces2.support,
-				   faces2.support
-					   + (hull2.GetFace(faces2.id).normal * faces2.penetration),
-				   RED);
+		DebugLine(DEBUG_NORMALS, faces2.support,
+				  faces2.support
+					  + (hull2.GetFace(faces2.id).normal * faces2.penetration),
+				  RED);
+		return GenFaceContact(ref, hull1.GetFace(incidentID));
 	}
-	// return true;
 }
 auto GenFaceContact(const HE::HFace& ref, const HE::HFace& incident)
-	-> vector<Vector3>
+	-> std::pmr::vector<Vector3>
 {
-	vector<HE::HEdge> surface{};
-	vector<HE::HVertex> sVerts{};
+	// Half edges point at plain vectors, so rather than coming from the frame
+	// arena these keep their capacity from call to call
+	thread_local vector<HE::HEdge> surface;
+	thread_local vector<HE::HVertex> sVerts;
+	thread_local vector<HE::HEdge> newSurface;
+	thread_local vector<HE::HVertex> newVerts;
+	surface.clear();
+	sVerts.clear();
 	for (const auto& edge : incident)
 	{
 		sVerts.push_back(*edge.Vertex());
 		HE::HEdge newEdge{
-			.vertID = static_cast<uint8_t>(sVerts.size() - 1),
+			.vertID = static_cast<uint32_t>(sVerts.size() - 1),
 			.twinID = 0,
-			.nextID = static_cast<uint8_t>(surface.size() + 1),
+			.nextID = static_cast<uint32_t>(surface.size() + 1),
 			.faceID = 0,
 			.vertArr = &sVerts,
 			.edgeArr = &surface,
@@ -207,8 +296,8 @@ auto GenFaceContact(const HE::HFace& ref, const HE::HFace& incident)
 				{.pos = edgeRef.Vertex()->Vec(), .nor = planeNor}, point);
 		};
 
-		vector<HE::HEdge> newSurface{0};
-		vector<HE::HVertex> newVerts{0};
+		newSurface.clear();
+		newVerts.clear();
 		for (const auto& sEdge : *surface.data())
 		{
 			Vector3 edgeDir{sEdge.Dir()};
@@ -264,25 +353,27 @@ auto GenFaceContact(const HE::HFace& ref, const HE::HFace& incident)
 		}
 		for ([[maybe_unused]] const auto point : newVerts)
 		{
-			newSurface.emplace_back(static_cast<uint8_t>(newSurface.size()), 0,
-									static_cast<uint8_t>(newSurface.size() + 1),
+			newSurface.emplace_back(static_cast<uint32_t>(newSurface.size()), 0,
+									static_cast<uint32_t>(newSurface.size() + 1),
 									0, &sVerts, &surface, nullptr);
 		}
 		newSurface[newSurface.size() - 1].nextID = 0; // Close the loop
 		sVerts.swap(newVerts);
 		surface.swap(newSurface);
 	}
-#ifndef NDEBUG
-	for (auto& edge : surface)
+	if (IsDebugDrawEnabled(DEBUG_CONTACTS))
 	{
-		DrawLine3D(edge.Vertex()->Vec(), edge.Next()->Vertex()->Vec(), RED);
-		auto start = edge.Next()->Vertex()->Vec();
-		auto end = (Vector3RotateByAxisAngle((-edge.Dir() * 0.1f), -ref.normal,
-											 20.0f * DEG2RAD)
-					+ start);
-		DrawLine3D(start, end, RED);
+		for (auto& edge : surface)
+		{
+			DebugLine(DEBUG_CONTACTS, edge.Vertex()->Vec(),
+					  edge.Next()->Vertex()->Vec(), RED);
+			auto start = edge.Next()->Vertex()->Vec();
+			auto end = (Vector3RotateByAxisAngle((-edge.Dir() * 0.1f),
+												 -ref.normal, 20.0f * DEG2RAD)
+						+ start);
+			DebugLine(DEBUG_CONTACTS, start, end, RED);
+		}
 	}
-#endif // !NDEBUG
 	auto filter = [&ref](const HE::HVertex vert) -> bool
 	{
 		return !HE::IsPointBehindPlane(ref.Plane(), vert.Vec());
@@ -295,34 +386,46 @@ auto GenFaceContact(const HE::HFace& ref, const HE::HFace& incident)
 			   + (-nor)
 			   * Vector3DotProduct(nor, vert.Vec() - refPoint);
 	};
-	vector<Vector3> contact = sVerts
-							  | rv::filter(filter)
-							  | rv::transform(transform)
-							  | std::ranges::to<vector>();
-#ifndef NDEBUG
+	std::pmr::vector<Vector3> contact{&GetFrameArena()};
+	r::copy(sVerts | rv::filter(filter) | rv::transform(transform),
+			std::back_inserter(contact));
 	for (const auto point : contact)
 	{
-		DrawSphere(point, 0.01f, RED);
+		DebugPoint(DEBUG_CONTACTS, point, 0.02f, RED);
 	}
-#endif // !NDEBUG
 	return contact;
 }
-auto CheckRaycast(const Ray ray, PhysObject& obj) -> std::optional<RaycastHit>
+auto CheckRaycast(const Ray ray, const PhysObject& obj)
+	-> std::optional<RaycastHit>
 {
-	vector<Collider> colliders;
+	std::pmr::vector<Collider> colliders{&GetFrameArena()};
 	std::visit([&obj, &colliders](const isCollider auto& col) -> auto
 			   { col.GetTransformed(obj.GetTransformM(), colliders); },
 			   obj.GetCollider());
 	RaycastHit hitObj{.hitDist = std::numeric_limits<float>::max(),
 					  .hitPos = Vector3Zero(),
-					  .hitObj = &obj};
+					  .hitObj = obj};
 	bool isHit{false};
 	for (const auto& collider : colliders)
 	{
-		const HullCollider& hull{std::get<0>(collider)};
-		for (uint32_t i{0}; i < hull.FaceCount(); i++)
+		const auto* hull = std::get_if<HullCollider>(&collider);
+		if (hull == nullptr)
 		{
-			const auto& face = hull.GetFace(i);
+			const auto dist{RaycastPrimitive(ray, collider)};
+			if (dist.has_value())
+			{
+				isHit |= true;
+				if (*dist < hitObj.hitDist)
+				{
+					hitObj.hitDist = *dist;
+					hitObj.hitPos = ray.position + (ray.direction * *dist);
+				}
+			}
+			continue;
+		}
+		for (uint32_t i{0}; i < hull->FaceCount(); i++)
+		{
+			const auto& face = hull->GetFace(i);
 			if (Vector3DotProduct(face.normal, ray.direction) > 0)
 				continue;
 			float dist
@@ -393,7 +496,8 @@ auto IsPointInPoly3D(const Vector3 point, const HE::HFace& poly) -> bool
 	}
 	return inPoly;
 }
-auto CheckFaceNors(Collider colA, Collider colB) -> FaceHit
+auto CheckFaceNors(const HullCollider& hull1, const HullCollider& hull2)
+	-> FaceHit
 {
 #ifndef NDEBUG
 	// vector<Vector3> nors;
@@ -405,15 +509,13 @@ auto CheckFaceNors(Collider colA, Collider colB) -> FaceHit
 #endif // !NDEBUG
 	FaceHit hit{};
 	hit.penetration = std::numeric_limits<float>::max();
-	const HullCollider& hull1 = std::get<0>(colA);
-	for (uint32_t i{0}; i < hull1.faces.size(); i++)
+	const auto& faces{hull1.GetGeometry()->faces};
+	for (uint32_t i{0}; i < faces.size(); i++)
 	{
-		Vector3 nor = hull1.faces[i].normal;
-		Vector3 support{std::visit([nor](const isCollider auto& col) -> Vector3
-								   { return col.GetSupportPoint(-nor); },
-								   colB)};
+		Vector3 nor = faces[i].normal;
+		Vector3 support{hull2.GetSupportPoint(-nor)};
 		float penetration
-			= Vector3DotProduct(hull1.faces[i].Edge()->Vertex()->Vec(), nor)
+			= Vector3DotProduct(faces[i].Edge()->Vertex()->Vec(), nor)
 			  - Vector3DotProduct(support, nor);
 		if (penetration < hit.penetration)
 		{
@@ -439,14 +541,12 @@ auto CheckFaceNors(Collider colA, Collider colB) -> FaceHit
 	}
 	return hit;
 }
-auto CheckEdgeNors(Collider colA, Collider colB) -> EdgeHit
+auto CheckEdgeNors(const HullCollider& hull1, const HullCollider& hull2)
+	-> EdgeHit
 {
-	const HullCollider& hull1 = std::get<0>(colA);
-	const HullCollider& hull2 = std::get<0>(colB);
-
 	auto normalizeDirs = [&hull2, &hull1](auto nor) -> Vector3Tuple
 	{
-		auto dir = hull2.origin - hull1.origin;
+		auto dir = hull2.GetOrigin() - hull1.GetOrigin();
 		if (Vector3DotProduct(std::get<2>(nor), dir) >= 0)
 			std::get<2>(nor) = -std::get<2>(nor);
 		return {std::get<0>(nor), std::get<1>(nor), std::get<2>(nor)};
@@ -481,66 +581,116 @@ auto CheckEdgeNors(Collider colA, Collider colB) -> EdgeHit
 						  - Vector3DotProduct(hit.normal, hit.support1);
 		return hit;
 	};
-	auto nors = GetEdgeCrosses(hull1, hull2)
+	std::pmr::vector<Vector3Tuple> crosses{&GetFrameArena()};
+	GetEdgeCrosses(hull1, hull2, crosses);
+	auto hits = crosses
 				| rv::transform(normalizeDirs)
 				| rv::transform(genHitObject)
 				| rv::filter(checkBounds)
-				| rv::transform(getPenetration)
-				| r::to<vector<EdgeHit>>();
-
-	if (nors.empty())
-		return {};
+				| rv::transform(getPenetration);
 
-	return *r::min_element(nors, {}, &EdgeHit::penetration);
+	// Keep the shallowest hit as they come rather than collecting them all
+	optional<EdgeHit> best;
+	for (const EdgeHit hit : hits)
+	{
+		if (!best.has_value() || hit.penetration < best->penetration)
+		{
+			best = hit;
+		}
+	}
+	return best.value_or(EdgeHit{});
 }
 
-PhysObject::PhysObject(const Vector3 pos, const Mesh mesh,
-					   const Collider& col) :
-	mesh(mesh), collider(col), material(LoadMaterialDefault()),
-	position(MatrixTranslate(pos.x, pos.y, pos.z)),
-	rotation(MatrixRotate({0.0f, 1.0f, 0.0f}, 0.0f)),
-	scale(MatrixScale(1.0f, 1.0f, 1.0f))
+PhysObject::PhysObject(BodyStorage& bodies, const Vector3 pos,
+					   const MeshID mesh, const Collider& col) :
+	bodies(&bodies), handle(bodies.Add(pos, mesh, col))
+{ }
+PhysObject::PhysObject(BodyStorage& bodies, const Vector3 pos,
+					   const MeshID mesh, const Collider& col,
+					   const MaterialID material) :
+	phys::PhysObject(bodies, pos, mesh, col)
 {
-
-	UploadMesh(&this->mesh, false);
-}
-PhysObject::PhysObject(const Vector3 pos, const Mesh mesh, const Collider& col,
-					   const Shader& shader) : phys::PhysObject(pos, mesh, col)
-{
-	this->SetShader(shader);
+	this->SetMaterial(material);
 }
-PhysObject::PhysObject(const Vector3 pos, const Mesh mesh, const Collider& col,
+PhysObject::PhysObject(BodyStorage& bodies, const Vector3 pos,
+					   const MeshID mesh, const Collider& col,
 					   const char* vertShader, const char* fragShader) :
-	phys::PhysObject(pos, mesh, col)
+	phys::PhysObject(bodies, pos, mesh, col)
 {
-	this->shader = LoadShader(vertShader, fragShader);
-	this->material.shader = this->shader;
+	this->SetMaterial(GetRenderCache().LoadMaterial(vertShader, fragShader));
 }
 
-void PhysObject::Update()
+void PhysObject::AddColliderLOD(const float minDistance, const Collider& col)
+{
+	auto& lods = this->bodies->colliderLODs[this->Index()];
+	const auto pos{
+		r::upper_bound(lods, minDistance, {}, &ColliderLOD::minDistance)};
+	const auto lod{
+		lods.insert(pos, {.minDistance = minDistance, .collider = col})};
+	GetHullRegistry().Intern(lod->collider);
+	this->bodies->activeLODs[this->Index()] = 0;
+	this->bodies->UpdateLocalBounds(this->Index());
+}
+void PhysObject::AddColliderLOD(const float minDistance,
+								const SimplifySettings& settings)
 {
-	// TODO: Implement update logic
+	this->AddColliderLOD(
+		minDistance,
+		SimplifyCollider(this->bodies->colliders[this->Index()], settings));
 }
+void PhysObject::SelectColliderLOD(const Vector3 viewer)
+{
+	const auto& lods = this->bodies->colliderLODs[this->Index()];
+	const float dist{Vector3Distance(viewer, this->GetPosition())};
+	uint32_t activeLOD{0};
+	for (uint32_t i{0}; i < lods.size(); i++)
+	{
+		if (dist >= lods[i].minDistance)
+		{
+			activeLOD = i + 1;
+		}
+	}
+	if (this->bodies->activeLODs[this->Index()] != activeLOD)
+	{
+		this->bodies->activeLODs[this->Index()] = activeLOD;
+		this->bodies->UpdateLocalBounds(this->Index());
+	}
+}
+
 void PhysObject::Draw() const
 {
-	DrawMesh(this->mesh, this->material, this->GetTransformM());
+	const BodyRender& render{this->bodies->renders[this->Index()]};
+	if (render.mesh == NO_MESH)
+		return;
+	const RenderCache& cache{GetRenderCache()};
+	const Mesh& mesh{cache.GetMesh(render.mesh)};
+	const Material& material{cache.GetMaterial(render.material)};
+	if (cache.IsInstanced(render.material))
+	{
+		DrawMeshInstanced(mesh, material, &this->GetTransformM(), 1);
+	}
+	else
+	{
+		DrawMesh(mesh, material, this->GetTransformM());
+	}
 }
 
-auto CreateBoxObject(const Vector3 pos, const Vector3 dims) -> PhysObject
+auto CreateBoxObject(BodyStorage& bodies, const Vector3 pos,
+					 const Vector3 dims) -> PhysObject
 {
-	Collider col = CreateBoxCollider(MatrixScale(dims.x, dims.y, dims.z));
-	Mesh mesh = GenMeshCube(dims.x, dims.y, dims.z);
+	Collider col = CreateOBBCollider(MatrixScale(dims.x, dims.y, dims.z));
+	const MeshID mesh{GetRenderCache().AcquireMesh(MeshShape::CUBE, dims)};
 #if defined(PLATFORM_WEB)
-	static const Shader shader
-		= LoadShader(RESOURCES_PATH "shaders/litShader_web.vert",
-					 RESOURCES_PATH "shaders/litShader_web.frag");
+	const MaterialID material{GetRenderCache().LoadMaterial(
+		RESOURCES_PATH "shaders/litShaderInstanced_web.vert",
+		RESOURCES_PATH "shaders/litShader_web.frag")};
 #else
-	static const Shader shader
-		= LoadShader(RESOURCES_PATH "shaders/litShader.vert",
-					 RESOURCES_PATH "shaders/litShader.frag");
+	const MaterialID material{GetRenderCache().LoadMaterial(
+		RESOURCES_PATH "shaders/litShaderInstanced.vert",
+		RESOURCES_PATH "shaders/litShader.frag")};
 #endif
 
-	return {pos, mesh, col, shader};
+	return {bodies, pos, mesh, col, material};
 }
 
 #ifndef NDEBUG
@@ -0,0 +1,950 @@
+#include "primitiveTests.h"
+#include "collider.h"
+#include "frameArena.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <optional>
+#include <raylib.h>
+#include <raymath.h>
+#include <span>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace phys
+{
+
+using std::optional;
+using std::vector;
+
+namespace
+{
+
+/** @brief Squared lengths below this are treated as zero. */
+constexpr float TINY{1e-12f};
+/** @brief Edge axes must beat face axes by this factor to be picked. */
+constexpr float EDGE_AXIS_BIAS{0.95f};
+
+auto ClosestOnSegment(const Vector3 point, const Vector3 start,
+					  const Vector3 end) -> Vector3
+{
+	const Vector3 dir{end - start};
+	const float lengthSqr{Vector3DotProduct(dir, dir)};
+	if (lengthSqr <= TINY)
+		return start;
+	const float t{Vector3DotProduct(point - start, dir) / lengthSqr};
+	return start + (dir * std::clamp(t, 0.0f, 1.0f));
+}
+
+/** @returns The closest pair of points between segments p1-q1 and p2-q2. */
+auto ClosestBetweenSegments(const Vector3 p1, const Vector3 q1,
+							const Vector3 p2, const Vector3 q2)
+	-> std::pair<Vector3, Vector3>
+{
+	const Vector3 d1{q1 - p1};
+	const Vector3 d2{q2 - p2};
+	const Vector3 r{p1 - p2};
+	const float a{Vector3DotProduct(d1, d1)};
+	const float e{Vector3DotProduct(d2, d2)};
+	const float f{Vector3DotProduct(d2, r)};
+	if (a <= TINY && e <= TINY)
+		return {p1, p2};
+
+	float s{0.0f};
+	float t{0.0f};
+	if (a <= TINY)
+	{
+		t = std::clamp(f / e, 0.0f, 1.0f);
+	}
+	else
+	{
+		const float c{Vector3DotProduct(d1, r)};
+		if (e <= TINY)
+		{
+			s = std::clamp(-c / a, 0.0f, 1.0f);
+		}
+		else
+		{
+			const float b{Vector3DotProduct(d1, d2)};
+			const float denom{(a * e) - (b * b)};
+			// Parallel segments can take any s, so start from p1
+			s = denom > TINY ? std::clamp(((b * f) - (c * e)) / denom, 0.0f,
+										  1.0f)
+							 : 0.0f;
+			t = ((b * s) + f) / e;
+			if (t < 0.0f)
+			{
+				t = 0.0f;
+				s = std::clamp(-c / a, 0.0f, 1.0f);
+			}
+			else if (t > 1.0f)
+			{
+				t = 1.0f;
+				s = std::clamp((b - c) / a, 0.0f, 1.0f);
+			}
+		}
+	}
+	return {p1 + (d1 * s), p2 + (d2 * t)};
+}
+
+/**
+ * @brief Contact between two rounded shapes, given the closest points of
+ *        their cores and the radius around each.
+ */
+auto GetRoundContact(const Vector3 pointA, const float radiusA,
+					 const Vector3 pointB, const float radiusB)
+	-> optional<ContactHit>
+{
+	const Vector3 offset{pointB - pointA};
+	const float dist{Vector3Length(offset)};
+	const float penetration{radiusA + radiusB - dist};
+	if (penetration <= 0.0f)
+		return std::nullopt;
+	// Concentric cores have no preferred direction
+	const Vector3 normal{dist * dist > TINY ? offset / dist
+											: Vector3{0.0f, 1.0f, 0.0f}};
+	return ContactHit{
+		.normal = normal,
+		.penetration = penetration,
+		.point = pointA + (normal * (radiusA - (penetration * 0.5f))),
+	};
+}
+
+/**
+ * @brief Separating axis test driven purely by support functions.
+ * @returns The axis of least overlap, or std::nullopt if any axis separates.
+ */
+template <typename ShapeA, typename ShapeB>
+auto CheckSupportAxes(const ShapeA& colA, const ShapeB& colB,
+					  std::span<const Vector3> axes) -> optional<ContactHit>
+{
+	ContactHit hit{.penetration = std::numeric_limits<float>::max()};
+	for (const auto axis : axes)
+	{
+		const float lengthSqr{Vector3DotProduct(axis, axis)};
+		if (lengthSqr <= TINY)
+			continue;
+		const Vector3 nor{axis / std::sqrt(lengthSqr)};
+		const float maxA{Vector3DotProduct(colA.GetSupportPoint(nor), nor)};
+		const float minA{Vector3DotProduct(colA.GetSupportPoint(-nor), nor)};
+		const float maxB{Vector3DotProduct(colB.GetSupportPoint(nor), nor)};
+		const float minB{Vector3DotProduct(colB.GetSupportPoint(-nor), nor)};
+		const float ahead{maxA - minB};
+		const float behind{maxB - minA};
+		if (ahead <= 0.0f || behind <= 0.0f)
+			return std::nullopt;
+		if (ahead < hit.penetration)
+		{
+			hit.penetration = ahead;
+			hit.normal = nor;
+		}
+		if (behind < hit.penetration)
+		{
+			hit.penetration = behind;
+			hit.normal = -nor;
+		}
+	}
+	hit.point = colB.GetSupportPoint(-hit.normal)
+				+ (hit.normal * (hit.penetration * 0.5f));
+	return hit;
+}
+
+/** @brief Vertex of the Minkowski difference A - B, along with its sources. */
+struct SimplexPoint
+{
+	Vector3 diff;
+	Vector3 pointA;
+	Vector3 pointB;
+};
+struct Simplex
+{
+	std::array<SimplexPoint, 4> points{};
+	std::array<float, 4> weights{};
+	uint32_t count{0};
+
+	/** @brief Keeps only the listed points, with the given weights. */
+	void Reduce(std::span<const uint32_t> keep, std::span<const float> bary)
+	{
+		std::array<SimplexPoint, 4> kept{};
+		for (uint32_t i{0}; i < keep.size(); i++)
+		{
+			kept[i] = this->points[keep[i]];
+			this->weights[i] = bary[i];
+		}
+		this->points = kept;
+		this->count = static_cast<uint32_t>(keep.size());
+	}
+	auto Closest() const -> Vector3
+	{
+		Vector3 closest{};
+		for (uint32_t i{0}; i < this->count; i++)
+		{
+			closest = closest + (this->points[i].diff * this->weights[i]);
+		}
+		return closest;
+	}
+};
+
+/**
+ * @brief Finds the point of triangle a, b, c closest to the origin.
+ * @returns The number of vertices of the feature it lies on, whose indices
+ *          and weights are written to ids and bary.
+ */
+auto ClosestOnTriangle(const std::array<Vector3, 3>& tri,
+					   std::array<uint32_t, 3>& ids, std::array<float, 3>& bary)
+	-> uint32_t
+{
+	const auto [a, b, c] = tri;
+	const Vector3 ab{b - a};
+	const Vector3 ac{c - a};
+	const float d1{-Vector3DotProduct(ab, a)};
+	const float d2{-Vector3DotProduct(ac, a)};
+	if (d1 <= 0.0f && d2 <= 0.0f)
+	{
+		ids[0] = 0;
+		bary[0] = 1.0f;
+		return 1;
+	}
+	const float d3{-Vector3DotProduct(ab, b)};
+	const float d4{-Vector3DotProduct(ac, b)};
+	if (d3 >= 0.0f && d4 <= d3)
+	{
+		ids[0] = 1;
+		bary[0] = 1.0f;
+		return 1;
+	}
+	const float vc{(d1 * d4) - (d3 * d2)};
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+	{
+		const float v{d1 / (d1 - d3)};
+		ids = {0, 1, 0};
+		bary = {1.0f - v, v, 0.0f};
+		return 2;
+	}
+	const float d5{-Vector3DotProduct(ab, c)};
+	const float d6{-Vector3DotProduct(ac, c)};
+	if (d6 >= 0.0f && d5 <= d6)
+	{
+		ids[0] = 2;
+		bary[0] = 1.0f;
+		return 1;
+	}
+	const float vb{(d5 * d2) - (d1 * d6)};
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+	{
+		const float w{d2 / (d2 - d6)};
+		ids = {0, 2, 0};
+		bary = {1.0f - w, w, 0.0f};
+		return 2;
+	}
+	const float va{(d3 * d6) - (d5 * d4)};
+	if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+	{
+		const float w{(d4 - d3) / ((d4 - d3) + (d5 - d6))};
+		ids = {1, 2, 0};
+		bary = {1.0f - w, w, 0.0f};
+		return 2;
+	}
+	const float sum{va + vb + vc};
+	if (sum <= TINY)
+	{
+		// Degenerate triangle, settle for its first edge
+		const float lengthSqr{std::max(Vector3DotProduct(ab, ab), TINY)};
+		const float t{std::clamp(d1 / lengthSqr, 0.0f, 1.0f)};
+		ids = {0, 1, 0};
+		bary = {1.0f - t, t, 0.0f};
+		return 2;
+	}
+	const float v{vb / sum};
+	const float w{vc / sum};
+	ids = {0, 1, 2};
+	bary = {1.0f - v - w, v, w};
+	return 3;
+}
+
+/**
+ * @brief Shrinks the simplex to the feature closest to the origin.
+ * @returns false if the origin is enclosed by the simplex.
+ */
+auto SolveSimplex(Simplex& simplex) -> bool
+{
+	auto& pts = simplex.points;
+	switch (simplex.count)
+	{
+	case 1:
+		simplex.weights[0] = 1.0f;
+		return true;
+	case 2:
+	{
+		const Vector3 dir{pts[1].diff - pts[0].diff};
+		const float lengthSqr{Vector3DotProduct(dir, dir)};
+		const float t{
+			lengthSqr > TINY
+				? std::clamp(-Vector3DotProduct(pts[0].diff, dir) / lengthSqr,
+							 0.0f, 1.0f)
+				: 0.0f};
+		const std::array<uint32_t, 2> ids{0, 1};
+		const std::array<float, 2> bary{1.0f - t, t};
+		if (t <= 0.0f)
+			simplex.Reduce(std::span(ids).first(1), bary);
+		else if (t >= 1.0f)
+			simplex.Reduce(std::span(ids).last(1), std::span(bary).last(1));
+		else
+			simplex.Reduce(ids, bary);
+		return true;
+	}
+	case 3:
+	{
+		std::array<uint32_t, 3> ids{};
+		std::array<float, 3> bary{};
+		const uint32_t count{ClosestOnTriangle(
+			{pts[0].diff, pts[1].diff, pts[2].diff}, ids, bary)};
+		simplex.Reduce(std::span(ids).first(count),
+					   std::span(bary).first(count));
+		return true;
+	}
+	default:
+	{
+		// Test each face the origin could lie beyond, opposite vertex last
+		constexpr std::array<std::array<uint32_t, 4>, 4> FACES{{
+			{0, 1, 2, 3},
+			{0, 1, 3, 2},
+			{0, 2, 3, 1},
+			{1, 2, 3, 0},
+		}};
+		float bestDist{std::numeric_limits<float>::max()};
+		std::array<uint32_t, 3> bestIDs{};
+		std::array<float, 3> bestBary{};
+		uint32_t bestCount{0};
+		for (const auto& face : FACES)
+		{
+			const Vector3 a{pts[face[0]].diff};
+			const Vector3 nor{Vector3CrossProduct(pts[face[1]].diff - a,
+												  pts[face[2]].diff - a)};
+			const float originSide{Vector3DotProduct(nor, -a)};
+			const float oppositeSide{
+				Vector3DotProduct(nor, pts[face[3]].diff - a)};
+			if (originSide * oppositeSide > 0.0f)
+				continue;
+
+			std::array<uint32_t, 3> ids{};
+			std::array<float, 3> bary{};
+			const uint32_t count{ClosestOnTriangle(
+				{a, pts[face[1]].diff, pts[face[2]].diff}, ids, bary)};
+			Vector3 closest{};
+			for (uint32_t i{0}; i < count; i++)
+			{
+				ids[i] = face[ids[i]];
+				closest = closest + (pts[ids[i]].diff * bary[i]);
+			}
+			const float dist{Vector3DotProduct(closest, closest)};
+			if (dist < bestDist)
+			{
+				bestDist = dist;
+				bestIDs = ids;
+				bestBary = bary;
+				bestCount = count;
+			}
+		}
+		if (bestCount == 0)
+			return false;
+		simplex.Reduce(std::span(bestIDs).first(bestCount),
+					   std::span(bestBary).first(bestCount));
+		return true;
+	}
+	}
+}
+
+struct CoreDistance
+{
+	float distance;
+	Vector3 pointA;
+	Vector3 pointB;
+};
+
+/**
+ * @brief GJK distance between two convex shapes given by support functions.
+ * @param overlapOnly Stop as soon as a support point fails to reach past the
+ *        origin, which proves the shapes apart but leaves the distance and
+ *        points unrefined.
+ * @returns std::nullopt if the shapes overlap.
+ */
+template <typename SupportA, typename SupportB>
+auto GetCoreDistance(const SupportA& supportA, const SupportB& supportB,
+					 const bool overlapOnly = false) -> optional<CoreDistance>
+{
+	constexpr uint32_t MAX_ITERATIONS{32};
+	constexpr float TOLERANCE{1e-5f};
+
+	const auto getPoint = [&supportA, &supportB](const Vector3 dir)
+		-> SimplexPoint
+	{
+		const Vector3 pointA{supportA(dir)};
+		const Vector3 pointB{supportB(-dir)};
+		return {.diff = pointA - pointB, .pointA = pointA, .pointB = pointB};
+	};
+
+	Simplex simplex;
+	simplex.points[0] = getPoint({1.0f, 0.0f, 0.0f});
+	simplex.weights[0] = 1.0f;
+	simplex.count = 1;
+	Vector3 closest{simplex.points[0].diff};
+	for (uint32_t i{0}; i < MAX_ITERATIONS; i++)
+	{
+		const float distSqr{Vector3DotProduct(closest, closest)};
+		if (distSqr <= TINY)
+			return std::nullopt;
+
+		const SimplexPoint point{getPoint(-closest)};
+		if (overlapOnly && Vector3DotProduct(closest, point.diff) > 0.0f)
+			break;
+		// Stop once the new point brings the simplex no closer to the origin
+		if (distSqr - Vector3DotProduct(closest, point.diff)
+			<= TOLERANCE * distSqr)
+			break;
+		const bool repeated{std::ranges::any_of(
+			std::span(simplex.points).first(simplex.count),
+			[point](const SimplexPoint& other) -> bool
+			{ return Vector3Equals(other.diff, point.diff) != 0; })};
+		if (repeated)
+			break;
+
+		simplex.points[simplex.count++] = point;
+		if (!SolveSimplex(simplex))
+			return std::nullopt;
+		closest = simplex.Closest();
+	}
+
+	CoreDistance result{.distance = Vector3Length(closest),
+						.pointA = Vector3Zero(),
+						.pointB = Vector3Zero()};
+	for (uint32_t i{0}; i < simplex.count; i++)
+	{
+		result.pointA
+			= result.pointA + (simplex.points[i].pointA * simplex.weights[i]);
+		result.pointB
+			= result.pointB + (simplex.points[i].pointB * simplex.weights[i]);
+	}
+	return result;
+}
+
+/**
+ * @brief Tests a sphere or capsule against a box or hull. The rounded
+ *        shape's core is a point or segment, whose distance to the polytope
+ *        is found with GJK. Only if the core itself is inside the polytope
+ *        is a separating axis test needed, over the polytope's normals and
+ *        the given extra axes.
+ */
+template <typename Rounded, typename Polytope>
+auto CheckRoundedPolytope(const Rounded& colA, const Vector3 start,
+						  const Vector3 end, const Polytope& colB,
+						  std::span<const Vector3> extraAxes)
+	-> optional<ContactHit>
+{
+	const auto coreSupport = [start, end](const Vector3 dir) -> Vector3
+	{ return Vector3DotProduct(dir, end - start) > 0.0f ? end : start; };
+	const auto polySupport = [&colB](const Vector3 dir) -> Vector3
+	{ return colB.GetSupportPoint(dir); };
+
+	const auto dist{GetCoreDistance(coreSupport, polySupport)};
+	if (dist.has_value() && dist->distance * dist->distance > TINY)
+		return GetRoundContact(dist->pointA, colA.GetRadius(), dist->pointB,
+							   0.0f);
+
+	std::pmr::vector<Vector3> axes{&GetFrameArena()};
+	colB.GetNormals(axes);
+	axes.insert(axes.end(), extraAxes.begin(), extraAxes.end());
+	return CheckSupportAxes(colA, colB, axes);
+}
+
+/**
+ * @returns The cross of the capsule's axis with each of dirs, allocated from
+ *          the frame arena.
+ */
+auto GetCapsuleAxes(const CapsuleCollider& capsule,
+					std::span<const Vector3> dirs) -> std::pmr::vector<Vector3>
+{
+	const Vector3 axis{capsule.GetEnd() - capsule.GetStart()};
+	std::pmr::vector<Vector3> axes{&GetFrameArena()};
+	axes.reserve(dirs.size());
+	for (const auto dir : dirs)
+	{
+		axes.push_back(Vector3CrossProduct(axis, dir));
+	}
+	return axes;
+}
+
+/**
+ * @brief Turns hit, whose normal points from tri to col, to tri's face normal
+ *        if the edge or vertex of tri it points out of is internal to the
+ *        mesh.
+ */
+template <typename Shape>
+auto SnapInternalFeature(const MeshTriangle& tri, const Shape& col,
+						 ContactHit hit) -> ContactHit
+{
+	// Normals this close to the face already are left alone
+	constexpr float FACE_COSINE{0.9999f};
+	// Vertices within this fraction of the triangle's extent are tied
+	constexpr float TIE_FRACTION{1e-3f};
+	if (std::fabs(Vector3DotProduct(hit.normal, tri.normal)) >= FACE_COSINE)
+		return hit;
+
+	std::array<float, 3> dists{};
+	for (uint32_t i{0}; i < 3; i++)
+	{
+		dists[i] = Vector3DotProduct(tri.verts[i], hit.normal);
+	}
+	const auto [low, high] = std::ranges::minmax(dists);
+	uint32_t extreme{0};
+	for (uint32_t i{0}; i < 3; i++)
+	{
+		if (dists[i] >= high - ((high - low) * TIE_FRACTION))
+		{
+			extreme |= 1U << i;
+		}
+	}
+	// The feature of each set of tied vertices. Edge i runs from vertex i to
+	// vertex i + 1, and all three tied means the face itself.
+	constexpr std::array<uint8_t, 8> FEATURE_OF_VERTS{
+		0,
+		MESH_VERTEX_0,
+		MESH_VERTEX_1,
+		MESH_EDGE_0,
+		MESH_VERTEX_2,
+		MESH_EDGE_2,
+		MESH_EDGE_1,
+		MESH_EDGE_0 | MESH_EDGE_1 | MESH_EDGE_2,
+	};
+	if ((tri.activeFeatures & FEATURE_OF_VERTS[extreme]) != 0)
+		return hit;
+
+	const Vector3 face{
+		Vector3DotProduct(col.GetOrigin() - tri.verts[0], tri.normal) >= 0.0f
+			? tri.normal
+			: -tri.normal};
+	const Vector3 deepest{col.GetSupportPoint(-face)};
+	hit.normal = face;
+	hit.penetration = Vector3DotProduct(tri.verts[0] - deepest, face);
+	hit.point = deepest + (face * (hit.penetration * 0.5f));
+	return hit;
+}
+/**
+ * @returns The normal of tri and each of its edges crossed with dirs,
+ *          allocated from the frame arena.
+ */
+auto GetTriangleAxes(const MeshTriangle& tri, std::span<const Vector3> dirs)
+	-> std::pmr::vector<Vector3>
+{
+	std::pmr::vector<Vector3> axes{&GetFrameArena()};
+	axes.reserve((dirs.size() * 3) + 1);
+	axes.push_back(tri.normal);
+	for (uint32_t i{0}; i < 3; i++)
+	{
+		const Vector3 edge{tri.verts[(i + 1) % 3] - tri.verts[i]};
+		for (const auto dir : dirs)
+		{
+			axes.push_back(Vector3CrossProduct(edge, dir));
+		}
+	}
+	return axes;
+}
+
+auto RaycastSphere(const Ray ray, const Vector3 centre, const float radius)
+	-> optional<float>
+{
+	// Like hull faces, surfaces seen from inside are not hit
+	if (Vector3DistanceSqr(ray.position, centre) <= radius * radius)
+		return std::nullopt;
+	// raylib reports spheres behind the ray as hits too
+	const RayCollision hit{GetRayCollisionSphere(ray, centre, radius)};
+	if (!hit.hit || hit.distance < 0.0f)
+		return std::nullopt;
+	return hit.distance;
+}
+auto RaycastCapsule(const Ray ray, const CapsuleCollider& capsule)
+	-> optional<float>
+{
+	const float radius{capsule.GetRadius()};
+	const Vector3 closest{ClosestOnSegment(ray.position, capsule.GetStart(),
+										   capsule.GetEnd())};
+	if (Vector3DistanceSqr(ray.position, closest) <= radius * radius)
+		return std::nullopt;
+	optional<float> best{RaycastSphere(ray, capsule.GetStart(), radius)};
+	const auto endHit{RaycastSphere(ray, capsule.GetEnd(), radius)};
+	if (endHit.has_value() && (!best.has_value() || *endHit < *best))
+	{
+		best = endHit;
+	}
+
+	// The cylinder's side, worked in the plane perpendicular to its axis
+	const Vector3 axis{capsule.GetEnd() - capsule.GetStart()};
+	const float length{Vector3Length(axis)};
+	if (length * length <= TINY)
+		return best;
+	const Vector3 unit{axis / length};
+	const Vector3 offset{ray.position - capsule.GetStart()};
+	const Vector3 flatDir{
+		ray.direction - (unit * Vector3DotProduct(ray.direction, unit))};
+	const Vector3 flatOffset{offset - (unit * Vector3DotProduct(offset, unit))};
+	const float a{Vector3DotProduct(flatDir, flatDir)};
+	const float b{2.0f * Vector3DotProduct(flatOffset, flatDir)};
+	const float c{Vector3DotProduct(flatOffset, flatOffset)
+				  - (radius * radius)};
+	const float disc{(b * b) - (4.0f * a * c)};
+	if (a <= TINY || disc < 0.0f)
+		return best;
+	const float t{(-b - std::sqrt(disc)) / (2.0f * a)};
+	const float along{Vector3DotProduct(offset + (ray.direction * t), unit)};
+	if (t >= 0.0f && along >= 0.0f && along <= length
+		&& (!best.has_value() || t < *best))
+	{
+		best = t;
+	}
+	return best;
+}
+auto RaycastBox(const Ray ray, const BoxCollider& box) -> optional<float>
+{
+	const auto& axes = box.GetAxes();
+	const auto toLocal = [&axes](const Vector3 vec) -> Vector3
+	{
+		return {Vector3DotProduct(vec, axes[0]),
+				Vector3DotProduct(vec, axes[1]),
+				Vector3DotProduct(vec, axes[2])};
+	};
+	const Ray local{.position = toLocal(ray.position - box.GetOrigin()),
+					.direction = toLocal(ray.direction)};
+	const RayCollision hit{GetRayCollisionBox(
+		local, {.min = -box.GetHalfExtents(), .max = box.GetHalfExtents()})};
+	if (!hit.hit || hit.distance < 0.0f)
+		return std::nullopt;
+	return hit.distance;
+}
+
+} //namespace
+
+auto CheckSphereSphere(const SphereCollider& colA, const SphereCollider& colB)
+	-> optional<ContactHit>
+{
+	return GetRoundContact(colA.GetOrigin(), colA.GetRadius(),
+						   colB.GetOrigin(), colB.GetRadius());
+}
+auto CheckSphereCapsule(const SphereCollider& colA,
+						const CapsuleCollider& colB) -> optional<ContactHit>
+{
+	const Vector3 closest{
+		ClosestOnSegment(colA.GetOrigin(), colB.GetStart(), colB.GetEnd())};
+	return GetRoundContact(colA.GetOrigin(), colA.GetRadius(), closest,
+						   colB.GetRadius());
+}
+auto CheckSphereBox(const SphereCollider& colA, const BoxCollider& colB)
+	-> optional<ContactHit>
+{
+	const Vector3 offset{colA.GetOrigin() - colB.GetOrigin()};
+	const auto& axes = colB.GetAxes();
+	const Vector3 half{colB.GetHalfExtents()};
+	const std::array<float, 3> extents{half.x, half.y, half.z};
+
+	Vector3 closest{colB.GetOrigin()};
+	bool inside{true};
+	// Axis and depth of the face closest to the centre, if it is inside
+	uint32_t faceAxis{0};
+	float faceDepth{std::numeric_limits<float>::max()};
+	for (uint32_t i{0}; i < 3; i++)
+	{
+		const float dist{Vector3DotProduct(offset, axes[i])};
+		const float clamped{std::clamp(dist, -extents[i], extents[i])};
+		inside &= clamped == dist;
+		closest = closest + (axes[i] * clamped);
+		if (extents[i] - std::fabs(dist) < faceDepth)
+		{
+			faceDepth = extents[i] - std::fabs(dist);
+			faceAxis = i;
+		}
+	}
+	if (!inside)
+		return GetRoundContact(colA.GetOrigin(), colA.GetRadius(), closest,
+							   0.0f);
+
+	const float side{
+		Vector3DotProduct(offset, axes[faceAxis]) >= 0.0f ? 1.0f : -1.0f};
+	return ContactHit{
+		.normal = axes[faceAxis] * -side,
+		.penetration = faceDepth + colA.GetRadius(),
+		.point = colA.GetOrigin(),
+	};
+}
+auto CheckSphereHull(const SphereCollider& colA, const HullCollider& colB)
+	-> optional<ContactHit>
+{
+	const Vector3 centre{colA.GetOrigin()};
+	return CheckRoundedPolytope(colA, centre, centre, colB, {});
+}
+auto CheckCapsuleCapsule(const CapsuleCollider& colA,
+						 const CapsuleCollider& colB) -> optional<ContactHit>
+{
+	const auto [pointA, pointB] = ClosestBetweenSegments(
+		colA.GetStart(), colA.GetEnd(), colB.GetStart(), colB.GetEnd());
+	return GetRoundContact(pointA, colA.GetRadius(), pointB,
+						   colB.GetRadius());
+}
+auto CheckCapsuleBox(const CapsuleCollider& colA, const BoxCollider& colB)
+	-> optional<ContactHit>
+{
+	const auto axes{GetCapsuleAxes(colA, colB.GetAxes())};
+	return CheckRoundedPolytope(colA, colA.GetStart(), colA.GetEnd(), colB,
+								axes);
+}
+auto CheckCapsuleHull(const CapsuleCollider& colA, const HullCollider& colB)
+	-> optional<ContactHit>
+{
+	const auto axes{GetCapsuleAxes(colA, colB.GetEdgeDirs())};
+	return CheckRoundedPolytope(colA, colA.GetStart(), colA.GetEnd(), colB,
+								axes);
+}
+template <typename ShapeA, typename ShapeB>
+auto CheckGJKOverlap(const ShapeA& colA, const ShapeB& colB) -> bool
+{
+	return !GetCoreDistance([&colA](const Vector3 dir) -> Vector3
+							{ return colA.GetSupportPoint(dir); },
+							[&colB](const Vector3 dir) -> Vector3
+							{ return colB.GetSupportPoint(dir); },
+							true)
+				.has_value();
+}
+template auto CheckGJKOverlap(const HullCollider&, const HullCollider&)
+	-> bool;
+template auto CheckGJKOverlap(const HullCollider&, const SphereCollider&)
+	-> bool;
+template auto CheckGJKOverlap(const HullCollider&, const CapsuleCollider&)
+	-> bool;
+template auto CheckGJKOverlap(const HullCollider&, const BoxCollider&)
+	-> bool;
+template auto CheckGJKOverlap(const SphereCollider&, const HullCollider&)
+	-> bool;
+template auto CheckGJKOverlap(const SphereCollider&, const SphereCollider&)
+	-> bool;
+template auto CheckGJKOverlap(const SphereCollider&, const CapsuleCollider&)
+	-> bool;
+template auto CheckGJKOverlap(const SphereCollider&, const BoxCollider&)
+	-> bool;
+template auto CheckGJKOverlap(const CapsuleCollider&, const HullCollider&)
+	-> bool;
+template auto CheckGJKOverlap(const CapsuleCollider&, const SphereCollider&)
+	-> bool;
+template auto CheckGJKOverlap(const CapsuleCollider&, const CapsuleCollider&)
+	-> bool;
+template auto CheckGJKOverlap(const CapsuleCollider&, const BoxCollider&)
+	-> bool;
+template auto CheckGJKOverlap(const BoxCollider&, const HullCollider&)
+	-> bool;
+template auto CheckGJKOverlap(const BoxCollider&, const SphereCollider&)
+	-> bool;
+template auto CheckGJKOverlap(const BoxCollider&, const CapsuleCollider&)
+	-> bool;
+template auto CheckGJKOverlap(const BoxCollider&, const BoxCollider&)
+	-> bool;
+auto CheckHullBox(const HullCollider& colA, const BoxCollider& colB)
+	-> optional<ContactHit>
+{
+	const auto& boxAxes{colB.GetAxes()};
+	const auto& edgeDirs{colA.GetEdgeDirs()};
+	std::pmr::vector<Vector3> axes{&GetFrameArena()};
+	axes.reserve(colA.FaceCount() + boxAxes.size()
+				 + (edgeDirs.size() * boxAxes.size()));
+	for (uint32_t i{0}; i < colA.FaceCount(); i++)
+	{
+		axes.push_back(colA.GetFace(i).normal);
+	}
+	axes.insert(axes.end(), boxAxes.begin(), boxAxes.end());
+	for (const auto dir : edgeDirs)
+	{
+		for (const auto axis : boxAxes)
+		{
+			axes.push_back(Vector3CrossProduct(dir, axis));
+		}
+	}
+	return CheckSupportAxes(colA, colB, axes);
+}
+auto CheckBoxBox(const BoxCollider& colA, const BoxCollider& colB)
+	-> optional<ContactHit>
+{
+	const auto& axesA = colA.GetAxes();
+	const auto& axesB = colB.GetAxes();
+	const Vector3 halfA{colA.GetHalfExtents()};
+	const Vector3 halfB{colB.GetHalfExtents()};
+	const Vector3 offset{colB.GetOrigin() - colA.GetOrigin()};
+	const auto radius
+		= [](const std::array<Vector3, 3>& axes, const Vector3 half,
+			 const Vector3 axis) -> float
+	{
+		return (half.x * std::fabs(Vector3DotProduct(axes[0], axis)))
+			   + (half.y * std::fabs(Vector3DotProduct(axes[1], axis)))
+			   + (half.z * std::fabs(Vector3DotProduct(axes[2], axis)));
+	};
+
+	ContactHit hit{.penetration = std::numeric_limits<float>::max()};
+	// false if axis separates the boxes
+	const auto testAxis = [&hit, &radius, &axesA, &axesB, halfA, halfB,
+						   offset](const Vector3 axis, const float bias) -> bool
+	{
+		const float lengthSqr{Vector3DotProduct(axis, axis)};
+		// Crosses of parallel edges add nothing over the face axes
+		if (lengthSqr <= 1e-10f)
+			return true;
+		const Vector3 nor{axis / std::sqrt(lengthSqr)};
+		const float dist{Vector3DotProduct(offset, nor)};
+		const float penetration{radius(axesA, halfA, nor)
+								+ radius(axesB, halfB, nor) - std::fabs(dist)};
+		if (penetration <= 0.0f)
+			return false;
+		if (penetration * bias < hit.penetration)
+		{
+			hit.penetration = penetration;
+			hit.normal = dist >= 0.0f ? nor : -nor;
+		}
+		return true;
+	};
+
+	for (uint32_t i{0}; i < 3; i++)
+	{
+		if (!testAxis(axesA[i], 1.0f) || !testAxis(axesB[i], 1.0f))
+			return std::nullopt;
+	}
+	for (const auto axisA : axesA)
+	{
+		for (const auto axisB : axesB)
+		{
+			if (!testAxis(Vector3CrossProduct(axisA, axisB),
+						  1.0f / EDGE_AXIS_BIAS))
+				return std::nullopt;
+		}
+	}
+	hit.point = colB.GetSupportPoint(-hit.normal)
+				+ (hit.normal * (hit.penetration * 0.5f));
+	return hit;
+}
+
+auto CheckTriangleSphere(const MeshTriangle& tri, const SphereCollider& col)
+	-> optional<ContactHit>
+{
+	const Vector3 centre{col.GetOrigin()};
+	const auto hit{CheckRoundedPolytope(col, centre, centre, tri, {})};
+	if (!hit.has_value())
+		return std::nullopt;
+	return SnapInternalFeature(tri, col,
+							   {.normal = -hit->normal,
+								.penetration = hit->penetration,
+								.point = hit->point});
+}
+auto CheckTriangleCapsule(const MeshTriangle& tri, const CapsuleCollider& col)
+	-> optional<ContactHit>
+{
+	const std::array<Vector3, 3> edges{tri.verts[1] - tri.verts[0],
+									   tri.verts[2] - tri.verts[1],
+									   tri.verts[0] - tri.verts[2]};
+	const auto axes{GetCapsuleAxes(col, edges)};
+	const auto hit{
+		CheckRoundedPolytope(col, col.GetStart(), col.GetEnd(), tri, axes)};
+	if (!hit.has_value())
+		return std::nullopt;
+	return SnapInternalFeature(tri, col,
+							   {.normal = -hit->normal,
+								.penetration = hit->penetration,
+								.point = hit->point});
+}
+auto CheckTriangleBox(const MeshTriangle& tri, const BoxCollider& col)
+	-> optional<ContactHit>
+{
+	auto axes{GetTriangleAxes(tri, col.GetAxes())};
+	axes.insert(axes.end(), col.GetAxes().begin(), col.GetAxes().end());
+	const auto hit{CheckSupportAxes(tri, col, axes)};
+	if (!hit.has_value())
+		return std::nullopt;
+	return SnapInternalFeature(tri, col, *hit);
+}
+auto CheckTriangleHull(const MeshTriangle& tri, const HullCollider& col)
+	-> optional<ContactHit>
+{
+	auto axes{GetTriangleAxes(tri, col.GetEdgeDirs())};
+	col.GetNormals(axes);
+	const auto hit{CheckSupportAxes(tri, col, axes)};
+	if (!hit.has_value())
+		return std::nullopt;
+	return SnapInternalFeature(tri, col, *hit);
+}
+
+auto RaycastPrimitive(const Ray ray, const Collider& col) -> optional<float>
+{
+	if (const auto* sphere = std::get_if<SphereCollider>(&col))
+		return RaycastSphere(ray, sphere->GetOrigin(), sphere->GetRadius());
+	if (const auto* capsule = std::get_if<CapsuleCollider>(&col))
+		return RaycastCapsule(ray, *capsule);
+	if (const auto* box = std::get_if<BoxCollider>(&col))
+		return RaycastBox(ray, *box);
+	if (const auto* mesh = std::get_if<TriangleMeshCollider>(&col))
+		return mesh->Raycast(ray);
+	if (const auto* heightfield = std::get_if<HeightfieldCollider>(&col))
+		return heightfield->Raycast(ray);
+	return std::nullopt;
+}
+auto GetLocalRay(const Ray ray, const Matrix& trans) -> Ray
+{
+	const Vector3 origin{ray.position * trans};
+	return {.position = origin,
+			.direction = ((ray.position + ray.direction) * trans) - origin};
+}
+auto GetInverseDir(const Vector3 dir) -> Vector3
+{
+	const auto invert = [](const float val) -> float
+	{
+		return std::fabs(val) > TINY ? 1.0f / val
+									 : std::numeric_limits<float>::max();
+	};
+	return {invert(dir.x), invert(dir.y), invert(dir.z)};
+}
+auto RaycastBounds(const Vector3 origin, const Vector3 invDir,
+				   const BoundingBox& box, const float maxDist)
+	-> optional<float>
+{
+	const Vector3 toMin{(box.min - origin) * invDir};
+	const Vector3 toMax{(box.max - origin) * invDir};
+	const Vector3 nearT{Vector3Min(toMin, toMax)};
+	const Vector3 farT{Vector3Max(toMin, toMax)};
+	const float enter{std::max({nearT.x, nearT.y, nearT.z, 0.0f})};
+	const float exit{std::min({farT.x, farT.y, farT.z, maxDist})};
+	if (enter > exit)
+		return std::nullopt;
+	return enter;
+}
+auto RaycastTriangle(const Ray ray, const std::array<Vector3, 3>& tri)
+	-> optional<float>
+{
+	const Vector3 edge1{tri[1] - tri[0]};
+	const Vector3 edge2{tri[2] - tri[0]};
+	const Vector3 perp{Vector3CrossProduct(ray.direction, edge2)};
+	// Negative for back faces, which are skipped, and 0 for parallel rays
+	const float det{Vector3DotProduct(edge1, perp)};
+	if (det <= TINY)
+		return std::nullopt;
+	const Vector3 offset{ray.position - tri[0]};
+	const float u{Vector3DotProduct(offset, perp) / det};
+	if (u < 0.0f || u > 1.0f)
+		return std::nullopt;
+	const Vector3 cross{Vector3CrossProduct(offset, edge1)};
+	const float v{Vector3DotProduct(ray.direction, cross) / det};
+	if (v < 0.0f || u + v > 1.0f)
+		return std::nullopt;
+	const float dist{Vector3DotProduct(edge2, cross) / det};
+	if (dist < 0.0f)
+		return std::nullopt;
+	return dist;
+}
+
+} //namespace phys
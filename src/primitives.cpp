@@ -0,0 +1,220 @@
+#include "collider.h"
+#include "debugDraw.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <raylib.h>
+#include <raymath.h>
+#include <vector>
+
+namespace phys
+{
+
+using std::vector;
+
+namespace
+{
+
+/** @returns dir transformed by the rotation and scale part of trans. */
+auto TransformDir(const Vector3 dir, const Matrix& trans) -> Vector3
+{
+	return (dir * trans) - Vector3{trans.m12, trans.m13, trans.m14};
+}
+/** @returns The largest factor trans scales any direction by. */
+auto GetMaxScale(const Matrix& trans) -> float
+{
+	return std::max({Vector3Length({trans.m0, trans.m1, trans.m2}),
+					 Vector3Length({trans.m4, trans.m5, trans.m6}),
+					 Vector3Length({trans.m8, trans.m9, trans.m10})});
+}
+/**
+ * @brief Builds a box from the vectors running from its centre to the middle
+ *        of three of its faces. Sheared inputs are squared back up, keeping
+ *        the first axis exact.
+ */
+auto MakeBox(const Vector3 centre, const std::array<Vector3, 3>& halfAxes)
+	-> BoxCollider
+{
+	const Vector3 extents{Vector3Length(halfAxes[0]),
+						  Vector3Length(halfAxes[1]),
+						  Vector3Length(halfAxes[2])};
+	std::array<Vector3, 3> axes{};
+	axes[0] = Vector3Normalize(halfAxes[0]);
+	axes[1] = Vector3Normalize(
+		halfAxes[1]
+		- (axes[0] * Vector3DotProduct(halfAxes[1], axes[0])));
+	axes[2] = Vector3CrossProduct(axes[0], axes[1]);
+	if (Vector3DotProduct(axes[2], halfAxes[2]) < 0)
+	{
+		axes[2] = Vector3Negate(axes[2]);
+	}
+	return {centre, axes, extents};
+}
+
+} //namespace
+
+SphereCollider::SphereCollider(const Vector3 centre, const float radius) :
+	centre(centre), radius(radius)
+{ }
+void SphereCollider::GetTransformed(const Matrix trans,
+									std::pmr::vector<Collider>& out) const
+{
+	out.emplace_back(std::in_place_type<SphereCollider>, this->centre * trans,
+					 this->radius * GetMaxScale(trans));
+}
+auto SphereCollider::GetSupportPoint(const Vector3 axis) const -> Vector3
+{
+	return this->centre + (Vector3Normalize(axis) * this->radius);
+}
+auto SphereCollider::GetBounds() const -> BoundingBox
+{
+	const Vector3 extents{this->radius, this->radius, this->radius};
+	return {.min = this->centre - extents, .max = this->centre + extents};
+}
+void SphereCollider::DebugDraw(const Matrix& transform, const Color& col) const
+{
+	DebugSphere(DEBUG_HULLS, this->centre * transform,
+				this->radius * GetMaxScale(transform), col);
+}
+
+CapsuleCollider::CapsuleCollider(const Vector3 start, const Vector3 end,
+								 const float radius) :
+	start(start), end(end), radius(radius)
+{ }
+void CapsuleCollider::GetTransformed(const Matrix trans,
+									 std::pmr::vector<Collider>& out) const
+{
+	out.emplace_back(std::in_place_type<CapsuleCollider>, this->start * trans,
+					 this->end * trans, this->radius * GetMaxScale(trans));
+}
+auto CapsuleCollider::GetSupportPoint(const Vector3 axis) const -> Vector3
+{
+	const Vector3 tip{
+		Vector3DotProduct(axis, this->end - this->start) >= 0 ? this->end
+															  : this->start};
+	return tip + (Vector3Normalize(axis) * this->radius);
+}
+auto CapsuleCollider::GetBounds() const -> BoundingBox
+{
+	const Vector3 extents{this->radius, this->radius, this->radius};
+	return {
+		.min = Vector3Min(this->start, this->end) - extents,
+		.max = Vector3Max(this->start, this->end) + extents,
+	};
+}
+void CapsuleCollider::DebugDraw(const Matrix& transform,
+								const Color& col) const
+{
+	if (!IsDebugDrawEnabled(DEBUG_HULLS))
+		return;
+	const Vector3 start{this->start * transform};
+	const Vector3 end{this->end * transform};
+	const float radius{this->radius * GetMaxScale(transform)};
+	DebugSphere(DEBUG_HULLS, start, radius, col);
+	DebugSphere(DEBUG_HULLS, end, radius, col);
+	// Join the end caps along two directions perpendicular to the axis
+	const Vector3 axis{Vector3Normalize(end - start)};
+	const Vector3 helper{std::abs(axis.y) < 0.9f ? Vector3{0.0f, 1.0f, 0.0f}
+												 : Vector3{1.0f, 0.0f, 0.0f}};
+	const Vector3 side1{Vector3Normalize(Vector3CrossProduct(axis, helper))};
+	const Vector3 side2{Vector3CrossProduct(axis, side1)};
+	for (const Vector3 side :
+		 {side1, Vector3Negate(side1), side2, Vector3Negate(side2)})
+	{
+		DebugLine(DEBUG_HULLS, start + (side * radius), end + (side * radius),
+				  col);
+	}
+}
+
+BoxCollider::BoxCollider(const Vector3 centre,
+						 const std::array<Vector3, 3>& axes,
+						 const Vector3 halfExtents) :
+	centre(centre), axes(axes), halfExtents(halfExtents)
+{ }
+void BoxCollider::GetTransformed(const Matrix trans,
+								 std::pmr::vector<Collider>& out) const
+{
+	out.emplace_back(
+		MakeBox(this->centre * trans,
+				{
+					TransformDir(this->axes[0] * this->halfExtents.x, trans),
+					TransformDir(this->axes[1] * this->halfExtents.y, trans),
+					TransformDir(this->axes[2] * this->halfExtents.z, trans),
+				}));
+}
+void BoxCollider::GetNormals(std::pmr::vector<Vector3>& out) const
+{
+	for (const auto axis : this->axes)
+	{
+		out.push_back(axis);
+		out.push_back(Vector3Negate(axis));
+	}
+}
+auto BoxCollider::GetSupportPoint(const Vector3 axis) const -> Vector3
+{
+	const std::array<float, 3> extents{
+		this->halfExtents.x, this->halfExtents.y, this->halfExtents.z};
+	Vector3 support{this->centre};
+	for (uint32_t i{0}; i < 3; i++)
+	{
+		const float sign{
+			Vector3DotProduct(axis, this->axes[i]) >= 0 ? 1.0f : -1.0f};
+		support = support + (this->axes[i] * (extents[i] * sign));
+	}
+	return support;
+}
+auto BoxCollider::GetBounds() const -> BoundingBox
+{
+	const auto reach = [](const Vector3 axis) -> Vector3
+	{
+		return Vector3{std::fabs(axis.x), std::fabs(axis.y), std::fabs(axis.z)};
+	};
+	const Vector3 extents{reach(this->axes[0]) * this->halfExtents.x
+						  + reach(this->axes[1]) * this->halfExtents.y
+						  + reach(this->axes[2]) * this->halfExtents.z};
+	return {.min = this->centre - extents, .max = this->centre + extents};
+}
+void BoxCollider::DebugDraw(const Matrix& transform, const Color& col) const
+{
+	if (!IsDebugDrawEnabled(DEBUG_HULLS))
+		return;
+	const std::array<float, 3> extents{
+		this->halfExtents.x, this->halfExtents.y, this->halfExtents.z};
+	std::array<Vector3, 8> corners{};
+	for (uint32_t i{0}; i < corners.size(); i++)
+	{
+		Vector3 corner{this->centre};
+		for (uint32_t axis{0}; axis < 3; axis++)
+		{
+			const float sign{(i & (1U << axis)) != 0 ? 1.0f : -1.0f};
+			corner = corner + (this->axes[axis] * (extents[axis] * sign));
+		}
+		corners[i] = corner * transform;
+	}
+	// Corners one bit apart share an edge
+	for (uint32_t i{0}; i < corners.size(); i++)
+	{
+		for (const uint32_t bit : {1U, 2U, 4U})
+		{
+			if ((i & bit) == 0)
+			{
+				DebugLine(DEBUG_HULLS, corners[i], corners[i | bit], col);
+			}
+		}
+	}
+	DebugPoint(DEBUG_HULLS, this->centre * transform, 0.05f, col);
+}
+
+auto CreateOBBCollider(Matrix transform) -> Collider
+{
+	const Vector3 centre{Vector3Zero() * transform};
+	return MakeBox(centre, {
+							   TransformDir({0.5f, 0.0f, 0.0f}, transform),
+							   TransformDir({0.0f, 0.5f, 0.0f}, transform),
+							   TransformDir({0.0f, 0.0f, 0.5f}, transform),
+						   });
+}
+
+} //namespace phys
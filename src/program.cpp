@@ -1,28 +1,38 @@
 #include "program.h"
+#include "bodyStorage.h"
 #include "collider.h"
+#include "colliderCache.h"
+#include "contactEvents.h"
+#include "debugDraw.h"
+#include "eventLog.h"
+#include "frameArena.h"
+#include "integrate.h"
 #include "physObject.h"
+#include "renderCache.h"
 #include "utils.h"
+#include "world.h"
 
 #include <cassert>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <imgui.h>
-#include <iostream>
 #include <numbers>
 #include <optional>
 #include <raylib.h>
 #include <raymath.h>
 #include <rlImGui.h>
+#include <utility>
+#include <vector>
 
 namespace phys
 {
 
 Program::Program() : deltaTime(NAN), cam({}), imguiIO(&ImGui::GetIO())
 {
-	SetTextColor(INFO);
-	std::cout << "Initializing Program\n";
-	ClearStyles();
+	Log<LogLevel::INFO>("Initializing program");
+	// The SIMD integrator must agree with the scalar one it replaces
+	assert(CheckIntegrateKernels());
 	using namespace std::numbers;
 	this->cam = Camera(
 		{.position = Vector3RotateByAxisAngle(
@@ -34,20 +44,21 @@ Program::Program() : deltaTime(NAN), cam({}), imguiIO(&ImGui::GetIO())
 		 .fovy = 45.0f,
 		 .projection = 0});
 
-	this->objects.push_back(
-		CreateBoxObject({2.0f, 0.2f, -0.5f}, {1.0f, 1.0f, 1.0f}));
+	this->world.SetGravity({0.0f, -1.0f, 0.0f});
+	CreateBoxObject(this->world.GetBodies(), {2.0f, 0.2f, -0.5f},
+					{1.0f, 1.0f, 1.0f})
+		.SetBodyType(BodyType::KINEMATIC);
 	//CreateBoxObject({2.0f, 0.0f, 0.5f}, {1.0f, 1.0f, 1.0f}));
 	//this->objects[0].Rotate(QuaternionFromEuler(0.0f, 45.0f * DEG2RAD, 0.0f));
 	//this->objects.push_back(
 	//	CreateBoxObject({2.0f, 0.0f, 0.5f}, {1.0f, 1.0f, 1.0f}));
 	this->DebugAddStairObj({2.0f, 0.0f, 0.5f});
+	this->DebugAddTerrainObj({-12.0f, -1.5f, -12.0f});
 	//this->objects[1].Rotate(
 	//	QuaternionFromAxisAngle({0.0f, 1.0f, 0.0f}, 45.0f * DEG2RAD));
 	//this->objects[1].Rotate(
 	//	QuaternionFromAxisAngle({1.0f, 0.0f, 0.0f}, -35.0f * DEG2RAD));
-	SetTextColor(INFO);
-	std::cout << "Done Initializing\n";
-	ClearStyles();
+	Log<LogLevel::INFO>("Done initializing");
 
 	imguiIO->ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
 }
@@ -55,6 +66,8 @@ Program::Program() : deltaTime(NAN), cam({}), imguiIO(&ImGui::GetIO())
 void Program::Update()
 {
 	this->deltaTime = GetFrameTime();
+	// Scratch memory from the last step is no longer referenced
+	GetFrameArena().Reset();
 	BeginDrawing();
 	rlImGuiBegin();
 
@@ -62,26 +75,22 @@ void Program::Update()
 	BeginMode3D(cam);
 	//objects[1].Rotate(
 	//	QuaternionFromAxisAngle({1.0f, 0.0f, 0.0f}, 1.0f * deltaTime));
-	for (auto& obj : this->objects)
+	for (const BodyHandle handle : this->world.GetBodies().GetHandles())
 	{
-		obj.Update();
+		PhysObject{this->world.GetBodies(), handle}.SelectColliderLOD(
+			this->cam.position);
 	}
-	for (uint32_t i{0}; i < this->objects.size(); i++)
+	this->world.Step(this->deltaTime, &this->jobs);
+	this->world.GetBodies().DebugDrawBounds();
+	for (const ContactEvent& event : this->world.GetContacts().GetEvents())
 	{
-		const auto& obj1 = this->objects[i];
-		for (uint32_t j{i + 1}; j < this->objects.size(); j++)
+		if (event.type == ContactEventType::BEGIN)
 		{
-			if (i == j)
-				continue;
-			const auto& obj2 = this->objects[j];
-			std::optional<HitObj> col = CheckCollision(obj1, obj2);
-			if (col.has_value())
-			{
-				col.value();
-			}
-			else
-			{
-			}
+			Log<LogLevel::DEBUG>("Contact began, depth", event.depth);
+		}
+		else if (event.type == ContactEventType::END)
+		{
+			Log<LogLevel::DEBUG>("Contact ended");
 		}
 	}
 	this->ProcessInput();
@@ -91,17 +100,19 @@ void Program::Update()
 	//ClearBackground({100, 149, 237, 255});
 	//BeginMode3D(cam);
 	DrawGrid(2.5f, 2);
-	for (const auto& obj : this->objects)
-	{
-		obj.Draw();
-	}
+	this->world.GetBodies().Draw();
+	SubmitDebugDraw();
 	EndMode3D();
 
 	bool open = true;
 	//open = selectedObj != nullptr;
 	ImGuiWindowFlags flags
 		= ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_AlwaysAutoResize;
-	if (selectedObj != nullptr)
+	if (selectedObj.has_value() && !selectedObj->IsValid())
+	{
+		selectedObj.reset();
+	}
+	if (selectedObj.has_value())
 	{
 		if (ImGui::Begin("Selected Object", &open, flags))
 		{
@@ -122,13 +133,42 @@ void Program::Update()
 		ImGui::End();
 	}
 
+#ifdef PHYS_DEBUG_DRAW
+	if (ImGui::Begin("Debug Draw", nullptr, flags))
+	{
+		uint32_t categories{GetDebugDrawCategories()};
+		ImGui::CheckboxFlags("Contacts", &categories, DEBUG_CONTACTS);
+		ImGui::CheckboxFlags("Normals", &categories, DEBUG_NORMALS);
+		ImGui::CheckboxFlags("Hulls", &categories, DEBUG_HULLS);
+		ImGui::CheckboxFlags("Bounds", &categories, DEBUG_AABBS);
+		SetDebugDrawCategories(static_cast<DebugCategory>(categories));
+	}
+	ImGui::End();
+#endif // PHYS_DEBUG_DRAW
+
 	DrawFPS(0, 0);
+	const ArenaStats& scratch{GetFrameArena().GetLastStats()};
+	DrawText(TextFormat("Scratch: %u allocations, %u KiB, %u heap blocks",
+						scratch.allocations,
+						static_cast<uint32_t>(scratch.bytes / 1024),
+						scratch.blockAllocations),
+			 0, 20, 20, DARKGREEN);
+	DrawText(TextFormat("Draw calls: %u, %u unique meshes",
+						this->world.GetBodies().GetDrawCalls(),
+						GetRenderCache().GetMeshCount()),
+			 0, 40, 20, DARKGREEN);
 
 	rlImGuiEnd();
 	EndDrawing();
 }
 void Program::ProcessInput()
 {
+	if (!imguiIO->WantCaptureKeyboard && IsKeyPressed(KEY_DELETE)
+		&& selectedObj.has_value())
+	{
+		this->world.GetBodies().Remove(selectedObj->GetHandle());
+		selectedObj.reset();
+	}
 	if (!imguiIO->WantCaptureMouse)
 	{
 		if (IsMouseButtonDown(MOUSE_BUTTON_LEFT))
@@ -166,12 +206,13 @@ void Program::ProcessInput()
 		}
 		if (IsMouseButtonDown(MOUSE_BUTTON_RIGHT))
 		{
-			selectedObj = nullptr;
+			selectedObj.reset();
 			float dist = std::numeric_limits<float>::max();
-			for (auto& obj : this->objects)
+			for (const BodyHandle handle : this->world.GetBodies().GetHandles())
 			{
 				auto hit = CheckRaycast(
-					GetScreenToWorldRay(GetMousePosition(), this->cam), obj);
+					GetScreenToWorldRay(GetMousePosition(), this->cam),
+					{this->world.GetBodies(), handle});
 				if (hit.has_value())
 				{
 					DrawSphere(hit->hitPos, 0.025f, GREEN);
@@ -232,21 +273,42 @@ void Program::DebugAddStairObj(Vector3 pos)
 	mesh.indices = nullptr;
 	UnloadModel(model);
 
-	auto col = CompoundCollider({
-		CreateBoxCollider(MatrixScale(1.0f, 1.0f, 0.5f)
-						  * MatrixTranslate(0.0f, 0.0f, 0.25f)),
-		CreateBoxCollider(MatrixScale(1.0f, 0.5f, 0.5f)
-						  * MatrixTranslate(0.0f, -0.25f, -0.25f)),
-	});
+	const Collider col = LoadCachedCollider(
+		RESOURCES_PATH "stairs.phc", GetCookKey(mesh, "CreateMeshCollider"),
+		[&mesh]() -> Collider { return CreateMeshCollider(mesh); });
+#if defined(PLATFORM_WEB)
+	PhysObject(this->world.GetBodies(), {0.0f, 0.0f, 0.5f},
+			   GetRenderCache().AddMesh(mesh), col,
+			   RESOURCES_PATH "shaders/litShader_web.vert",
+			   RESOURCES_PATH "shaders/litShader_web.frag")
+		.SetBodyType(BodyType::STATIC);
+#else
+	PhysObject(this->world.GetBodies(), pos, GetRenderCache().AddMesh(mesh),
+			   col, RESOURCES_PATH "shaders/litShader.vert",
+			   RESOURCES_PATH "shaders/litShader.frag")
+		.SetBodyType(BodyType::STATIC);
+#endif // defined ()
+}
+
+// HACK: As above, until levels are loaded from files.
+void Program::DebugAddTerrainObj(Vector3 pos)
+{
+	constexpr int SAMPLES{64};
+	constexpr Vector3 SIZE{24.0f, 1.0f, 24.0f};
+	const Image heightmap{GenImagePerlinNoise(SAMPLES, SAMPLES, 0, 0, 4.0f)};
+	const Mesh mesh{GenMeshHeightmap(heightmap, SIZE)};
+	const Collider col{CreateHeightfieldCollider(heightmap, SIZE)};
+	UnloadImage(heightmap);
 #if defined(PLATFORM_WEB)
-	this->objects.emplace_back(PhysObject(
-		{0.0f, 0.0f, 0.5f}, mesh, std::dynamic_pointer_cast<Collider>(col),
-		RESOURCES_PATH "shaders/litShader_web.vert",
-		RESOURCES_PATH "shaders/litShader_web.frag"));
+	PhysObject(this->world.GetBodies(), pos, GetRenderCache().AddMesh(mesh),
+			   col, RESOURCES_PATH "shaders/litShader_web.vert",
+			   RESOURCES_PATH "shaders/litShader_web.frag")
+		.SetBodyType(BodyType::STATIC);
 #else
-	this->objects.emplace_back(pos, mesh, col,
-							   RESOURCES_PATH "shaders/litShader.vert",
-							   RESOURCES_PATH "shaders/litShader.frag");
+	PhysObject(this->world.GetBodies(), pos, GetRenderCache().AddMesh(mesh),
+			   col, RESOURCES_PATH "shaders/litShader.vert",
+			   RESOURCES_PATH "shaders/litShader.frag")
+		.SetBodyType(BodyType::STATIC);
 #endif // defined ()
 }
 
@@ -0,0 +1,710 @@
+#include "quickhull.h"
+#include "collider.h"
+#include "halfEdge.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <ranges>
+#include <raylib.h>
+#include <raymath.h>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace phys
+{
+
+namespace
+{
+
+constexpr uint32_t NONE{std::numeric_limits<uint32_t>::max()};
+
+/**
+ * @brief Triangle of a hull under construction. Vertices are wound counter
+ *        clockwise when seen from outside, and adj[i] is the face across the
+ *        edge verts[i] -> verts[i + 1].
+ */
+struct QHFace
+{
+	std::array<uint32_t, 3> verts{};
+	std::array<uint32_t, 3> adj{NONE, NONE, NONE};
+	Vector3 normal{};
+	float offset{0.0f};
+	float area{0.0f};
+
+	// Head of this face's outside set, linked through QuickHull::nextOutside
+	uint32_t outside{NONE};
+	uint32_t furthest{NONE};
+	float furthestDist{0.0f};
+
+	uint32_t visited{0};
+	bool alive{true};
+
+	auto Distance(const Vector3 point) const -> float
+	{
+		return Vector3DotProduct(this->normal, point) - this->offset;
+	}
+};
+
+/**
+ * @brief Incremental quickhull over a welded point cloud. Faces swallowed by
+ *        a new point are marked dead and their slots are recycled.
+ */
+class QuickHull
+{
+	public:
+	QuickHull(std::span<const Vector3> points, const float epsilon) :
+		points(points), epsilon(epsilon), nextOutside(points.size(), NONE)
+	{ }
+
+	auto Build(const uint32_t maxVertices) -> bool;
+	void Extract(vector<HE::HVertex>& vertsOut, vector<HE::FaceInit>& facesOut,
+				 const float mergeAngle, const float mergeDistance) const;
+
+	private:
+	auto AddFace(const uint32_t a, const uint32_t b, const uint32_t c)
+		-> uint32_t;
+	auto BuildSimplex() -> bool;
+	void AssignPoint(const uint32_t point, std::span<const uint32_t> candidates);
+	void AddPoint(const uint32_t faceID);
+	void ComputeHorizon(const uint32_t faceID, const Vector3 eye);
+
+	std::span<const Vector3> points;
+	float epsilon;
+	vector<QHFace> faces;
+	vector<uint32_t> freeFaces;
+	// Faces that have been given outside points since they were created
+	vector<uint32_t> pending;
+	vector<uint32_t> nextOutside;
+
+	struct Frame
+	{
+		uint32_t face;
+		uint32_t edge;
+		uint32_t remaining;
+	};
+	// Scratch buffers reused by every AddPoint call
+	vector<Frame> stack;
+	vector<std::pair<uint32_t, uint32_t>> horizon;
+	vector<uint32_t> visible;
+	vector<uint32_t> newFaces;
+	vector<uint32_t> orphans;
+	uint32_t stamp{0};
+};
+
+auto QuickHull::AddFace(const uint32_t a, const uint32_t b, const uint32_t c)
+	-> uint32_t
+{
+	QHFace face{};
+	face.verts = {a, b, c};
+	Vector3 cross{Vector3CrossProduct(this->points[b] - this->points[a],
+									  this->points[c] - this->points[a])};
+	face.area = Vector3Length(cross) * 0.5f;
+	face.normal = Vector3Normalize(cross);
+	face.offset = Vector3DotProduct(face.normal, this->points[a]);
+	if (!this->freeFaces.empty())
+	{
+		const uint32_t id{this->freeFaces.back()};
+		this->freeFaces.pop_back();
+		this->faces[id] = face;
+		return id;
+	}
+	this->faces.push_back(face);
+	return static_cast<uint32_t>(this->faces.size() - 1);
+}
+auto QuickHull::BuildSimplex() -> bool
+{
+	std::array<uint32_t, 3> minIDs{0, 0, 0};
+	std::array<uint32_t, 3> maxIDs{0, 0, 0};
+	auto axis = [](const Vector3 vec, const uint64_t i) -> float
+	{
+		return i == 0 ? vec.x : (i == 1 ? vec.y : vec.z);
+	};
+	for (uint32_t i{0}; i < this->points.size(); i++)
+	{
+		for (uint64_t k{0}; k < 3; k++)
+		{
+			if (axis(this->points[i], k) < axis(this->points[minIDs[k]], k))
+				minIDs[k] = i;
+			if (axis(this->points[i], k) > axis(this->points[maxIDs[k]], k))
+				maxIDs[k] = i;
+		}
+	}
+
+	// The most distant pair of axis extremes seeds the first edge
+	uint32_t v0{0};
+	uint32_t v1{0};
+	float dist{-1.0f};
+	for (uint64_t k{0}; k < 3; k++)
+	{
+		float newDist{Vector3Distance(this->points[minIDs[k]],
+									  this->points[maxIDs[k]])};
+		if (newDist > dist)
+		{
+			dist = newDist;
+			v0 = minIDs[k];
+			v1 = maxIDs[k];
+		}
+	}
+	if (dist <= this->epsilon)
+		return false;
+
+	const Vector3 lineDir{
+		Vector3Normalize(this->points[v1] - this->points[v0])};
+	uint32_t v2{0};
+	dist = -1.0f;
+	for (uint32_t i{0}; i < this->points.size(); i++)
+	{
+		float newDist{Vector3Length(
+			Vector3CrossProduct(this->points[i] - this->points[v0], lineDir))};
+		if (newDist > dist)
+		{
+			dist = newDist;
+			v2 = i;
+		}
+	}
+	if (dist <= this->epsilon)
+		return false;
+
+	const Vector3 planeNor{Vector3Normalize(
+		Vector3CrossProduct(this->points[v1] - this->points[v0],
+							this->points[v2] - this->points[v0]))};
+	uint32_t v3{0};
+	dist = -1.0f;
+	float signedDist{0.0f};
+	for (uint32_t i{0}; i < this->points.size(); i++)
+	{
+		float newDist{
+			Vector3DotProduct(this->points[i] - this->points[v0], planeNor)};
+		if (std::abs(newDist) > dist)
+		{
+			dist = std::abs(newDist);
+			signedDist = newDist;
+			v3 = i;
+		}
+	}
+	if (dist <= this->epsilon)
+		return false;
+
+	// The base triangle has to face away from the apex
+	if (signedDist > 0)
+		std::swap(v1, v2);
+
+	std::array<uint32_t, 4> simplex{
+		this->AddFace(v0, v1, v2),
+		this->AddFace(v0, v3, v1),
+		this->AddFace(v1, v3, v2),
+		this->AddFace(v2, v3, v0),
+	};
+	for (auto& face : this->faces)
+	{
+		for (uint64_t i{0}; i < 3; i++)
+		{
+			uint32_t from{face.verts[i]};
+			uint32_t to{face.verts[(i + 1) % 3]};
+			for (const uint32_t other : simplex)
+			{
+				const auto& verts = this->faces[other].verts;
+				for (uint64_t j{0}; j < 3; j++)
+				{
+					if (verts[j] == to && verts[(j + 1) % 3] == from)
+						face.adj[i] = other;
+				}
+			}
+		}
+	}
+
+	for (uint32_t i{0}; i < this->points.size(); i++)
+	{
+		if (i == v0 || i == v1 || i == v2 || i == v3)
+			continue;
+		this->AssignPoint(i, simplex);
+	}
+	return true;
+}
+void QuickHull::AssignPoint(const uint32_t point,
+							std::span<const uint32_t> candidates)
+{
+	uint32_t best{NONE};
+	float bestDist{this->epsilon};
+	for (const uint32_t faceID : candidates)
+	{
+		float dist{this->faces[faceID].Distance(this->points[point])};
+		if (dist > bestDist)
+		{
+			bestDist = dist;
+			best = faceID;
+		}
+	}
+	// Points that aren't outside any face are inside the hull for good
+	if (best == NONE)
+		return;
+
+	auto& face = this->faces[best];
+	if (face.outside == NONE)
+		this->pending.push_back(best);
+	this->nextOutside[point] = face.outside;
+	face.outside = point;
+	if (bestDist > face.furthestDist)
+	{
+		face.furthestDist = bestDist;
+		face.furthest = point;
+	}
+}
+void QuickHull::ComputeHorizon(const uint32_t faceID, const Vector3 eye)
+{
+	// Depth first walk over the faces visible from the eye point. Walking each
+	// face's edges starting after the one it was entered through yields the
+	// horizon as a closed, counter clockwise loop.
+	auto& stack = this->stack;
+	stack.assign(1, {.face = faceID, .edge = 0, .remaining = 3});
+	this->faces[faceID].visited = this->stamp;
+	this->visible.push_back(faceID);
+	while (!stack.empty())
+	{
+		Frame& top = stack.back();
+		if (top.remaining == 0)
+		{
+			stack.pop_back();
+			continue;
+		}
+		const uint32_t current{top.face};
+		const uint32_t edge{top.edge};
+		top.edge = (top.edge + 1) % 3;
+		top.remaining--;
+
+		const uint32_t other{this->faces[current].adj[edge]};
+		if (this->faces[other].visited == this->stamp)
+			continue;
+		if (this->faces[other].Distance(eye) > this->epsilon)
+		{
+			uint32_t entry{0};
+			while (this->faces[other].adj[entry] != current)
+			{
+				entry++;
+			}
+			this->faces[other].visited = this->stamp;
+			this->visible.push_back(other);
+			stack.push_back(
+				{.face = other, .edge = (entry + 1) % 3, .remaining = 2});
+		}
+		else
+		{
+			this->horizon.emplace_back(current, edge);
+		}
+	}
+}
+void QuickHull::AddPoint(const uint32_t faceID)
+{
+	const uint32_t eyeID{this->faces[faceID].furthest};
+	const Vector3 eye{this->points[eyeID]};
+
+	this->stamp++;
+	this->horizon.clear();
+	this->visible.clear();
+	this->ComputeHorizon(faceID, eye);
+
+	this->orphans.clear();
+	for (const uint32_t id : this->visible)
+	{
+		auto& face = this->faces[id];
+		for (uint32_t point{face.outside}; point != NONE;
+			 point = this->nextOutside[point])
+		{
+			if (point != eyeID)
+				this->orphans.push_back(point);
+		}
+		face.outside = NONE;
+		face.alive = false;
+	}
+
+	this->newFaces.clear();
+	for (const auto& [oldID, edge] : this->horizon)
+	{
+		const uint32_t from{this->faces[oldID].verts[edge]};
+		const uint32_t to{this->faces[oldID].verts[(edge + 1) % 3]};
+		const uint32_t across{this->faces[oldID].adj[edge]};
+
+		const uint32_t newID{this->AddFace(from, to, eyeID)};
+		this->faces[newID].adj[0] = across;
+		for (auto& adj : this->faces[across].adj)
+		{
+			if (adj == oldID)
+				adj = newID;
+		}
+		this->newFaces.push_back(newID);
+	}
+	const uint64_t count{this->newFaces.size()};
+	for (uint64_t i{0}; i < count; i++)
+	{
+		auto& face = this->faces[this->newFaces[i]];
+		face.adj[1] = this->newFaces[(i + 1) % count];
+		face.adj[2] = this->newFaces[(i + count - 1) % count];
+		assert(face.verts[1]
+			   == this->faces[this->newFaces[(i + 1) % count]].verts[0]);
+	}
+
+	// Dead faces are only recycled once every new face has been linked, as
+	// the horizon still refers to them until then
+	this->freeFaces.insert(this->freeFaces.end(), this->visible.begin(),
+						   this->visible.end());
+
+	for (const uint32_t point : this->orphans)
+	{
+		this->AssignPoint(point, this->newFaces);
+	}
+}
+auto QuickHull::Build(const uint32_t maxVertices) -> bool
+{
+	if (this->points.size() < 4 || !this->BuildSimplex())
+		return false;
+
+	if (maxVertices != 0)
+	{
+		// With a budget the globally furthest point always goes next, so
+		// stopping early leaves the best approximation for the vertex count
+		for (uint32_t count{4}; count < maxVertices; count++)
+		{
+			uint32_t best{NONE};
+			for (uint32_t i{0}; i < this->faces.size(); i++)
+			{
+				const auto& face = this->faces[i];
+				if (face.alive && face.outside != NONE
+					&& (best == NONE
+						|| face.furthestDist > this->faces[best].furthestDist))
+					best = i;
+			}
+			if (best == NONE)
+				break;
+			this->AddPoint(best);
+		}
+		return true;
+	}
+
+	// A pending face may have died, or been recycled, since it was queued
+	while (!this->pending.empty())
+	{
+		const uint32_t id{this->pending.back()};
+		this->pending.pop_back();
+		if (this->faces[id].alive && this->faces[id].outside != NONE)
+			this->AddPoint(id);
+	}
+	return true;
+}
+void QuickHull::Extract(vector<HE::HVertex>& vertsOut,
+						vector<HE::FaceInit>& facesOut, const float mergeAngle,
+						const float mergeDistance) const
+{
+	vector<uint32_t> alive;
+	for (uint32_t i{0}; i < this->faces.size(); i++)
+	{
+		if (this->faces[i].alive)
+			alive.push_back(i);
+	}
+	// Large triangles make the most reliable reference planes, so they seed
+	// the coplanar groups
+	std::ranges::sort(alive, std::greater{},
+					  [this](const uint32_t id) -> float
+					  { return this->faces[id].area; });
+
+	const float minDot{std::cos(mergeAngle)};
+	const float maxSin{std::sin(mergeAngle)};
+	auto isCoplanar = [this, minDot, mergeDistance](const QHFace& face,
+													const QHFace& seed) -> bool
+	{
+		if (Vector3DotProduct(face.normal, seed.normal) < minDot)
+			return false;
+		return std::ranges::all_of(
+			face.verts,
+			[this, &seed, mergeDistance](const uint32_t vert) -> bool
+			{ return std::abs(seed.Distance(this->points[vert])) <= mergeDistance; });
+	};
+
+	vector<uint32_t> group(this->faces.size(), NONE);
+	vector<vector<uint32_t>> loops;
+	vector<Vector3> normals;
+	vector<uint32_t> members;
+	// Next vertex along the outline of the group being built
+	vector<uint32_t> outline(this->points.size(), NONE);
+	vector<uint32_t> touched;
+	for (const uint32_t seed : alive)
+	{
+		if (group[seed] != NONE)
+			continue;
+
+		// Flood fill across neighbours that are coplanar with the seed
+		const auto groupID{static_cast<uint32_t>(loops.size())};
+		members.assign(1, seed);
+		group[seed] = groupID;
+		for (uint64_t i{0}; i < members.size(); i++)
+		{
+			for (const uint32_t adj : this->faces[members[i]].adj)
+			{
+				if (group[adj] == NONE
+					&& isCoplanar(this->faces[adj], this->faces[seed]))
+				{
+					group[adj] = groupID;
+					members.push_back(adj);
+				}
+			}
+		}
+
+		// Chain the group's outer edges into a single polygon
+		touched.clear();
+		bool valid{true};
+		Vector3 normal{};
+		for (const uint32_t id : members)
+		{
+			const auto& face = this->faces[id];
+			normal = normal + (face.normal * face.area);
+			for (uint64_t i{0}; i < 3; i++)
+			{
+				if (group[face.adj[i]] == groupID)
+					continue;
+				const uint32_t from{face.verts[i]};
+				valid &= outline[from] == NONE;
+				outline[from] = face.verts[(i + 1) % 3];
+				touched.push_back(from);
+			}
+		}
+		vector<uint32_t> loop;
+		if (valid)
+		{
+			uint32_t current{touched.front()};
+			do
+			{
+				loop.push_back(current);
+				current = outline[current];
+				if (current == NONE || loop.size() > touched.size())
+				{
+					valid = false;
+					break;
+				}
+			} while (current != loop.front());
+			valid &= loop.size() == touched.size();
+		}
+		for (const uint32_t vert : touched)
+		{
+			outline[vert] = NONE;
+		}
+
+		normal = Vector3Normalize(normal);
+		// Near-coplanar triangles on a curved surface can form a concave
+		// outline, which would break clipping against the face
+		for (uint64_t i{0}; valid && i < loop.size(); i++)
+		{
+			const Vector3 pos{this->points[loop[i]]};
+			const Vector3 toPrev{
+				pos - this->points[loop[(i + loop.size() - 1) % loop.size()]]};
+			const Vector3 toNext{this->points[loop[(i + 1) % loop.size()]]
+								 - pos};
+			valid = Vector3DotProduct(Vector3CrossProduct(toPrev, toNext),
+									  normal)
+					>= -maxSin * Vector3Length(toPrev) * Vector3Length(toNext);
+		}
+
+		if (valid)
+		{
+			loops.push_back(std::move(loop));
+			normals.push_back(normal);
+			continue;
+		}
+		// A pinched or concave outline can't be represented as one polygon,
+		// so the group is emitted as its individual triangles instead
+		for (const uint32_t id : members)
+		{
+			group[id] = static_cast<uint32_t>(loops.size());
+			const auto& face = this->faces[id];
+			loops.emplace_back(face.verts.begin(), face.verts.end());
+			normals.push_back(face.normal);
+		}
+	}
+
+	// A vertex shared by only two polygons that sits on a straight line
+	// between its neighbours is left over from merging and carries no shape.
+	// Both polygons drop it together, so their shared edge stays twinned.
+	vector<uint32_t> degree(this->points.size(), 0);
+	vector<std::array<uint32_t, 2>> owners(this->points.size());
+	vector<uint64_t> remaining;
+	for (uint32_t i{0}; i < loops.size(); i++)
+	{
+		for (const uint32_t vert : loops[i])
+		{
+			owners[vert][std::min(degree[vert], 1U)] = i;
+			degree[vert]++;
+		}
+		remaining.push_back(loops[i].size());
+	}
+	vector<bool> redundant(this->points.size(), false);
+	for (const auto& loop : loops)
+	{
+		for (uint64_t i{0}; i < loop.size(); i++)
+		{
+			const uint32_t vert{loop[i]};
+			if (degree[vert] != 2 || redundant[vert])
+				continue;
+			const auto [loopA, loopB] = owners[vert];
+			if (remaining[loopA] <= 3 || remaining[loopB] <= 3)
+				continue;
+			const Vector3 prev{
+				this->points[loop[(i + loop.size() - 1) % loop.size()]]};
+			const Vector3 next{this->points[loop[(i + 1) % loop.size()]]};
+			const Vector3 pos{this->points[vert]};
+			const Vector3 cross{Vector3CrossProduct(
+				Vector3Normalize(pos - prev), Vector3Normalize(next - pos))};
+			if (Vector3Length(cross) <= maxSin)
+			{
+				redundant[vert] = true;
+				remaining[loopA]--;
+				remaining[loopB]--;
+			}
+		}
+	}
+
+	vector<uint32_t> remap(this->points.size(), NONE);
+	vertsOut.clear();
+	facesOut.clear();
+	facesOut.reserve(loops.size());
+	for (uint64_t i{0}; i < loops.size(); i++)
+	{
+		HE::FaceInit face{.normal = normals[i], .indices = {}};
+		face.indices.reserve(remaining[i]);
+		// HullCollider expects faces wound clockwise when seen from outside
+		for (const uint32_t vert : loops[i] | std::views::reverse)
+		{
+			if (redundant[vert])
+				continue;
+			if (remap[vert] == NONE)
+			{
+				remap[vert] = static_cast<uint32_t>(vertsOut.size());
+				const Vector3 pos{this->points[vert]};
+				vertsOut.push_back({.x = pos.x, .y = pos.y, .z = pos.z});
+			}
+			face.indices.push_back(remap[vert]);
+		}
+		facesOut.push_back(std::move(face));
+	}
+}
+
+} //namespace
+
+auto ComputeConvexHull(std::span<const Vector3> points,
+					   vector<HE::HVertex>& vertsOut,
+					   vector<HE::FaceInit>& facesOut,
+					   const HullSettings& settings) -> bool
+{
+	vertsOut.clear();
+	facesOut.clear();
+
+	// Welding snaps points to a grid and keeps one point per occupied cell.
+	// Sorting the cells keeps this cache friendly for large meshes.
+	vector<Vector3> welded;
+	if (settings.weldDistance > 0.0f)
+	{
+		using Cell = std::array<int64_t, 3>;
+		const float invCell{1.0f / settings.weldDistance};
+		vector<std::pair<Cell, uint32_t>> cells;
+		cells.reserve(points.size());
+		for (uint32_t i{0}; i < points.size(); i++)
+		{
+			cells.push_back({{
+								 static_cast<int64_t>(
+									 std::floor(points[i].x * invCell)),
+								 static_cast<int64_t>(
+									 std::floor(points[i].y * invCell)),
+								 static_cast<int64_t>(
+									 std::floor(points[i].z * invCell)),
+							 },
+							 i});
+		}
+		std::ranges::sort(cells);
+		welded.reserve(cells.size());
+		for (uint64_t i{0}; i < cells.size(); i++)
+		{
+			if (i == 0 || cells[i].first != cells[i - 1].first)
+				welded.push_back(points[cells[i].second]);
+		}
+	}
+	else
+	{
+		welded.assign(points.begin(), points.end());
+	}
+
+	float epsilon{settings.epsilon};
+	if (epsilon <= 0.0f)
+	{
+		Vector3 maxAbs{};
+		for (const auto point : welded)
+		{
+			maxAbs = Vector3Max(maxAbs, {std::abs(point.x), std::abs(point.y),
+										 std::abs(point.z)});
+		}
+		epsilon = 3.0f * FLT_EPSILON * (maxAbs.x + maxAbs.y + maxAbs.z);
+	}
+
+	QuickHull hull{welded, epsilon};
+	if (!hull.Build(settings.maxVertices))
+		return false;
+	// Exactly coplanar input still picks up rounding error, so merging is at
+	// least as tolerant as welding
+	hull.Extract(vertsOut, facesOut, settings.mergeAngle,
+				 std::max(epsilon, settings.weldDistance));
+	return true;
+}
+
+auto CreateHullCollider(const Mesh& mesh, const HullSettings& settings)
+	-> Collider
+{
+	vector<Vector3> points;
+	points.reserve(static_cast<uint64_t>(mesh.vertexCount));
+	for (uint64_t i{0}; i < static_cast<uint64_t>(mesh.vertexCount); i++)
+	{
+		points.emplace_back(mesh.vertices[(i * 3) + 0],
+							mesh.vertices[(i * 3) + 1],
+							mesh.vertices[(i * 3) + 2]);
+	}
+
+	vector<HE::HVertex> verts;
+	vector<HE::FaceInit> faces;
+	if (ComputeConvexHull(points, verts, faces, settings))
+	{
+		Vector3 centre{};
+		for (const auto& vert : verts)
+		{
+			centre = centre + vert.Vec();
+		}
+		centre = centre / static_cast<float>(verts.size());
+		HullCollider newCol{verts, faces, centre};
+		return {newCol};
+	}
+
+	// Flat or empty meshes get a thin box around their bounds instead
+	Vector3 min{std::numeric_limits<float>::max(),
+				std::numeric_limits<float>::max(),
+				std::numeric_limits<float>::max()};
+	Vector3 max{-min};
+	for (const auto point : points)
+	{
+		min = Vector3Min(min, point);
+		max = Vector3Max(max, point);
+	}
+	if (points.empty())
+	{
+		min = Vector3Zero();
+		max = Vector3Zero();
+	}
+	const float thickness{std::max(settings.weldDistance, 0.001f)};
+	Vector3 size{Vector3Max(max - min, {thickness, thickness, thickness})};
+	Vector3 centre{(min + max) / 2.0f};
+	return CreateBoxCollider(MatrixScale(size.x, size.y, size.z)
+							 * MatrixTranslate(centre.x, centre.y, centre.z));
+}
+
+} //namespace phys
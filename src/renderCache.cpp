@@ -0,0 +1,124 @@
+#include "renderCache.h"
+
+#include <cassert>
+#include <cstdint>
+#include <optional>
+#include <raylib.h>
+#include <string>
+#include <utility>
+
+namespace phys
+{
+
+auto RenderCache::AcquireMesh(const MeshShape shape, const Vector3 dims)
+	-> MeshID
+{
+	const MeshKey key{.shape = shape, .x = dims.x, .y = dims.y, .z = dims.z};
+	if (auto existing = this->meshKeys.find(key);
+		existing != this->meshKeys.end())
+	{
+		this->meshes[existing->second].refs++;
+		return existing->second;
+	}
+
+	const MeshID id{this->NewMeshEntry()};
+	MeshEntry& entry{this->meshes[id]};
+	// raylib's generators upload the meshes they make themselves
+	switch (shape)
+	{
+	case MeshShape::CUBE:
+		entry.mesh = GenMeshCube(dims.x, dims.y, dims.z);
+		break;
+	}
+	entry.refs = 1;
+	entry.key = key;
+	this->meshKeys.emplace(key, id);
+	return id;
+}
+auto RenderCache::AddMesh(Mesh mesh) -> MeshID
+{
+	if (mesh.vaoId == 0)
+	{
+		UploadMesh(&mesh, false);
+	}
+	const MeshID id{this->NewMeshEntry()};
+	this->meshes[id] = {.mesh = mesh, .refs = 1, .key = std::nullopt};
+	return id;
+}
+void RenderCache::ReleaseMesh(const MeshID id)
+{
+	MeshEntry& entry{this->meshes[id]};
+	assert(entry.refs > 0);
+	if (--entry.refs > 0)
+		return;
+
+	UnloadMesh(entry.mesh);
+	if (entry.key.has_value())
+	{
+		this->meshKeys.erase(*entry.key);
+	}
+	entry = {};
+	this->freeMeshes.push_back(id);
+}
+
+auto RenderCache::GetDefaultMaterial() -> MaterialID
+{
+	if (!this->defaultMaterial.has_value())
+	{
+		this->defaultMaterial = static_cast<MaterialID>(this->materials.size());
+		this->materials.push_back(LoadMaterialDefault());
+	}
+	return *this->defaultMaterial;
+}
+auto RenderCache::LoadMaterial(const char* vertShader, const char* fragShader)
+	-> MaterialID
+{
+	auto files{std::pair<std::string, std::string>{vertShader, fragShader}};
+	if (auto existing = this->shaderFiles.find(files);
+		existing != this->shaderFiles.end())
+		return existing->second;
+
+	Shader shader{LoadShader(vertShader, fragShader)};
+	// Leaves -1 for shaders without the attribute, which draw one at a time
+	shader.locs[SHADER_LOC_VERTEX_INSTANCE_TX]
+		= GetShaderLocationAttrib(shader, "instanceTransform");
+	const MaterialID id{this->NewMaterial(shader)};
+	this->shaderFiles.emplace(std::move(files), id);
+	return id;
+}
+auto RenderCache::AddMaterial(const Shader& shader) -> MaterialID
+{
+	for (MaterialID id{0}; id < this->materials.size(); id++)
+	{
+		if (this->materials[id].shader.id == shader.id)
+			return id;
+	}
+	return this->NewMaterial(shader);
+}
+
+auto RenderCache::NewMeshEntry() -> MeshID
+{
+	if (!this->freeMeshes.empty())
+	{
+		const MeshID id{this->freeMeshes.back()};
+		this->freeMeshes.pop_back();
+		return id;
+	}
+	this->meshes.emplace_back();
+	return static_cast<MeshID>(this->meshes.size() - 1);
+}
+auto RenderCache::NewMaterial(const Shader& shader) -> MaterialID
+{
+	Material material{LoadMaterialDefault()};
+	material.shader = shader;
+	this->materials.push_back(material);
+	return static_cast<MaterialID>(this->materials.size() - 1);
+}
+
+auto GetRenderCache() -> RenderCache&
+{
+	static RenderCache cache;
+	return cache;
+}
+
+} //namespace phys
@@ -0,0 +1,621 @@
+#include "solver.h"
+#include "bodyStorage.h"
+#include "frameArena.h"
+#include "integrate.h"
+#include "jobSystem.h"
+#include "lanes.h"
+#include "physObject.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <memory_resource>
+#include <numeric>
+#include <raylib.h>
+#include <raymath.h>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace phys
+{
+
+namespace
+{
+
+/** @brief Fraction of the penetration pushed out per step. */
+constexpr float BAUMGARTE{0.2f};
+/** @brief Penetration left alone, so resting contacts stay touching. */
+constexpr float SLOP{0.005f};
+/**
+ * @brief Colours available to an island, one per bit of a mask. Rows that
+ *        find none free go into an overflow colour solved one at a time.
+ */
+constexpr uint32_t MAX_COLOURS{64};
+/** @brief Islands with this many contacts spread each colour over threads. */
+constexpr uint32_t PARALLEL_ISLAND_CONTACTS{512};
+/** @brief Rows per job of a parallel colour, a multiple of every width. */
+constexpr uint32_t ROWS_PER_JOB{128};
+
+/** @brief A body's velocities, copied out of the BodyState to solve. */
+struct SolverBody
+{
+	Vector3 velocity;
+	Vector3 angularVelocity;
+	float inverseMass;
+	/** @brief The same about every axis, see ContactSolver. */
+	float inverseInertia;
+};
+
+/** @brief A vector per lane. */
+template <typename F>
+struct LaneVector3
+{
+	F x;
+	F y;
+	F z;
+
+	friend auto operator+(const LaneVector3 a, const LaneVector3 b)
+		-> LaneVector3
+	{
+		return {a.x + b.x, a.y + b.y, a.z + b.z};
+	}
+	friend auto operator-(const LaneVector3 a, const LaneVector3 b)
+		-> LaneVector3
+	{
+		return {a.x - b.x, a.y - b.y, a.z - b.z};
+	}
+	friend auto operator*(const LaneVector3 vec, const F scale) -> LaneVector3
+	{
+		return {vec.x * scale, vec.y * scale, vec.z * scale};
+	}
+};
+template <typename F>
+auto Dot(const LaneVector3<F> a, const LaneVector3<F> b) -> F
+{
+	return (a.x * b.x) + (a.y * b.y) + (a.z * b.z);
+}
+template <typename F>
+auto Cross(const LaneVector3<F> a, const LaneVector3<F> b) -> LaneVector3<F>
+{
+	return {(a.y * b.z) - (a.z * b.y), (a.z * b.x) - (a.x * b.z),
+			(a.x * b.y) - (a.y * b.x)};
+}
+
+/** @brief One array per component of a vector per row. */
+struct RowVectors
+{
+	std::pmr::vector<float> x;
+	std::pmr::vector<float> y;
+	std::pmr::vector<float> z;
+
+	RowVectors(const size_t count, std::pmr::memory_resource* memory)
+		: x(count, memory), y(count, memory), z(count, memory)
+	{ }
+
+	void Set(const uint32_t i, const Vector3 vec)
+	{
+		x[i] = vec.x;
+		y[i] = vec.y;
+		z[i] = vec.z;
+	}
+	/** @brief Rows i to i + L::WIDTH. */
+	template <typename L>
+	auto Load(const uint32_t i) const -> LaneVector3<typename L::Float>
+	{
+		return {L::Load(&x[i]), L::Load(&y[i]), L::Load(&z[i])};
+	}
+};
+
+/**
+ * @brief Contact points as one array per component, so SIMD lanes each
+ *        hold a row. Rows are sorted by colour, and no two rows of a colour
+ *        share a body, so any WIDTH of them can be solved side by side.
+ */
+struct RowArrays
+{
+	std::pmr::vector<uint32_t> bodies1;
+	std::pmr::vector<uint32_t> bodies2;
+	/** @brief From each body's origin to the point. */
+	RowVectors offsets1;
+	RowVectors offsets2;
+	RowVectors normals;
+	std::array<RowVectors, 2> tangents;
+	std::pmr::vector<float> normalMasses;
+	std::array<std::pmr::vector<float>, 2> tangentMasses;
+	/** @brief Separating speed that pushes the penetration out. */
+	std::pmr::vector<float> biases;
+	std::pmr::vector<float> normalImpulses;
+	std::array<std::pmr::vector<float>, 2> tangentImpulses;
+
+	RowArrays(const size_t count, std::pmr::memory_resource* memory)
+		: bodies1(count, memory), bodies2(count, memory),
+		  offsets1(count, memory), offsets2(count, memory),
+		  normals(count, memory),
+		  tangents{RowVectors{count, memory}, RowVectors{count, memory}},
+		  normalMasses(count, memory),
+		  tangentMasses{std::pmr::vector<float>(count, memory),
+						std::pmr::vector<float>(count, memory)},
+		  biases(count, memory), normalImpulses(count, memory),
+		  tangentImpulses{std::pmr::vector<float>(count, memory),
+						  std::pmr::vector<float>(count, memory)}
+	{ }
+};
+
+/** @brief The bodies of L::WIDTH rows, gathered into lanes. */
+template <typename L>
+struct BodyLanes
+{
+	using F = typename L::Float;
+
+	LaneVector3<F> velocity;
+	LaneVector3<F> angularVelocity;
+	F inverseMass;
+	F inverseInertia;
+
+	BodyLanes(const std::span<const SolverBody> bodies, const uint32_t* ids)
+	{
+		std::array<std::array<float, L::WIDTH>, 8> lanes{};
+		for (uint32_t lane{0}; lane < L::WIDTH; lane++)
+		{
+			const SolverBody& body{bodies[ids[lane]]};
+			lanes[0][lane] = body.velocity.x;
+			lanes[1][lane] = body.velocity.y;
+			lanes[2][lane] = body.velocity.z;
+			lanes[3][lane] = body.angularVelocity.x;
+			lanes[4][lane] = body.angularVelocity.y;
+			lanes[5][lane] = body.angularVelocity.z;
+			lanes[6][lane] = body.inverseMass;
+			lanes[7][lane] = body.inverseInertia;
+		}
+		this->velocity = {L::Load(lanes[0].data()), L::Load(lanes[1].data()),
+						  L::Load(lanes[2].data())};
+		this->angularVelocity = {L::Load(lanes[3].data()),
+								 L::Load(lanes[4].data()),
+								 L::Load(lanes[5].data())};
+		this->inverseMass = L::Load(lanes[6].data());
+		this->inverseInertia = L::Load(lanes[7].data());
+	}
+	/** @brief Writes the velocities back to the bodies they came from. */
+	void Scatter(const std::span<SolverBody> bodies, const uint32_t* ids) const
+	{
+		std::array<std::array<float, L::WIDTH>, 6> lanes{};
+		L::Store(lanes[0].data(), this->velocity.x);
+		L::Store(lanes[1].data(), this->velocity.y);
+		L::Store(lanes[2].data(), this->velocity.z);
+		L::Store(lanes[3].data(), this->angularVelocity.x);
+		L::Store(lanes[4].data(), this->angularVelocity.y);
+		L::Store(lanes[5].data(), this->angularVelocity.z);
+		for (uint32_t lane{0}; lane < L::WIDTH; lane++)
+		{
+			SolverBody& body{bodies[ids[lane]]};
+			body.velocity = {lanes[0][lane], lanes[1][lane], lanes[2][lane]};
+			body.angularVelocity = {lanes[3][lane], lanes[4][lane],
+									lanes[5][lane]};
+		}
+	}
+};
+
+/**
+ * @brief Runs one Gauss-Seidel pass over rows from first onwards, L::WIDTH
+ *        at a time, while a whole group still fits before last. Friction
+ *        goes first, limited by the last normal impulse.
+ * @returns The index of the first row that was not solved.
+ */
+template <typename L>
+auto SolveLanes(RowArrays& rows, const std::span<SolverBody> bodies,
+				const float friction, const uint32_t first,
+				const uint32_t last) -> uint32_t
+{
+	using F = typename L::Float;
+	using V = LaneVector3<F>;
+	const F coefficient{L::Splat(friction)};
+	const F zero{L::Splat(0.0f)};
+
+	uint32_t i{first};
+	for (; i + L::WIDTH <= last; i += L::WIDTH)
+	{
+		const uint32_t* ids1{&rows.bodies1[i]};
+		const uint32_t* ids2{&rows.bodies2[i]};
+		BodyLanes<L> body1{bodies, ids1};
+		BodyLanes<L> body2{bodies, ids2};
+		const V offset1{rows.offsets1.Load<L>(i)};
+		const V offset2{rows.offsets2.Load<L>(i)};
+		auto relative = [&body1, &body2, offset1, offset2]() -> V
+		{
+			return body2.velocity + Cross(body2.angularVelocity, offset2)
+				   - body1.velocity - Cross(body1.angularVelocity, offset1);
+		};
+		auto apply = [&body1, &body2, offset1, offset2](const V impulse) -> void
+		{
+			body1.velocity = body1.velocity - (impulse * body1.inverseMass);
+			body1.angularVelocity
+				= body1.angularVelocity
+				  - (Cross(offset1, impulse) * body1.inverseInertia);
+			body2.velocity = body2.velocity + (impulse * body2.inverseMass);
+			body2.angularVelocity
+				= body2.angularVelocity
+				  + (Cross(offset2, impulse) * body2.inverseInertia);
+		};
+
+		const F normalImpulse{L::Load(&rows.normalImpulses[i])};
+		const F maxFriction{coefficient * normalImpulse};
+		const F minFriction{zero - maxFriction};
+		for (uint32_t k{0}; k < 2; k++)
+		{
+			const V tangent{rows.tangents[k].Load<L>(i)};
+			const F speed{Dot(relative(), tangent)};
+			const F old{L::Load(&rows.tangentImpulses[k][i])};
+			const F impulse{L::Min(
+				L::Max(old - (speed * L::Load(&rows.tangentMasses[k][i])),
+					   minFriction),
+				maxFriction)};
+			apply(tangent * (impulse - old));
+			L::Store(&rows.tangentImpulses[k][i], impulse);
+		}
+		const V normal{rows.normals.Load<L>(i)};
+		const F speed{Dot(relative(), normal)};
+		const F impulse{
+			L::Max(normalImpulse
+					   + ((L::Load(&rows.biases[i]) - speed)
+						  * L::Load(&rows.normalMasses[i])),
+				   zero)};
+		apply(normal * (impulse - normalImpulse));
+		L::Store(&rows.normalImpulses[i], impulse);
+
+		body1.Scatter(bodies, ids1);
+		body2.Scatter(bodies, ids2);
+	}
+	return i;
+}
+/** @brief Solves rows first to last with the widest lanes kernel allows. */
+void SolveRows(const IntegrateKernel kernel, RowArrays& rows,
+			   const std::span<SolverBody> bodies, const float friction,
+			   const uint32_t first, const uint32_t last)
+{
+	uint32_t done{first};
+#ifdef PHYS_HAS_SSE2
+	if (kernel == IntegrateKernel::SSE2)
+	{
+		done = SolveLanes<SSE2Lanes>(rows, bodies, friction, first, last);
+	}
+#else
+	(void)kernel;
+#endif // PHYS_HAS_SSE2
+	SolveLanes<ScalarLanes>(rows, bodies, friction, done, last);
+}
+
+/** @returns The mass the pair resists an impulse along dir with. */
+auto GetEffectiveMass(const SolverBody& body1, const SolverBody& body2,
+					  const Vector3 offset1, const Vector3 offset2,
+					  const Vector3 dir) -> float
+{
+	const float inverse{
+		body1.inverseMass + body2.inverseMass
+		+ (body1.inverseInertia
+		   * Vector3LengthSqr(Vector3CrossProduct(offset1, dir)))
+		+ (body2.inverseInertia
+		   * Vector3LengthSqr(Vector3CrossProduct(offset2, dir)))};
+	return inverse > 0.0f ? 1.0f / inverse : 0.0f;
+}
+
+} //namespace
+
+void ContactSolver::AddContact(const HitObj& hit)
+{
+	if (hit.IsSensor)
+		return;
+	Contact& contact{this->contacts.emplace_back()};
+	contact.handle1 = hit.ThisCol.GetHandle();
+	contact.handle2 = hit.OtherCol.GetHandle();
+	contact.normal = hit.Normal;
+	contact.depth = hit.Penetration;
+	contact.points = hit.Points;
+	contact.pointCount = hit.PointCount;
+	if (contact.pointCount == 0)
+	{
+		contact.points[0] = hit.HitPos;
+		contact.pointCount = 1;
+	}
+}
+void ContactSolver::Solve(BodyStorage& bodies, const float deltaTime,
+						  JobSystem* jobs)
+{
+	this->islands.clear();
+	if (this->contacts.empty() || deltaTime <= 0.0f)
+		return;
+	this->BuildIslands(bodies);
+	BodyState& state{bodies.state};
+	// Islands are sorted largest first, so the ones big enough to share out
+	// lead. Each has every thread to itself, one colour at a time.
+	uint32_t shared{0};
+	for (; shared < this->islands.size()
+		   && this->islands[shared].contactCount >= PARALLEL_ISLAND_CONTACTS;
+		 shared++)
+	{
+		this->SolveIsland(state, this->islands[shared], deltaTime, jobs);
+	}
+	auto solve = [this, &state, deltaTime, shared](const uint32_t i) -> void
+	{
+		this->SolveIsland(state, this->islands[shared + i], deltaTime, nullptr);
+	};
+	const auto rest{static_cast<uint32_t>(this->islands.size()) - shared};
+	if (jobs == nullptr)
+	{
+		for (uint32_t i{0}; i < rest; i++)
+		{
+			solve(i);
+		}
+		return;
+	}
+	jobs->ParallelFor(rest, solve);
+}
+
+void ContactSolver::BuildIslands(const BodyStorage& bodies)
+{
+	const uint32_t moving{bodies.MovingCount()};
+	const vector<float>& inverseMasses{bodies.state.inverseMasses};
+	auto isDynamic = [moving, &inverseMasses](const BodyID id) -> bool
+	{
+		return id < moving && inverseMasses[id] > 0.0f;
+	};
+
+	// Join the dynamic bodies of each contact, always under the lower root
+	this->parents.resize(moving);
+	std::iota(this->parents.begin(), this->parents.end(), 0U);
+	for (Contact& contact : this->contacts)
+	{
+		contact.body1 = bodies.GetIndex(contact.handle1);
+		contact.body2 = bodies.GetIndex(contact.handle2);
+		if (isDynamic(contact.body1) && isDynamic(contact.body2))
+		{
+			const BodyID root1{this->FindRoot(contact.body1)};
+			const BodyID root2{this->FindRoot(contact.body2)};
+			this->parents[std::max(root1, root2)] = std::min(root1, root2);
+		}
+	}
+
+	// Number the islands in the order their first contact was added
+	this->rootIslands.assign(moving, NO_ISLAND);
+	for (Contact& contact : this->contacts)
+	{
+		contact.island = NO_ISLAND;
+		const BodyID body{isDynamic(contact.body1) ? contact.body1
+												   : contact.body2};
+		// Kinematic bodies touching static or kinematic ones
+		if (!isDynamic(body))
+			continue;
+		uint32_t& island{this->rootIslands[this->FindRoot(body)]};
+		if (island == NO_ISLAND)
+		{
+			island = static_cast<uint32_t>(this->islands.size());
+			this->islands.push_back({});
+		}
+		contact.island = island;
+		this->islands[island].contactCount++;
+	}
+	// Only bodies with a contact have a root that is in an island
+	this->localIndices.resize(moving);
+	for (BodyID id{0}; id < moving; id++)
+	{
+		if (isDynamic(id))
+		{
+			const uint32_t island{this->rootIslands[this->FindRoot(id)]};
+			if (island != NO_ISLAND)
+			{
+				this->islands[island].bodyCount++;
+			}
+		}
+	}
+
+	uint32_t contactOffset{0};
+	uint32_t bodyOffset{0};
+	for (Island& island : this->islands)
+	{
+		island.contactOffset = contactOffset;
+		island.bodyOffset = bodyOffset;
+		contactOffset += island.contactCount;
+		bodyOffset += island.bodyCount;
+		// Counted up again as each island is filled in
+		island.contactCount = 0;
+		island.bodyCount = 0;
+	}
+	this->islandContacts.resize(contactOffset);
+	this->islandBodies.resize(bodyOffset);
+	for (uint32_t i{0}; i < this->contacts.size(); i++)
+	{
+		const uint32_t index{this->contacts[i].island};
+		if (index != NO_ISLAND)
+		{
+			Island& island{this->islands[index]};
+			this->islandContacts[island.contactOffset + island.contactCount++]
+				= i;
+		}
+	}
+	for (BodyID id{0}; id < moving; id++)
+	{
+		if (!isDynamic(id))
+			continue;
+		const uint32_t index{this->rootIslands[this->FindRoot(id)]};
+		if (index != NO_ISLAND)
+		{
+			Island& island{this->islands[index]};
+			this->localIndices[id] = island.bodyCount;
+			this->islandBodies[island.bodyOffset + island.bodyCount++] = id;
+		}
+	}
+
+	// The order is only a schedule, each island's result does not depend on it
+	std::ranges::stable_sort(this->islands, std::ranges::greater{},
+							 &Island::contactCount);
+}
+auto ContactSolver::FindRoot(BodyID id) -> BodyID
+{
+	while (this->parents[id] != id)
+	{
+		this->parents[id] = this->parents[this->parents[id]];
+		id = this->parents[id];
+	}
+	return id;
+}
+
+void ContactSolver::SolveIsland(BodyState& state, const Island& island,
+								const float deltaTime, JobSystem* jobs) const
+{
+	FrameArena& arena{GetFrameArena()};
+	const uint32_t moving{static_cast<uint32_t>(this->localIndices.size())};
+	auto load = [&state](const BodyID id) -> SolverBody
+	{
+		const float inverseMass{state.inverseMasses[id]};
+		// A solid box filling the bounds, averaged over the three axes
+		const Vector3 extents{state.localExtents.Get(id)
+							  * state.scales.Get(id)};
+		const float extentSqr{Vector3LengthSqr(extents)};
+		return {.velocity = state.velocities.Get(id),
+				.angularVelocity = state.angularVelocities.Get(id),
+				.inverseMass = inverseMass,
+				.inverseInertia = extentSqr > 0.0f
+									  ? 4.5f * inverseMass / extentSqr
+									  : 0.0f};
+	};
+
+	const std::span<const BodyID> ids{
+		this->islandBodies.data() + island.bodyOffset, island.bodyCount};
+	std::pmr::vector<SolverBody> bodies{&arena};
+	bodies.reserve(island.bodyCount);
+	for (const BodyID id : ids)
+	{
+		bodies.push_back(load(id));
+	}
+	// Static and kinematic bodies get a copy per contact that is never
+	// written back, as other islands may be reading them too
+	auto getLocal = [this, &state, &bodies, &load,
+					 moving](const BodyID id) -> uint32_t
+	{
+		if (id < moving && state.inverseMasses[id] > 0.0f)
+			return this->localIndices[id];
+		SolverBody body{load(id)};
+		body.inverseMass = 0.0f;
+		body.inverseInertia = 0.0f;
+		bodies.push_back(body);
+		return static_cast<uint32_t>(bodies.size() - 1);
+	};
+	auto getContact = [this, &island](const uint32_t i) -> const Contact&
+	{
+		return this->contacts[this->islandContacts[island.contactOffset + i]];
+	};
+
+	// Greedy colouring in contact order. The copies above count as bodies
+	// too, so the points of a contact never share a colour.
+	std::pmr::vector<std::pair<uint32_t, uint32_t>> pairs{&arena};
+	pairs.reserve(island.contactCount);
+	std::pmr::vector<uint32_t> colours{&arena};
+	for (uint32_t i{0}; i < island.contactCount; i++)
+	{
+		pairs.emplace_back(getLocal(getContact(i).body1),
+						   getLocal(getContact(i).body2));
+	}
+	std::pmr::vector<uint64_t> used(bodies.size(), 0, &arena);
+	std::array<uint32_t, MAX_COLOURS + 2> colourStarts{};
+	for (uint32_t i{0}; i < island.contactCount; i++)
+	{
+		const auto [body1, body2] = pairs[i];
+		for (uint32_t j{0}; j < getContact(i).pointCount; j++)
+		{
+			const uint64_t free{~(used[body1] | used[body2])};
+			const auto colour{static_cast<uint32_t>(std::countr_zero(free))};
+			if (colour < MAX_COLOURS)
+			{
+				used[body1] |= uint64_t{1} << colour;
+				used[body2] |= uint64_t{1} << colour;
+			}
+			colours.push_back(colour);
+			colourStarts[colour + 1]++;
+		}
+	}
+	std::partial_sum(colourStarts.begin(), colourStarts.end(),
+					 colourStarts.begin());
+
+	const auto rowCount{static_cast<uint32_t>(colours.size())};
+	RowArrays rows{rowCount, &arena};
+	std::array<uint32_t, MAX_COLOURS + 1> next{};
+	std::copy_n(colourStarts.begin(), next.size(), next.begin());
+	uint32_t source{0};
+	for (uint32_t i{0}; i < island.contactCount; i++)
+	{
+		const Contact& contact{getContact(i)};
+		const auto [body1, body2] = pairs[i];
+		const Vector3 origin1{state.positions.Get(contact.body1)};
+		const Vector3 origin2{state.positions.Get(contact.body2)};
+		const Vector3 tangent{
+			Vector3Normalize(Vector3Perpendicular(contact.normal))};
+		const std::array<Vector3, 2> tangents{
+			tangent, Vector3CrossProduct(contact.normal, tangent)};
+		const float bias{BAUMGARTE / deltaTime
+						 * std::max(contact.depth - SLOP, 0.0f)};
+		for (uint32_t j{0}; j < contact.pointCount; j++)
+		{
+			const uint32_t row{next[colours[source++]]++};
+			const Vector3 offset1{contact.points[j] - origin1};
+			const Vector3 offset2{contact.points[j] - origin2};
+			rows.bodies1[row] = body1;
+			rows.bodies2[row] = body2;
+			rows.offsets1.Set(row, offset1);
+			rows.offsets2.Set(row, offset2);
+			rows.normals.Set(row, contact.normal);
+			rows.normalMasses[row]
+				= GetEffectiveMass(bodies[body1], bodies[body2], offset1,
+								   offset2, contact.normal);
+			for (uint32_t k{0}; k < 2; k++)
+			{
+				rows.tangents[k].Set(row, tangents[k]);
+				rows.tangentMasses[k][row]
+					= GetEffectiveMass(bodies[body1], bodies[body2], offset1,
+									   offset2, tangents[k]);
+			}
+			rows.biases[row] = bias;
+		}
+	}
+
+	const std::span<SolverBody> solverBodies{bodies};
+	const IntegrateKernel lanes{this->kernel};
+	const float coefficient{this->friction};
+	for (uint32_t iteration{0}; iteration < this->iterations; iteration++)
+	{
+		// Colours in turn, as each one reads what the last one wrote
+		for (uint32_t colour{0}; colour < MAX_COLOURS; colour++)
+		{
+			const uint32_t first{colourStarts[colour]};
+			const uint32_t count{colourStarts[colour + 1] - first};
+			if (jobs == nullptr || count <= ROWS_PER_JOB)
+			{
+				SolveRows(lanes, rows, solverBodies, coefficient, first,
+						  first + count);
+				continue;
+			}
+			jobs->ParallelFor(
+				(count + ROWS_PER_JOB - 1) / ROWS_PER_JOB,
+				[lanes, &rows, solverBodies, coefficient, first,
+				 count](const uint32_t job) -> void
+				{
+					const uint32_t begin{first + (job * ROWS_PER_JOB)};
+					const uint32_t end{
+						std::min(begin + ROWS_PER_JOB, first + count)};
+					SolveRows(lanes, rows, solverBodies, coefficient, begin,
+							  end);
+				});
+		}
+		// Overflow rows may share bodies, so they go one at a time
+		SolveLanes<ScalarLanes>(rows, solverBodies, coefficient,
+								colourStarts[MAX_COLOURS], rowCount);
+	}
+
+	for (uint32_t i{0}; i < island.bodyCount; i++)
+	{
+		state.velocities.Set(ids[i], bodies[i].velocity);
+		state.angularVelocities.Set(ids[i], bodies[i].angularVelocity);
+	}
+}
+
+} //namespace phys
@@ -0,0 +1,466 @@
+#include "collider.h"
+#include "colliderCache.h"
+#include "debugDraw.h"
+#include "frameArena.h"
+#include "primitiveTests.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <raylib.h>
+#include <raymath.h>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace phys
+{
+
+using std::optional;
+using std::vector;
+
+namespace
+{
+
+/** @brief Squared lengths below this are treated as zero. */
+constexpr float TINY{1e-12f};
+/** @brief Neighbours whose normals agree this closely are coplanar. */
+constexpr float FLAT_COSINE{0.9999f};
+constexpr float QUANTISED_MAX{65535.0f};
+
+auto GetTriangleBounds(const vector<Vector3>& vertices,
+					   const TriangleIndices& tri) -> BoundingBox
+{
+	const Vector3 a{vertices[tri.verts[0]]};
+	const Vector3 b{vertices[tri.verts[1]]};
+	const Vector3 c{vertices[tri.verts[2]]};
+	return {.min = Vector3Min(a, Vector3Min(b, c)),
+			.max = Vector3Max(a, Vector3Max(b, c))};
+}
+/** @returns How far each unit of the mesh bounds spans in node space. */
+auto GetQuantiseScale(const BoundingBox& bounds) -> Vector3
+{
+	const Vector3 size{bounds.max - bounds.min};
+	return {QUANTISED_MAX / std::max(size.x, TINY),
+			QUANTISED_MAX / std::max(size.y, TINY),
+			QUANTISED_MAX / std::max(size.z, TINY)};
+}
+/**
+ * @brief Fills in the node subtree over count triangles from first, sorting
+ *        them as it goes.
+ */
+void BuildNode(TriangleMeshGeometry& geometry, const uint32_t first,
+			   const uint32_t count)
+{
+	const auto nodeID{static_cast<uint32_t>(geometry.nodes.size())};
+	geometry.nodes.emplace_back();
+	const std::span tris{geometry.triangles.data() + first, count};
+	const auto getCentre = [&geometry](const TriangleIndices& tri) -> Vector3
+	{
+		const BoundingBox box{GetTriangleBounds(geometry.vertices, tri)};
+		return (box.min + box.max) * 0.5f;
+	};
+
+	BoundingBox bounds{GetTriangleBounds(geometry.vertices, tris.front())};
+	const Vector3 firstCentre{getCentre(tris.front())};
+	BoundingBox centres{.min = firstCentre, .max = firstCentre};
+	for (const auto& tri : tris.subspan(1))
+	{
+		const Vector3 centre{getCentre(tri)};
+		bounds = MergeBounds(bounds, GetTriangleBounds(geometry.vertices, tri));
+		centres = MergeBounds(centres, {.min = centre, .max = centre});
+	}
+	QuantisedNode node{geometry.Quantise(bounds)};
+	if (count <= TriangleMeshGeometry::MAX_LEAF_TRIANGLES)
+	{
+		node.data = (first << QuantisedNode::COUNT_BITS) | count;
+		geometry.nodes[nodeID] = node;
+		return;
+	}
+
+	// Split at the median centre along the axis the centres spread most on
+	const Vector3 spread{centres.max - centres.min};
+	const uint32_t axis{spread.x >= spread.y && spread.x >= spread.z ? 0U
+						: spread.y >= spread.z						 ? 1U
+																	 : 2U};
+	const uint32_t half{count / 2};
+	std::ranges::nth_element(
+		tris, tris.begin() + half, {},
+		[&getCentre, axis](const TriangleIndices& tri) -> float
+		{
+			const Vector3 centre{getCentre(tri)};
+			return std::array{centre.x, centre.y, centre.z}[axis];
+		});
+	BuildNode(geometry, first, half);
+	node.data = static_cast<uint32_t>(geometry.nodes.size())
+				<< QuantisedNode::COUNT_BITS;
+	BuildNode(geometry, first + half, count - half);
+	geometry.nodes[nodeID] = node;
+}
+
+} //namespace
+
+auto MeshTriangle::GetSupportPoint(const Vector3 axis) const -> Vector3
+{
+	return *std::ranges::max_element(
+		this->verts, {}, [axis](const Vector3 vert) -> float
+		{ return Vector3DotProduct(vert, axis); });
+}
+
+auto TriangleMeshGeometry::Quantise(const BoundingBox& box) const
+	-> QuantisedNode
+{
+	const Vector3 scale{GetQuantiseScale(this->bounds)};
+	const Vector3 low{(box.min - this->bounds.min) * scale};
+	const Vector3 high{(box.max - this->bounds.min) * scale};
+	const auto toInt = [](const float val) -> uint16_t
+	{ return static_cast<uint16_t>(std::clamp(val, 0.0f, QUANTISED_MAX)); };
+	return {
+		.min = {toInt(std::floor(low.x)), toInt(std::floor(low.y)),
+				toInt(std::floor(low.z))},
+		.max = {toInt(std::ceil(high.x)), toInt(std::ceil(high.y)),
+				toInt(std::ceil(high.z))},
+		.data = 0,
+	};
+}
+auto TriangleMeshGeometry::Dequantise(const QuantisedNode& node) const
+	-> BoundingBox
+{
+	const Vector3 scale{GetQuantiseScale(this->bounds)};
+	const auto toVec = [](const std::array<uint16_t, 3>& vec) -> Vector3
+	{
+		return {static_cast<float>(vec[0]), static_cast<float>(vec[1]),
+				static_cast<float>(vec[2])};
+	};
+	return {.min = this->bounds.min + (toVec(node.min) / scale),
+			.max = this->bounds.min + (toVec(node.max) / scale)};
+}
+void TriangleMeshGeometry::BuildTree()
+{
+	this->nodes.clear();
+	if (this->triangles.empty())
+		return;
+	this->bounds = GetTriangleBounds(this->vertices, this->triangles.front());
+	for (const auto& tri : this->triangles)
+	{
+		this->bounds
+			= MergeBounds(this->bounds, GetTriangleBounds(this->vertices, tri));
+	}
+	// A leaf holds at least one triangle, so there are at most 2n - 1 nodes
+	this->nodes.reserve((this->triangles.size() * 2) - 1);
+	BuildNode(*this, 0, static_cast<uint32_t>(this->triangles.size()));
+}
+void TriangleMeshGeometry::FindActiveFeatures()
+{
+	// Every edge, keyed by its vertex indices with the lower one first, along
+	// with which triangle and which of its edges it is
+	vector<std::pair<uint64_t, uint32_t>> edges;
+	edges.reserve(this->triangles.size() * 3);
+	for (uint32_t i{0}; i < this->triangles.size(); i++)
+	{
+		const auto& verts = this->triangles[i].verts;
+		for (uint32_t j{0}; j < 3; j++)
+		{
+			const auto [low, high] = std::minmax(verts[j], verts[(j + 1) % 3]);
+			edges.emplace_back((static_cast<uint64_t>(low) << 32U) | high,
+							   (i * 3) + j);
+		}
+		// Edges are convex until a neighbour says otherwise
+		this->triangles[i].activeFeatures = MESH_EDGE_0 | MESH_EDGE_1
+										 | MESH_EDGE_2;
+	}
+	std::ranges::sort(edges);
+
+	const auto getNormal = [this](const TriangleIndices& tri) -> Vector3
+	{
+		const Vector3 a{this->vertices[tri.verts[0]]};
+		return Vector3Normalize(
+			Vector3CrossProduct(this->vertices[tri.verts[1]] - a,
+								this->vertices[tri.verts[2]] - a));
+	};
+	// Clears the edge's bit if the other triangle makes it flat or concave
+	const auto judgeEdge = [this, &getNormal](const uint32_t edge,
+											  const uint32_t otherEdge) -> void
+	{
+		TriangleIndices& tri{this->triangles[edge / 3]};
+		const TriangleIndices& other{this->triangles[otherEdge / 3]};
+		const Vector3 normal{getNormal(tri)};
+		const Vector3 opposite{
+			this->vertices[other.verts[((otherEdge % 3) + 2) % 3]]};
+		const bool flat{std::fabs(Vector3DotProduct(normal, getNormal(other)))
+						>= FLAT_COSINE};
+		const bool concave{
+			Vector3DotProduct(normal,
+							  opposite - this->vertices[tri.verts[edge % 3]])
+			> 0.0f};
+		if (flat || concave)
+		{
+			tri.activeFeatures &= ~(1U << (edge % 3));
+		}
+	};
+	for (uint32_t i{0}; i < edges.size();)
+	{
+		uint32_t end{i + 1};
+		while (end < edges.size() && edges[end].first == edges[i].first)
+		{
+			end++;
+		}
+		// Edges shared by more than two triangles are left convex
+		if (end - i == 2)
+		{
+			judgeEdge(edges[i].second, edges[i + 1].second);
+			judgeEdge(edges[i + 1].second, edges[i].second);
+		}
+		i = end;
+	}
+
+	vector<bool> activeVerts(this->vertices.size(), false);
+	for (const auto& tri : this->triangles)
+	{
+		for (uint32_t j{0}; j < 3; j++)
+		{
+			if ((tri.activeFeatures & (1U << j)) != 0)
+			{
+				activeVerts[tri.verts[j]] = true;
+				activeVerts[tri.verts[(j + 1) % 3]] = true;
+			}
+		}
+	}
+	for (auto& tri : this->triangles)
+	{
+		for (uint32_t j{0}; j < 3; j++)
+		{
+			if (activeVerts[tri.verts[j]])
+			{
+				tri.activeFeatures |= MESH_VERTEX_0 << j;
+			}
+		}
+	}
+}
+
+TriangleMeshCollider::TriangleMeshCollider(std::span<const Vector3> vertices,
+										   std::span<const uint32_t> indices)
+{
+	auto geometry{std::make_shared<TriangleMeshGeometry>()};
+	geometry->vertices.assign(vertices.begin(), vertices.end());
+	geometry->triangles.reserve(indices.size() / 3);
+	for (uint32_t i{0}; i + 2 < indices.size(); i += 3)
+	{
+		const TriangleIndices tri{
+			.verts = {indices[i], indices[i + 1], indices[i + 2]},
+			.activeFeatures = 0};
+		// Slivers have no normal to collide with
+		const Vector3 a{vertices[tri.verts[0]]};
+		const Vector3 cross{Vector3CrossProduct(vertices[tri.verts[1]] - a,
+												vertices[tri.verts[2]] - a)};
+		if (Vector3DotProduct(cross, cross) > TINY)
+		{
+			geometry->triangles.push_back(tri);
+		}
+	}
+	geometry->FindActiveFeatures();
+	geometry->BuildTree();
+	this->geometry = std::move(geometry);
+}
+TriangleMeshCollider::TriangleMeshCollider(const MeshView& view)
+{
+	auto geometry{std::make_shared<TriangleMeshGeometry>()};
+	geometry->vertices.assign(view.vertices.begin(), view.vertices.end());
+	geometry->triangles.assign(view.triangles.begin(), view.triangles.end());
+	geometry->nodes.assign(view.nodes.begin(), view.nodes.end());
+	geometry->bounds = view.bounds;
+	this->geometry = std::move(geometry);
+	this->transform = view.transform;
+	this->inverseTransform = MatrixInvert(view.transform);
+}
+
+auto TriangleMeshCollider::GetOrigin() const -> Vector3
+{
+	const BoundingBox& bounds{this->geometry->bounds};
+	return ((bounds.min + bounds.max) * 0.5f) * this->transform;
+}
+void TriangleMeshCollider::GetTransformed(
+	const Matrix trans, std::pmr::vector<Collider>& out) const
+{
+	TriangleMeshCollider copy{*this};
+	copy.transform = this->transform * trans;
+	copy.inverseTransform = MatrixInvert(copy.transform);
+	out.emplace_back(std::move(copy));
+}
+auto TriangleMeshCollider::GetSupportPoint(const Vector3 axis) const -> Vector3
+{
+	const auto& vertices = this->geometry->vertices;
+	if (vertices.empty())
+		return this->GetOrigin();
+	return *std::ranges::max_element(
+			   vertices, {}, [this, axis](const Vector3 vert) -> float
+			   { return Vector3DotProduct(vert * this->transform, axis); })
+		   * this->transform;
+}
+auto TriangleMeshCollider::GetBounds() const -> BoundingBox
+{
+	return TransformBounds(this->geometry->bounds, this->transform);
+}
+auto TriangleMeshCollider::GetTriangle(const uint32_t i) const -> MeshTriangle
+{
+	const TriangleIndices& tri{this->geometry->triangles[i]};
+	const auto& vertices = this->geometry->vertices;
+	MeshTriangle out{
+		.verts = {vertices[tri.verts[0]] * this->transform,
+				  vertices[tri.verts[1]] * this->transform,
+				  vertices[tri.verts[2]] * this->transform},
+		.normal = {},
+		.activeFeatures = static_cast<uint8_t>(tri.activeFeatures)};
+	out.normal = Vector3Normalize(Vector3CrossProduct(
+		out.verts[1] - out.verts[0], out.verts[2] - out.verts[0]));
+	return out;
+}
+void TriangleMeshCollider::GetOverlaps(const BoundingBox& box,
+									   std::pmr::vector<uint32_t>& out) const
+{
+	const TriangleMeshGeometry& geometry{*this->geometry};
+	const BoundingBox local{TransformBounds(box, this->inverseTransform)};
+	if (geometry.nodes.empty() || !CheckCollisionBoxes(local, geometry.bounds))
+		return;
+	const QuantisedNode query{geometry.Quantise(local)};
+	const auto overlaps = [&query](const QuantisedNode& node) -> bool
+	{
+		for (uint32_t axis{0}; axis < 3; axis++)
+		{
+			if (node.min[axis] > query.max[axis]
+				|| node.max[axis] < query.min[axis])
+				return false;
+		}
+		return true;
+	};
+
+	std::pmr::vector<uint32_t> stack{{0}, out.get_allocator()};
+	while (!stack.empty())
+	{
+		const QuantisedNode& node{geometry.nodes[stack.back()]};
+		const uint32_t nodeID{stack.back()};
+		stack.pop_back();
+		if (!overlaps(node))
+			continue;
+		if (node.IsLeaf())
+		{
+			for (uint32_t i{0}; i < node.Count(); i++)
+			{
+				out.push_back(node.Index() + i);
+			}
+			continue;
+		}
+		stack.push_back(node.Index());
+		stack.push_back(nodeID + 1);
+	}
+}
+auto TriangleMeshCollider::Raycast(const Ray ray) const -> optional<float>
+{
+	const TriangleMeshGeometry& geometry{*this->geometry};
+	if (geometry.nodes.empty())
+		return std::nullopt;
+	const Ray local{GetLocalRay(ray, this->inverseTransform)};
+	const Vector3 invDir{GetInverseDir(local.direction)};
+
+	optional<float> best;
+	std::pmr::vector<uint32_t> stack{&GetFrameArena()};
+	stack.push_back(0);
+	while (!stack.empty())
+	{
+		const uint32_t nodeID{stack.back()};
+		const QuantisedNode& node{geometry.nodes[nodeID]};
+		stack.pop_back();
+		if (!RaycastBounds(local.position, invDir, geometry.Dequantise(node),
+						   best.value_or(std::numeric_limits<float>::max())))
+			continue;
+		if (!node.IsLeaf())
+		{
+			stack.push_back(node.Index());
+			stack.push_back(nodeID + 1);
+			continue;
+		}
+		for (uint32_t i{node.Index()}; i < node.Index() + node.Count(); i++)
+		{
+			const auto& verts = geometry.triangles[i].verts;
+			const auto dist{RaycastTriangle(local,
+											{geometry.vertices[verts[0]],
+											 geometry.vertices[verts[1]],
+											 geometry.vertices[verts[2]]})};
+			if (dist.has_value() && (!best.has_value() || *dist < *best))
+			{
+				best = dist;
+			}
+		}
+	}
+	return best;
+}
+void TriangleMeshCollider::DebugDraw(const Matrix& transform,
+									 const Color& col) const
+{
+	if (!IsDebugDrawEnabled(DEBUG_HULLS))
+		return;
+	const Matrix trans{this->transform * transform};
+	const auto& vertices = this->geometry->vertices;
+	for (const auto& tri : this->geometry->triangles)
+	{
+		const std::array<Vector3, 3> verts{vertices[tri.verts[0]] * trans,
+										   vertices[tri.verts[1]] * trans,
+										   vertices[tri.verts[2]] * trans};
+		for (uint32_t i{0}; i < 3; i++)
+		{
+			DebugLine(DEBUG_HULLS, verts[i], verts[(i + 1) % 3], col);
+		}
+	}
+}
+
+auto CreateMeshCollider(const Mesh& mesh) -> Collider
+{
+	const auto vertexCount{static_cast<uint32_t>(mesh.vertexCount)};
+	const auto indexCount{mesh.indices != nullptr
+							  ? static_cast<uint32_t>(mesh.triangleCount * 3)
+							  : vertexCount};
+	// Weld by exact position, which is how exporters duplicate vertices
+	// across faces with different normals or texture coordinates
+	const auto hashVec = [](const Vector3 vec) -> size_t
+	{
+		const auto bits = [](const float val) -> uint64_t
+		{ return std::bit_cast<uint32_t>(val == 0.0f ? 0.0f : val); };
+		return std::hash<uint64_t>{}(
+			(bits(vec.x) * 0x9e3779b97f4a7c15) ^ (bits(vec.y) << 21U)
+			^ (bits(vec.z) * 0xbf58476d1ce4e5b9));
+	};
+	const auto equal = [](const Vector3 a, const Vector3 b) -> bool
+	{ return a.x == b.x && a.y == b.y && a.z == b.z; };
+	std::unordered_map<Vector3, uint32_t, decltype(hashVec), decltype(equal)>
+		welded(vertexCount, hashVec, equal);
+	vector<Vector3> vertices;
+	vector<uint32_t> remap(vertexCount);
+	for (uint32_t i{0}; i < vertexCount; i++)
+	{
+		const Vector3 vert{mesh.vertices[i * 3], mesh.vertices[(i * 3) + 1],
+						   mesh.vertices[(i * 3) + 2]};
+		const auto [found, added] = welded.try_emplace(
+			vert, static_cast<uint32_t>(vertices.size()));
+		if (added)
+		{
+			vertices.push_back(vert);
+		}
+		remap[i] = found->second;
+	}
+	vector<uint32_t> indices(indexCount);
+	for (uint32_t i{0}; i < indexCount; i++)
+	{
+		indices[i] = remap[mesh.indices != nullptr ? mesh.indices[i] : i];
+	}
+	return TriangleMeshCollider{vertices, indices};
+}
+
+} //namespace phys
@@ -0,0 +1,74 @@
+#include "world.h"
+#include "bodyStorage.h"
+#include "contactEvents.h"
+#include "debugDraw.h"
+#include "frameArena.h"
+#include "jobSystem.h"
+#include "physObject.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace phys
+{
+
+void World::Step(const float deltaTime, JobSystem* jobs)
+{
+	this->bodies.Integrate(deltaTime, this->gravity);
+	this->pairs.clear();
+	this->bodies.GetOverlappingPairs(this->pairs);
+	this->contacts.BeginStep();
+	this->solver.BeginStep();
+	for (const auto& [handle1, handle2] : this->pairs)
+	{
+		const PhysObject obj1{this->bodies, handle1};
+		const PhysObject obj2{this->bodies, handle2};
+		const std::optional<HitObj> hit{CheckCollision(obj1, obj2)};
+		if (hit.has_value())
+		{
+			this->contacts.AddContact(*hit);
+			this->solver.AddContact(*hit);
+		}
+	}
+	this->contacts.EndStep();
+	this->solver.Solve(this->bodies, deltaTime, jobs);
+}
+
+auto BatchStep(const std::span<World> worlds, const float deltaTime,
+			   JobSystem& jobs) -> BatchStats
+{
+	const auto start{std::chrono::steady_clock::now()};
+	BatchStats stats{.worldCount = static_cast<uint32_t>(worlds.size())};
+	// The busiest worlds go first, so none of them is left for last
+	vector<uint32_t> order(worlds.size());
+	std::iota(order.begin(), order.end(), 0U);
+	std::ranges::stable_sort(order, std::ranges::greater{},
+							 [worlds](const uint32_t i) -> uint32_t
+							 {
+								 return worlds[i].GetBodies().MovingCount();
+							 });
+	for (const World& world : worlds)
+	{
+		stats.bodySteps += world.GetBodies().MovingCount();
+	}
+
+	jobs.Run(order,
+			 [worlds, deltaTime](const uint32_t i) -> void
+			 {
+				 // Nothing submits the workers' buffers, they would only grow
+				 [[maybe_unused]] const DebugDrawPause pause;
+				 worlds[i].Step(deltaTime, nullptr);
+				 GetFrameArena().Reset();
+			 });
+	stats.seconds = std::chrono::duration<double>(
+						std::chrono::steady_clock::now() - start)
+						.count();
+	return stats;
+}
+
+} //namespace phys